@@ -636,11 +636,21 @@ ComponentModelColliderItem::ComponentModelColliderItem(Collider* collider, bool
     std::function<void(ComponentValue)> staticCallback = [&](ComponentValue v) { m_collider->SetStatic(v.b); };
     AddGenericParam("IsStatic", ComponentParameter::TYPE_BOOL, staticValue, staticCallback);
 
+    // Trigger parameter
+    ComponentValue triggerValue = ComponentValue(ComponentParameter::TYPE_BOOL, m_collider->IsTrigger());
+    std::function<void(ComponentValue)> triggerCallback = [&](ComponentValue v) { m_collider->SetTrigger(v.b); };
+    AddGenericParam("IsTrigger", ComponentParameter::TYPE_BOOL, triggerValue, triggerCallback);
+
     // Center parameter
     ComponentValue centerValue = ComponentValue(ComponentParameter::TYPE_VECTOR3, m_collider->GetCenter());
     std::function<void(ComponentValue)> centerCallback = [&](ComponentValue v) { m_collider->SetCenter(v.v); };
     AddGenericParam("Center", ComponentParameter::TYPE_VECTOR3, centerValue, centerCallback);
 
+    // Layer parameter
+    ComponentValue layerValue = ComponentValue(ComponentParameter::TYPE_INT, m_collider->GetLayer());
+    std::function<void(ComponentValue)> layerCallback = [&](ComponentValue v) { m_collider->SetLayer(v.i); };
+    AddGenericParam("Layer", ComponentParameter::TYPE_INT, layerValue, layerCallback);
+
     Collider::ColliderType type = collider->GetType();
     switch(type)
     {
@@ -684,6 +694,16 @@ ComponentModelColliderItem::ComponentModelColliderItem(Collider* collider, bool
         AddGenericParam("Axis", ComponentParameter::TYPE_INT, axisValue, axisCallback);
         break;
     }
+    case Collider::MESH_COLLIDER:
+    {
+        m_name = "Mesh Collider";
+        break;
+    }
+    case Collider::COMPOUND_COLLIDER:
+    {
+        m_name = "Compound Collider";
+        break;
+    }
     }
 }
 
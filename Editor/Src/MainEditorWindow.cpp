@@ -118,6 +118,7 @@ void MainEditorWindow::SetupMenuCommands()
     SignalMapHookup(m_addPhysicsSignalMapper, m_ui->actionAdd_Sphere_Collider,  (int)Collider::SPHERE_COLLIDER);
     SignalMapHookup(m_addPhysicsSignalMapper, m_ui->actionAdd_Box_Collider,     (int)Collider::BOX_COLLIDER);
     SignalMapHookup(m_addPhysicsSignalMapper, m_ui->actionAdd_Capsule_Collider, (int)Collider::CAPSULE_COLLIDER);
+    SignalMapHookup(m_addPhysicsSignalMapper, m_ui->actionAdd_Mesh_Collider,    (int)Collider::MESH_COLLIDER);
     connect(m_ui->actionRigid_Body,             SIGNAL(triggered()),    this, SLOT(AddRigidBody()));
 
     // Effect menu
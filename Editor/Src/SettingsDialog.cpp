@@ -17,9 +17,11 @@ void SettingsDialog::accept()
     int height = m_ui->resolutionHeight->toPlainText().toInt();
     GameProject::Singleton().SetResolution(width, height);
 
-    bool physicsEnabled = m_ui->physicsEnabled;
-    float gravity = m_ui->physicsGravity->toPlainText().toFloat();
-    GameProject::Singleton().SetPhysicsSettings(GameProject::PhysicsSettings(physicsEnabled, gravity));
+    // Start from the current settings so that values not exposed in the dialog are preserved
+    GameProject::PhysicsSettings physicsSettings = GameProject::Singleton().GetPhysicsSettings();
+    physicsSettings.Enabled = m_ui->physicsEnabled;
+    physicsSettings.Gravity = m_ui->physicsGravity->toPlainText().toFloat();
+    GameProject::Singleton().SetPhysicsSettings(physicsSettings);
 
     QDialog::accept();
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 
 #include <list>
+#include <stdio.h>
 #include <string>
 
 #include "Scene\Scene.h"
@@ -24,22 +25,33 @@ public:
         static Game singleton;
         return singleton;
     }
-    Game() {}
+    Game() : m_headless(false) {}
 
-    void Init(string projectPath, GameComponentFactory* componentFactory);
+    void Init(string projectPath, GameComponentFactory* componentFactory, bool headless = false);
     void Run(Scene* scene);
-    
+
+    // Steps the scene for a fixed number of frames without a window or renderer, and writes
+    // timings and contact counts to the output as JSON. Unlike Run, it returns once it's done.
+    void RunHeadless(Scene* scene, int frameCount, FILE* output);
+
 private:
     void Shutdown();
     void UpdateTime();
+    void UpdatePhysics(float deltaTime);
+    void StepPhysics(float deltaTime);
 
     GameWindow  m_gameWindow;
     GameObject* m_rootObject;
     GameComponentFactory* m_engineComponentFactory;
+    bool        m_headless;
 
     float       m_prevFrameEndTime;
     float       m_deltaTime;
     float       m_minFrameTime;
     float       m_timeSinceFPSSnapshot;
     int         m_framesSinceFPSSnapshot;
+
+    float       m_physicsAccumulator;       // Frame time that hasn't been simulated yet
+    float       m_physicsTimeStep;
+    int         m_maxPhysicsSteps;
 };
\ No newline at end of file
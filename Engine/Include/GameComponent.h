@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Physics/CollisionEvent.h"
+
 class GameObject;
 
 class GameComponent
@@ -15,12 +17,19 @@ public:
     virtual void    OnEnable() {}
     virtual void    OnDisable() {}
 
-    virtual void    OnCollisionEnter() {}
-    virtual void    OnCollisionHold() {}
-    virtual void    OnCollisionExit() {}
+    // Only called for the event types the component listens for (see ListenForCollisions)
+    virtual void    OnCollisionEnter(const Collision&) {}
+    virtual void    OnCollisionHold(const Collision&) {}
+    virtual void    OnCollisionExit(const Collision&) {}
+    virtual void    OnTriggerEnter(const Collision&) {}
+    virtual void    OnTriggerExit(const Collision&) {}
 
     bool            IsEnabled();
 
+    // Takes a combination of CollisionEventType flags (0 to stop listening)
+    void            ListenForCollisions(unsigned int eventTypes);
+    unsigned int    GetCollisionEventTypes();
+
     // Engine use only - TODO enforce this
     GameObject*     GetGameObject();
     void            SetGameObject(GameObject* gameObject);
@@ -32,4 +41,5 @@ protected:
 
 private:
     bool            m_enabled;
+    unsigned int    m_collisionEventTypes;
 };
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "GameObjectBase.h"
+#include "Physics/CollisionEvent.h"
 
 using std::string;
 using std::vector;
@@ -37,9 +38,10 @@ public:
     void    OnActivate();
     void    OnDeactivate();
 
-    void    OnCollisionEnter();
-    void    OnCollisionHold();
-    void    OnCollisionExit();
+    // Collision events are only sent to components that listen for them
+    void    OnCollision(CollisionEventType type, const Collision& collision);
+    bool    ListensForCollisions(CollisionEventType type);
+    void    UpdateCollisionListener(GameComponent* component);      // Called when a component changes the events it listens for
 
     // TODO this shouldn't be here
     void    Render(bool dirty, bool wireframe = false);
@@ -51,4 +53,6 @@ private:
     bool                    m_active;
 
     vector<GameComponent*>  m_components;
+    vector<GameComponent*>  m_collisionListeners;
+    unsigned int            m_collisionEventTypes;      // Every event type that at least one listener wants
 };
\ No newline at end of file
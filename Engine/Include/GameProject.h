@@ -14,10 +14,25 @@ class Scene;
 class GameProject
 {
 public:
+    enum BroadPhaseType { BROAD_PHASE_BVH, BROAD_PHASE_SWEEP_AND_PRUNE, BROAD_PHASE_HASH_GRID };
+    enum ContactSolverType { CONTACT_SOLVER_WORST_FIRST, CONTACT_SOLVER_SEQUENTIAL_IMPULSE };
+
     struct PhysicsSettings
     {
-        bool    Enabled;
-        float   Gravity;
+        bool            Enabled;
+        float           Gravity;
+        BroadPhaseType  BroadPhase;
+        float           GridCellSize;       // Cell size for the hash grid broad phase (0 = derive from collider sizes)
+        int             StepRate;           // Fixed physics updates per second
+        int             MaxStepsPerFrame;   // Limits how far physics tries to catch up after a slow frame
+        int             NarrowPhaseThreads; // Threads used by the narrow phase (0 = one per core, 1 = single-threaded)
+        ContactSolverType ContactSolver;
+        int             SolverIterations;   // Velocity iterations for the sequential impulse solver (0 = default)
+        bool            SpeculativeContacts;    // Generate contacts ahead of time for fast bodies, so they can't tunnel at low step rates
+        vector<unsigned int> LayerCollisionMasks;   // Per collision layer, the layers it collides with (layers not listed collide with everything)
+
+        const static int DEFAULT_STEP_RATE = 60;
+        const static int DEFAULT_MAX_STEPS_PER_FRAME = 5;
 
         PhysicsSettings();
         PhysicsSettings(bool enabled, float gravity);
@@ -30,7 +45,7 @@ public:
     }
     GameProject() {}
 
-    void    Startup(bool toolside = false);
+    void    Startup(bool toolside = false, bool headless = false);
     void    Shutdown();
 
     bool    New(string name, string filename, string resourcePath);
@@ -39,6 +54,7 @@ public:
     bool    Unload();
     bool    IsLoaded();
     bool    IsToolside();
+    bool    IsHeadless();       // No window or renderer; render resources are not loaded
 
     void    SetRuntimeComponentFactory(GameComponentFactory* factory, bool engine);
     GameComponentFactory* GetRuntimeComponentFactory(bool engine);
@@ -74,6 +90,7 @@ private:
     vector<Scene*>  m_sceneList;
 
     bool    m_toolside;
+    bool    m_headless;
 
     int     m_width;
     int     m_height;
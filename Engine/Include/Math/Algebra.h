@@ -267,6 +267,7 @@ private:
 };
 
 Quaternion operator *(const Quaternion& a, const Quaternion& b);
+Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t);     // Normalized linear interpolation, taking the shorter path
 
 float DegreesToRadians(float degrees);
 float RadiansToDegrees(float radians);
@@ -0,0 +1,113 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Lane types for kernels that are written once and run on a single float
+// (the fallback) or on packed floats, using the widest instruction set
+// the engine is built with. Masks are 1/0 for a single float, and all
+// bits set/clear for packed lanes. Both do the same operations in the
+// same order, so every build computes the same result.
+//////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+#if defined(__AVX__)
+#define PACKED_FLOAT_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define PACKED_FLOAT_SSE
+#include <emmintrin.h>
+#endif
+
+struct Float1
+{
+    static const unsigned int Width = 1;
+
+    Float1() {}
+    Float1(float f) : v(f) {}
+
+    static Float1   Load(const float* p)    { return Float1(*p); }
+    void            Store(float* p) const   { *p = v; }
+
+    float v;
+};
+
+inline Float1 operator +(Float1 a, Float1 b)            { return Float1(a.v + b.v); }
+inline Float1 operator -(Float1 a, Float1 b)            { return Float1(a.v - b.v); }
+inline Float1 operator *(Float1 a, Float1 b)            { return Float1(a.v * b.v); }
+inline Float1 operator /(Float1 a, Float1 b)            { return Float1(a.v / b.v); }
+inline Float1 Sqrt(Float1 a)                            { return Float1(sqrtf(a.v)); }
+inline Float1 Abs(Float1 a)                             { return Float1(fabsf(a.v)); }
+inline Float1 Min(Float1 a, Float1 b)                   { return Float1(a.v < b.v ? a.v : b.v); }
+inline Float1 Max(Float1 a, Float1 b)                   { return Float1(a.v > b.v ? a.v : b.v); }
+inline Float1 GreaterThan(Float1 a, Float1 b)           { return Float1(a.v > b.v ? 1.0f : 0.0f); }
+inline Float1 GreaterEqual(Float1 a, Float1 b)          { return Float1(a.v >= b.v ? 1.0f : 0.0f); }
+inline Float1 MaskAnd(Float1 a, Float1 b)               { return Float1(a.v != 0 && b.v != 0 ? 1.0f : 0.0f); }
+inline Float1 MaskOr(Float1 a, Float1 b)                { return Float1(a.v != 0 || b.v != 0 ? 1.0f : 0.0f); }
+inline Float1 Select(Float1 mask, Float1 a, Float1 b)   { return mask.v != 0 ? a : b; }
+inline unsigned int MoveMask(Float1 mask)               { return mask.v != 0 ? 1 : 0; }    // One bit per lane
+
+#ifdef PACKED_FLOAT_SSE
+struct Float4
+{
+    static const unsigned int Width = 4;
+
+    Float4() {}
+    Float4(float f) : v(_mm_set1_ps(f)) {}
+    Float4(__m128 m) : v(m) {}
+
+    static Float4   Load(const float* p)    { return Float4(_mm_loadu_ps(p)); }
+    void            Store(float* p) const   { _mm_storeu_ps(p, v); }
+
+    __m128 v;
+};
+
+inline Float4 operator +(Float4 a, Float4 b)            { return Float4(_mm_add_ps(a.v, b.v)); }
+inline Float4 operator -(Float4 a, Float4 b)            { return Float4(_mm_sub_ps(a.v, b.v)); }
+inline Float4 operator *(Float4 a, Float4 b)            { return Float4(_mm_mul_ps(a.v, b.v)); }
+inline Float4 operator /(Float4 a, Float4 b)            { return Float4(_mm_div_ps(a.v, b.v)); }
+inline Float4 Sqrt(Float4 a)                            { return Float4(_mm_sqrt_ps(a.v)); }
+inline Float4 Abs(Float4 a)                             { return Float4(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+inline Float4 Min(Float4 a, Float4 b)                   { return Float4(_mm_min_ps(a.v, b.v)); }
+inline Float4 Max(Float4 a, Float4 b)                   { return Float4(_mm_max_ps(a.v, b.v)); }
+inline Float4 GreaterThan(Float4 a, Float4 b)           { return Float4(_mm_cmpgt_ps(a.v, b.v)); }
+inline Float4 GreaterEqual(Float4 a, Float4 b)          { return Float4(_mm_cmpge_ps(a.v, b.v)); }
+inline Float4 MaskAnd(Float4 a, Float4 b)               { return Float4(_mm_and_ps(a.v, b.v)); }
+inline Float4 MaskOr(Float4 a, Float4 b)                { return Float4(_mm_or_ps(a.v, b.v)); }
+inline Float4 Select(Float4 mask, Float4 a, Float4 b)   { return Float4(_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))); }
+inline unsigned int MoveMask(Float4 mask)               { return _mm_movemask_ps(mask.v); }
+
+typedef Float4 PackedFloat;
+#endif
+
+#ifdef PACKED_FLOAT_AVX
+struct Float8
+{
+    static const unsigned int Width = 8;
+
+    Float8() {}
+    Float8(float f) : v(_mm256_set1_ps(f)) {}
+    Float8(__m256 m) : v(m) {}
+
+    static Float8   Load(const float* p)    { return Float8(_mm256_loadu_ps(p)); }
+    void            Store(float* p) const   { _mm256_storeu_ps(p, v); }
+
+    __m256 v;
+};
+
+inline Float8 operator +(Float8 a, Float8 b)            { return Float8(_mm256_add_ps(a.v, b.v)); }
+inline Float8 operator -(Float8 a, Float8 b)            { return Float8(_mm256_sub_ps(a.v, b.v)); }
+inline Float8 operator *(Float8 a, Float8 b)            { return Float8(_mm256_mul_ps(a.v, b.v)); }
+inline Float8 operator /(Float8 a, Float8 b)            { return Float8(_mm256_div_ps(a.v, b.v)); }
+inline Float8 Sqrt(Float8 a)                            { return Float8(_mm256_sqrt_ps(a.v)); }
+inline Float8 Abs(Float8 a)                             { return Float8(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+inline Float8 Min(Float8 a, Float8 b)                   { return Float8(_mm256_min_ps(a.v, b.v)); }
+inline Float8 Max(Float8 a, Float8 b)                   { return Float8(_mm256_max_ps(a.v, b.v)); }
+inline Float8 GreaterThan(Float8 a, Float8 b)           { return Float8(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+inline Float8 GreaterEqual(Float8 a, Float8 b)          { return Float8(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+inline Float8 MaskAnd(Float8 a, Float8 b)               { return Float8(_mm256_and_ps(a.v, b.v)); }
+inline Float8 MaskOr(Float8 a, Float8 b)                { return Float8(_mm256_or_ps(a.v, b.v)); }
+inline Float8 Select(Float8 mask, Float8 a, Float8 b)   { return Float8(_mm256_blendv_ps(b.v, a.v, mask.v)); }
+inline unsigned int MoveMask(Float8 mask)               { return _mm256_movemask_ps(mask.v); }
+
+typedef Float8 PackedFloat;
+#endif
\ No newline at end of file
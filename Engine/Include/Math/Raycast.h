@@ -17,6 +17,15 @@ public:
         HitInfo(Vector3 p, float d) { point = p, distance = d; }
     };
 
+    struct Ray
+    {
+        Vector3 origin;
+        Vector3 direction;
+
+        Ray() {};
+        Ray(Vector3 o, Vector3 d) { origin = o, direction = d; }
+    };
+
     static bool RaycastSphere(Vector3 rayOrigin,
                               Vector3 rayDirection,
                               float sphereRadius,
@@ -39,4 +48,31 @@ public:
                                   bool recursive,
                                   GameObjectBase*& hitObject,
                                   HitInfo& hitInfo);
+
+    // Batched queries, which test several rays at a time (4 with SSE, 8 with AVX) against a list of shapes. Each
+    // ray's closest hit goes to the matching entry of hits, which the caller fills in with the farthest distance a
+    // hit counts at (FLT_MAX for no limit). An entry is only overwritten by a closer hit, so batches can also be
+    // run against several lists in turn. Distances are along the normalized ray direction. Returns the number of
+    // entries that were overwritten.
+    static int GetBatchWidth();      // Number of rays tested at a time
+
+    static int RaycastSphereBatch(const Ray* rays,
+                                  int rayCount,
+                                  const float* sphereRadii,
+                                  const Vector3* spherePositions,
+                                  int sphereCount,
+                                  HitInfo* hits);
+
+    static int RaycastBoxBatch(const Ray* rays,
+                               int rayCount,
+                               const Vector3* boxMins,
+                               const Vector3* boxMaxes,
+                               int boxCount,
+                               HitInfo* hits);
+
+    static int RaycastTriangleBatch(const Ray* rays,
+                                    int rayCount,
+                                    const Vector3* triangles,      // Three vertices per triangle
+                                    int triangleCount,
+                                    HitInfo* hits);
 };
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdio.h>
+
+// Times the batched ray queries against the scalar ones on a generated scene of spheres and triangles, and writes
+// a JSON report. Rays where the two paths disagree are counted, as a check on the batched path.
+class RaycastBenchmark
+{
+public:
+    static void Run(int rayCount, int triangleCount, int iterations, FILE* output);
+};
\ No newline at end of file
@@ -54,6 +54,8 @@ public:
     Vector3     InverseTransformPoint(Vector3 point);
     Vector3     InverseTransformVector(Vector3 vector);
 
+    void        RecomputeIfDirty();     // Brings the cached matrices up to date, so later reads don't write
+
 private:
     void        RemoveChild(Transform* transform);
 
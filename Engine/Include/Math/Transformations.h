@@ -21,6 +21,7 @@ Matrix4x4 PerspectiveProjection(float FOV, float aspect, float near, float far);
 
 Matrix3x3 InertiaTensorCuboid(const Vector3& halfsizes, float mass);
 Matrix3x3 InertiaTensorSphere(float radius, float mass);
+Matrix3x3 InertiaTensorCapsule(float radius, float height, eAXIS axis, float mass);     // height is the length of the cylinder
 
 void DecomposeTRSMatrix(const Matrix4x4& matrix, Vector3& position, Vector3& rotation, Vector3& scale);
 void CalculateTRSMatrix(const Vector3& position, const Vector3& rotation, const Vector3& scale, Matrix4x4& matrix);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Math/Algebra.h"
+
+class Collider;
+
+// Axis-aligned bounding box, given in world space
+struct BoundingBox
+{
+    BoundingBox();
+    BoundingBox(const Vector3& min, const Vector3& max);
+    BoundingBox(const BoundingBox& a, const BoundingBox& b);
+    BoundingBox(Collider* collider);
+
+    bool        Overlaps(const BoundingBox* other) const;
+    bool        Contains(const BoundingBox* other) const;
+    float       GetSize();
+    float       GetSurfaceArea() const;
+    float       GetGrowth(BoundingBox& volume);
+
+    // Slab test against the box grown by the margin. The inverse direction holds the reciprocal of each
+    // component of the ray direction, so that it can be worked out once per ray.
+    bool        IntersectsRay(const Vector3& origin, const Vector3& inverseDirection, float maxDistance, float margin, float& entryDistance) const;
+
+    Vector3     GetCenter() const;
+    Vector3     GetHalfsize() const;
+
+    void        Expand(float margin);
+    void        ExpandByDisplacement(const Vector3& displacement);
+
+    Vector3     Min;
+    Vector3     Max;
+};
\ No newline at end of file
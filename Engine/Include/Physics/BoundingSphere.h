@@ -12,6 +12,7 @@ struct BoundingSphere
     BoundingSphere(Collider* collider);
 
     bool        Overlaps(const BoundingSphere* other);
+    bool        IntersectsRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, float& entryDistance) const;    // Direction must be normalized
     float       GetSize();
     float       GetGrowth(BoundingSphere& volume);
 
@@ -0,0 +1,51 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Interface for the broad phase that tracks dynamic colliders and
+// generates potential contacts between them. Every implementation feeds
+// the same PotentialContact output, so the narrow phase does not depend
+// on which broad phase is selected in the project's physics settings.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Physics/BoundingBox.h"
+#include "Rendering/Color.h"
+#include <vector>
+
+using std::vector;
+
+class Collider;
+class CollisionFilter;
+struct PotentialContact;
+
+// Receives the colliders a ray query passes, and decides how far the ray goes on
+class BroadPhaseRayCallback
+{
+public:
+    virtual ~BroadPhaseRayCallback() {}
+
+    // Returns the distance to clip the ray to (e.g. the closest hit found so far), or maxDistance to leave it as it is
+    virtual float           RayTest(Collider* collider, float maxDistance) = 0;
+};
+
+class BroadPhase
+{
+public:
+    virtual ~BroadPhase() {}
+
+    virtual void            AddCollider(Collider* collider) = 0;
+    virtual void            RemoveCollider(Collider* collider) = 0;
+
+    // Called once per frame for each collider, with its current bounds and predicted displacement
+    virtual void            UpdateCollider(Collider* collider, const BoundingBox& box, const Vector3& displacement) = 0;
+
+    // Appends the potential contacts the filter accepts (all of them if it's NULL) to the given buffer, and
+    // returns how many were added
+    virtual unsigned int    GetPotentialContacts(vector<PotentialContact>& contacts, CollisionFilter* filter) = 0;
+
+    // Scene queries, against the bounds given in the last update. Ray queries test the bounds grown by the
+    // margin (for sphere casts), and the direction must be normalized.
+    virtual void            QueryBox(const BoundingBox& box, vector<Collider*>& results) = 0;
+    virtual void            QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, BroadPhaseRayCallback* callback) = 0;
+
+    virtual void            DrawDebugInfo(ColorRGB) {}
+};
\ No newline at end of file
@@ -2,17 +2,31 @@
 
 #include "Math/Algebra.h"
 #include "Math/Transform.h"
+#include "Physics/BoundingBox.h"
 #include "Rendering/Color.h"
+#include <vector>
 
+#define MAX_COLLISION_LAYERS 32
+#define ALL_COLLISION_LAYERS 0xFFFFFFFF     // Layer mask that includes every layer
+
+#define COMPOUND_BVH_LEAF_SIZE 2            // Compound hierarchy nodes with this many children or fewer are not split
+#define COMPOUND_BVH_MAX_DEPTH 64           // Size of the compound hierarchy's traversal stack
+#define COMPOUND_QUERY_CAPACITY 16          // Children the narrow phase expects to find near a collider, reserved in its scratch buffer
+
+using std::vector;
+
+class CompoundCollider;
 class DebugCapsule;
 class GameObjectBase;
 class HierarchicalDeserializer;
 class HierarchicalSerializer;
+class Mesh;
+class TriangleBVH;
 
 class Collider
 {
 public:
-    enum ColliderType { SPHERE_COLLIDER, BOX_COLLIDER, CAPSULE_COLLIDER };
+    enum ColliderType { SPHERE_COLLIDER, BOX_COLLIDER, CAPSULE_COLLIDER, MESH_COLLIDER, COMPOUND_COLLIDER, NUM_COLLIDER_TYPES };
 
     Collider(GameObjectBase* gameObject);
     virtual ~Collider();
@@ -33,13 +47,37 @@ public:
     Transform&              GetTransform();
 
     bool                    IsStatic();
+    bool                    IsTrigger();            // Triggers only report overlaps, and are never resolved
     Vector3                 GetCenter();
+    int                     GetLayer();
+    unsigned int            GetLayerMask();         // The bit for this collider's layer, for testing against layer masks
 
-    void                    SetStatic(bool isStatic);
+    void                    SetStatic(bool isStatic);   // Once registered, use CollisionEngine::MigrateCollider instead
+    void                    SetTrigger(bool isTrigger);
     void                    SetCenter(Vector3 center);
+    void                    SetLayer(int layer);
+
+    int                     GetBroadPhaseProxy();
+    void                    SetBroadPhaseProxy(int proxy);
+    int                     GetHierarchyProxy();
+    void                    SetHierarchyProxy(int proxy);
+    int                     GetRegistryIndex();
+    void                    SetRegistryIndex(int index);
+
+    // A compound's children report their own contacts, so each keeps its own manifold, but they're resolved
+    // against the compound's rigid body
+    CompoundCollider*       GetCompound();          // NULL if the collider isn't a compound's child
+    void                    SetCompound(CompoundCollider* compound);
+    GameObjectBase*         GetBodyObject();        // The compound's game object for its children, otherwise this one's
 
 protected:
     bool                    m_isStatic;
+    bool                    m_isTrigger;
+    int                     m_layer;                // 0 to MAX_COLLISION_LAYERS - 1
+    int                     m_broadPhaseProxy;      // Handle used by the collision engine's broad phase (-1 if not registered)
+    int                     m_hierarchyProxy;       // Leaf holding this collider in the collision engine's static hierarchy (-1 if none)
+    int                     m_registryIndex;        // Position in the collision engine's static or dynamic collider list (-1 if not registered)
+    CompoundCollider*       m_compound;
     GameObjectBase*         m_gameObject;
     Transform               m_transform;
     Vector3                 m_center;
@@ -120,4 +158,96 @@ private:
     eAXIS                   m_axis;
 
     DebugCapsule*           m_debugCapsule;
+};
+
+// Collides against the triangles of a mesh, which is expected to be static level geometry
+class MeshCollider : public Collider
+{
+public:
+    MeshCollider(GameObjectBase* gameObject, Mesh* mesh = NULL);
+
+    virtual void            Save(HierarchicalSerializer* serializer);
+    virtual void            Load(HierarchicalDeserializer* deserializer);
+
+    virtual ColliderType    GetType();
+    virtual float           GetWorldspaceBoundingRadius();
+    virtual Matrix3x3       GetInertiaTensor(float mass);
+    virtual void            DebugDraw(ColorRGB color, bool useDepth = true);
+
+    Mesh*                   GetMesh();
+    void                    SetMesh(Mesh* mesh);    // If NULL, the game object's rendered mesh is used (if it has one)
+
+    TriangleBVH*            GetTriangleBVH();       // Owned by the mesh, so don't keep it. NULL if there is no mesh.
+
+private:
+    Mesh*                   m_mesh;
+};
+
+// Merges the colliders of attached objects (e.g. props picked up by a ball) under one rigid body, so that they take
+// up a single broad phase entry. Children are taken out of the collision engine while they're in the compound, and
+// the narrow phase reaches them through a hierarchy built over them in the compound's space. The merged bounds and
+// the hierarchy are cached, and rebuilt by Refresh once the children have changed, so attaching many children in one
+// frame only rebuilds them once. The inertia tensor is only worked out again when the rigid body asks for it. Add the
+// body's own colliders as children too, so that its inertia matches its whole shape.
+//
+// Children are expected to keep their place relative to the compound's game object, and whether they're triggers (call
+// MarkChildrenMoved if they don't). A solid compound's trigger children only report overlaps. The compound doesn't own
+// its children, and sits at the center of their merged bounds.
+class CompoundCollider : public Collider
+{
+public:
+    CompoundCollider(GameObjectBase* gameObject);
+    virtual ~CompoundCollider();
+
+    virtual void            Save(HierarchicalSerializer* serializer);
+    virtual void            Load(HierarchicalDeserializer* deserializer);
+
+    virtual ColliderType    GetType();
+    virtual float           GetWorldspaceBoundingRadius();
+    virtual Matrix3x3       GetInertiaTensor(float mass);
+    virtual void            DebugDraw(ColorRGB color, bool useDepth = true);
+
+    void                    AddChild(Collider* child);          // Compounds don't nest
+    void                    RemoveChild(Collider* child);       // The child goes back to the collision engine
+    void                    MarkChildrenMoved();                // Call once the children are in their new places
+
+    int                     GetChildCount();
+    bool                    HasTriggerChildren();
+    Collider*               GetChild(int index);                // Children are reordered when the hierarchy is rebuilt
+
+    // Rebuilds whatever the children have made stale, and updates the rigid body's inertia tensor if they changed. The
+    // collision engine calls this on the main thread before the broad phase; until then the getters return the old bounds.
+    void                    Refresh();
+    void                    RecomputeChildTransforms();         // See Transform::RecomputeIfDirty
+
+    // Appends the children whose bounds overlap the given world space box. Once the transforms are up to date, this
+    // doesn't modify anything, so it's safe to query from several threads at once.
+    void                    QueryChildren(const BoundingBox& worldBox, vector<int>& results);
+
+    // Appends the children whose bounds, grown by the margin, the world space ray passes through within maxDistance
+    void                    QueryChildrenRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, vector<int>& results);
+
+private:
+    struct Node
+    {
+        BoundingBox     Box;
+        int             Start;          // Leaves: first child. Inner nodes: index of the second child.
+        int             Count;          // Number of children in a leaf, 0 for inner nodes
+
+        bool            IsLeaf() const { return Count > 0; }
+    };
+
+    void                    RebuildBounds();
+    void                    BuildNode(int begin, int end, vector<BoundingBox>& bounds, vector<int>& order);
+    void                    CalculateInertiaTensor();
+
+    vector<Collider*>       m_children;
+    vector<Node>            m_nodes;                // Depth first, so the first child of an inner node is the next node
+    float                   m_localRadius;          // Around the compound's position, in its space
+    int                     m_triggerChildCount;
+    Matrix3x3               m_inertiaTensor;        // For unit mass, about the game object's origin
+
+    bool                    m_boundsDirty;
+    bool                    m_childrenChanged;      // Set until the rigid body has been updated
+    bool                    m_inertiaDirty;
 };
\ No newline at end of file
@@ -1,11 +1,22 @@
 #pragma once
 
 #include "Math/Algebra.h"
+#include <vector>
+
+#define INITIAL_CONTACT_CAPACITY 256
+#define MAX_BOX_CONTACTS 4              // Face contacts between boxes are reduced to this many points
+#define MAX_CLIP_VERTICES 8             // Clipping a quad against four planes leaves at most eight vertices
+#define MESH_QUERY_CAPACITY 64          // Triangles the mesh tests expect to find near a collider, reserved up front in their scratch buffer
+
+using std::vector;
 
 class Collider;
 class BoxCollider;
 class CapsuleCollider;      // TODO implement me
 class SphereCollider;
+class MeshCollider;
+struct BoundingBox;
+struct ManifoldPoint;
 
 struct CollisionContact
 {
@@ -15,36 +26,78 @@ public:
 
     Vector3             ContactPoint;
     Vector3             ContactNormal;
-    float               Penetration;
+    float               Penetration;        // Negative for speculative contacts, where it's the gap between the colliders
+
+    unsigned int        FeatureId;          // Identifies the pair of features in contact, so the contact can be matched next step (0 = unknown)
+    ManifoldPoint*      CachedPoint;        // Persistent manifold point this contact was reported from, if any
+};
+
+// Per-frame counters for one of the growable contact buffers
+struct ContactBufferStats
+{
+    ContactBufferStats();
+
+    void                Record(unsigned int count, unsigned int truncated);
+
+    unsigned int        Count;              // Number of entries used this frame
+    unsigned int        Peak;               // Largest per-frame count seen so far
+    unsigned int        Truncated;          // Number of entries dropped this frame because the buffer hit its limit
+    unsigned int        TotalTruncated;     // Number of entries dropped over all frames
 };
 
 struct CollisionData
 {
     CollisionData(int maxContacts);
-    ~CollisionData();
 
-    CollisionContact*   ClaimNextContact();
+    CollisionContact*   ClaimNextContact();     // Returns NULL once MaxContacts is reached
     void                Reset();
 
-    CollisionContact*   Contacts;
-    CollisionContact*   NextEmptyContact;
+    vector<CollisionContact>    Contacts;       // Grows on demand, and keeps its capacity across frames
 
     int                 ContactsUsed;
-    int                 ContactsRemaining;
-    int                 MaxContacts;
+    int                 ContactsDropped;        // Contacts that could not be claimed this frame
+    int                 MaxContacts;            // Safety limit, to keep a degenerate frame from exhausting memory
+};
+
+// A vertex of the incident face while it's clipped against the reference face of a box-box contact
+struct ClipVertex
+{
+    Vector3             Point;
+    unsigned int        FeatureId;          // Incident vertex (0-7), or the line and clipping plane that created the vertex
+    unsigned int        EdgeFeature;        // Line the edge to the next vertex lies on: incident edge (0-3) or side plane (4-7)
 };
 
 class CollisionDetection
 {
 public:
-    static unsigned int SphereAndSphere(SphereCollider* a, SphereCollider* b, CollisionData* data);
-    static unsigned int SphereAndBox(SphereCollider* s, BoxCollider* b, CollisionData* data);
-    static unsigned int BoxAndBox(BoxCollider* a, BoxCollider* b, CollisionData* data);
+    // Colliders up to speculativeDistance apart also generate (speculative) contacts, so the solver
+    // can stop them closing the gap this step instead of letting them pass through each other
+    static unsigned int SphereAndSphere(SphereCollider* a, SphereCollider* b, CollisionData* data, float speculativeDistance = 0.0f);
+    static unsigned int SphereAndBox(SphereCollider* s, BoxCollider* b, CollisionData* data, float speculativeDistance = 0.0f);
+    static unsigned int BoxAndBox(BoxCollider* a, BoxCollider* b, CollisionData* data, float speculativeDistance = 0.0f);
+
+    // Mesh tests only check the triangles that the mesh's BVH finds near the other collider
+    static unsigned int SphereAndMesh(SphereCollider* s, MeshCollider* m, CollisionData* data, float speculativeDistance = 0.0f);
+    static unsigned int BoxAndMesh(BoxCollider* b, MeshCollider* m, CollisionData* data, float speculativeDistance = 0.0f);
+
+    // Boolean tests for triggers and scene queries, which only need to know whether the colliders touch
+    static bool     SphereOverlapsSphere(SphereCollider* a, SphereCollider* b);
+    static bool     SphereOverlapsBox(SphereCollider* s, BoxCollider* b);
+    static bool     BoxOverlapsBox(BoxCollider* a, BoxCollider* b);
+    static bool     SphereOverlapsMesh(SphereCollider* s, MeshCollider* m);
+    static bool     BoxOverlapsMesh(BoxCollider* b, MeshCollider* m);
 
 private:
     static float    ProjectToAxis(BoxCollider* box, Vector3& axis);
     static float    PenetrationOnAxis(BoxCollider* a, BoxCollider* b, Vector3& axis, Vector3& centerAToCenterB);
-    static void     SetFaceVertexContactData(BoxCollider* faceBox, BoxCollider* vertexBox, Vector3& centerToCenter, CollisionData* data, Vector3 axis, float bestOverlap);
-    static void     SetEdgeEdgeContactData(BoxCollider* a, BoxCollider* b, CollisionData* data, int oneAxisIndex, int twoAxisIndex, Vector3& centerToCenter, float bestOverlap);
+    static unsigned int SetFaceContactData(BoxCollider* faceBox, BoxCollider* incidentBox, Vector3& centerToCenter, CollisionData* data, Vector3 axis, unsigned int faceAxisIndex, float speculativeDistance);
+    static unsigned int SetEdgeEdgeContactData(BoxCollider* a, BoxCollider* b, CollisionData* data, int oneAxisIndex, int twoAxisIndex, Vector3& centerToCenter, float bestOverlap);
+    static int      ClipPolygon(ClipVertex* input, int inputCount, Vector3& planeNormal, float planeOffset, int planeIndex, ClipVertex* output);
+    static int      ReduceContactPoints(ClipVertex* points, float* depths, int count, int* selected);
     static Vector3  GetContactPoint(Vector3& axisOne, Vector3& axisTwo, Vector3& pointOnEdgeOne, Vector3& pointOnEdgeTwo);
+
+    static void     QueryMeshTriangles(MeshCollider* mesh, const BoundingBox& worldBox, vector<int>& triangles);
+    static Vector3  ClosestPointOnTriangle(const Vector3& point, Vector3* triangle);
+    static bool     BoxOverlapsTriangle(BoxCollider* box, Vector3* triangle);
+    static unsigned int BoxAndTriangle(BoxCollider* box, MeshCollider* mesh, Vector3* triangle, unsigned int triangleIndex, CollisionData* data, float speculativeDistance);
 };
\ No newline at end of file
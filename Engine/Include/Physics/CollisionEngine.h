@@ -1,31 +1,39 @@
 #pragma once
 
-#include "BoundingSphere.h"
-#include "BVHNode.h"
 #include "Physics/CollisionDetection.h"
+#include "Physics/CollisionEvent.h"
+#include "Physics/CollisionFilter.h"
+#include "Physics/CollisionPairTable.h"
+#include "Physics/ContactManifold.h"
+#include "Physics/StaticBVH.h"
 #include "Rendering/Color.h"
+#include "WorkerPool.h"
 #include <set>
 #include <vector>
 
-#define MAX_POTENTIAL_CONTACTS 25
+// Safety limits for the per-frame contact buffers, which otherwise grow as needed
+#define MAX_POTENTIAL_CONTACTS 65536
+#define MAX_COLLISION_CONTACTS 65536
+
+// Below this many potential contacts the narrow phase stays on the calling thread
+#define MIN_PARALLEL_NARROW_PHASE_PAIRS 64
+
+// Default share of the static colliders that can be added or removed before the static hierarchy is rebuilt
+#define STATIC_REBUILD_FRACTION 0.25f
 
 using std::vector;
 
+class BroadPhase;
 class Collider;
 class GameObject;
 
 struct PotentialContact
 {
     PotentialContact();
+    PotentialContact(Collider* a, Collider* b);
 
     Collider* colliders[2];
-};
-
-struct CollisionPair
-{
-    CollisionPair();
-    CollisionPair(GameObject* a, GameObject* b);
-    GameObject* gameObjects[2];
+    float     speculativeDistance;      // Largest gap the pair could close this step (0 unless speculative contacts are on)
 };
 
 class CollisionEngine
@@ -43,31 +51,82 @@ public:
     void    Shutdown();
 
     void    CalculateCollisions(float deltaTime);
+    void    DispatchCollisionEvents();      // Call after the contacts have been resolved, so events can report impulses
     void    DrawDebugInfo();
     const   CollisionData* GetCollisionData();
 
+    const   vector<CollisionEvent>& GetCollisionEvents();
+    const   ContactBufferStats& GetPotentialContactStats();
+    const   ContactBufferStats& GetContactStats();
+    unsigned int GetNarrowPhaseThreadCount();
+
+    StaticBVH*                  GetStaticHierarchy();
+    BroadPhase*                 GetBroadPhase();
+    CollisionFilter&            GetCollisionFilter();       // Changes apply from the next step
+
     void    RegisterCollider(Collider* collider);
     void    UnregisterCollider(Collider* collider);
 
+    // Moves a collider between the static hierarchy and the dynamic set, e.g. when a static prop is picked up or
+    // settled debris comes to rest, and sets its static flag. Takes O(log n) in the number of colliders, as long as
+    // the broad phase adds and removes colliders in O(log n).
+    void    MigrateCollider(Collider* collider, bool isStatic);
+
+    // Builds the static hierarchy over all of the static colliders. Scenes do this once they've loaded, and until
+    // then static colliders are only added to the list. After that, the hierarchy is rebuilt at the start of a step
+    // once the given fraction of its colliders have been added or removed (0 turns the rebuilds off).
+    void    BuildStaticHierarchy();
+    void    SetStaticRebuildFraction(float fraction);
+
     void    EnableDebugLog(bool enable);
     void    EnableDebugDraw(bool enable);
 
 private:
     void    AddColliderToHierarchy(Collider* collider);
     void    RemoveColliderFromHierarchy(Collider* collider);
-
-    int     BroadPhaseCollision(PotentialContact* potentialContacts);
-    int     NarrowPhaseCollision(PotentialContact* potentialContacts, int count, CollisionData* collisionData);
+    void    AddToRegistry(vector<Collider*>& colliders, Collider* collider);
+    void    RemoveFromRegistry(vector<Collider*>& colliders, Collider* collider);
+    void    UpdateBroadPhase(float deltaTime);
+    void    UpdateCollisionPairs();
+    void    UpdateTriggerPairs();
+    void    AddTriggerEvent(CollisionEventType type, GameObject* a, GameObject* b);
+    bool    IsListening(GameObject* a, GameObject* b, CollisionEventType type);
+    Vector3 GetPredictedDisplacement(Collider* collider, float deltaTime);
+
+    int     BroadPhaseCollision(vector<PotentialContact>& potentialContacts, float deltaTime);
+    void    SeparateTriggerPairs(vector<PotentialContact>& potentialContacts);
+    void    AddTriggerChildPairs(Collider* collider, Collider* other);
+    void    TriggerOverlapTests();
+    void    CountNarrowPhaseTests(vector<PotentialContact>& potentialContacts);
+    int     NarrowPhaseCollision(vector<PotentialContact>& potentialContacts, CollisionData* collisionData);
+    int     ParallelNarrowPhaseCollision(vector<PotentialContact>& potentialContacts, CollisionData* collisionData);
 
     void    DrawColliders(vector<Collider*>& colliders, ColorRGB color);
-    void    DrawBoundingSpheres(BVHNode<BoundingSphere>* bvhNode, ColorRGB color);
 
-    BVHNode<BoundingSphere>*    m_staticCollisionHierarchy;
-    vector<Collider*>           m_staticColliders;
+    StaticBVH                   m_staticHierarchy;
+    bool                        m_staticHierarchyBuilt;     // Static colliders are only inserted into the hierarchy once it's been built
+    float                       m_staticRebuildFraction;
+    BroadPhase*                 m_broadPhase;               // Tracks the dynamic colliders
+    vector<Collider*>           m_staticColliders;         // Unordered, so colliders can be removed by swapping in the last one
     vector<Collider*>           m_dynamicColliders;
+    CollisionFilter             m_collisionFilter;          // Applied in the broad phase, before any narrow phase work
 
+    vector<PotentialContact>    m_potentialContacts;        // Cleared every frame, but keeps its capacity
     CollisionData               m_collisionData;
-    vector<CollisionPair>       m_prevCollisionPairs;
+    ContactManifoldCache        m_contactManifolds;         // Keeps contacts between steps, so they build up to full manifolds
+    ContactBufferStats          m_potentialContactStats;
+    ContactBufferStats          m_contactStats;
+    CollisionPairTable          m_collisionPairs;           // Game object pairs in contact as of the last step
+    vector<PotentialContact>    m_triggerContacts;          // This step's pairs with a trigger, cut down to the ones that overlap
+    CollisionPairTable          m_triggerPairs;             // Game object pairs overlapping through a trigger as of the last step
+    vector<CollisionEvent>      m_collisionEvents;          // This step's events, cleared every step but keeps its capacity
+    vector<int>                 m_contactEventIndices;      // Event for each contact in m_collisionData, or -1
+    unsigned int                m_step;
+
+    WorkerPool                  m_narrowPhaseWorkers;
+    vector<CollisionData>       m_threadCollisionData;      // One buffer per narrow phase thread, merged in thread order
+
+    bool                        m_speculativeContacts;      // Contacts are also generated for pairs that could touch during the step
 
     bool                        m_debugLog;
     bool                        m_debugDraw;
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Math/Algebra.h"
+
+class GameObject;
+
+enum CollisionEventType
+{
+    COLLISION_EVENT_ENTER   = 1,
+    COLLISION_EVENT_HOLD    = 2,
+    COLLISION_EVENT_EXIT    = 4,
+    COLLISION_EVENT_ALL     = COLLISION_EVENT_ENTER | COLLISION_EVENT_HOLD | COLLISION_EVENT_EXIT,
+
+    // Overlaps with trigger colliders, which have no contact data
+    TRIGGER_EVENT_ENTER     = 8,
+    TRIGGER_EVENT_EXIT      = 16,
+    TRIGGER_EVENT_ALL       = TRIGGER_EVENT_ENTER | TRIGGER_EVENT_EXIT
+};
+
+// A collision as seen by one of the two game objects, passed to its components' collision callbacks
+struct Collision
+{
+    GameObject*         Other;
+    Vector3             ContactPoint;       // Deepest contact point between the two objects
+    Vector3             ContactNormal;      // Points towards the receiving object
+    float               Impulse;            // Total normal impulse the contact solver applied this step
+    float               Penetration;
+};
+
+// One entry in the collision engine's per-step event buffer. Contact data is from Objects[0]'s
+// perspective, and is left at zero for exit and trigger events.
+struct CollisionEvent
+{
+    CollisionEventType  Type;
+    GameObject*         Objects[2];
+    Vector3             ContactPoint;
+    Vector3             ContactNormal;
+    float               Impulse;
+    float               Penetration;
+};
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Decides which pairs of colliders the broad phase reports, so filtered
+// pairs never reach the narrow phase. Two colliders are paired only if
+// their layers interact, as set by the project's layer matrix, and they
+// don't belong to the same body: colliders on one game object, or on
+// game objects parented under the same rigid body (e.g. objects that have
+// been attached to it), never collide with each other.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Physics/Collider.h"
+#include <vector>
+
+using std::vector;
+
+class CollisionFilter
+{
+public:
+    CollisionFilter();
+
+    // One mask per layer, of the layers it collides with. Layers past the end of the list collide with
+    // everything. A pair of layers only collides if both masks include the other layer.
+    void                SetLayerMasks(const vector<unsigned int>& layerMasks);
+    void                SetLayersCollide(int layerA, int layerB, bool collide);
+    bool                LayersCollide(int layerA, int layerB);
+
+    bool                ShouldCollide(Collider* a, Collider* b);
+
+private:
+    unsigned int        m_layerMasks[MAX_COLLISION_LAYERS];
+};
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// The set of game object pairs that are currently touching, kept from one
+// step to the next so that collision events can be found incrementally.
+// Pairs are stored densely, and an open-addressed (linear probing) index
+// finds a pair by its two object IDs. Removal swaps the last pair into the
+// gap and shifts the probe chain back, so no tombstones build up. Neither
+// array shrinks, so a steady state doesn't allocate.
+//////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#define COLLISION_PAIR_TABLE_INITIAL_SLOTS 256     // Must be a power of two
+
+using std::vector;
+
+class GameObject;
+
+struct CollisionPair
+{
+    CollisionPair();
+    CollisionPair(GameObject* a, GameObject* b);
+
+    GameObject*     gameObjects[2];             // Ordered by ID, so a pair has one entry whichever way round it's reported
+    unsigned int    lastStep;                   // Last step the pair was in contact
+    int             eventIndex;                 // This step's event for the pair, or -1 if nobody listens for it
+};
+
+class CollisionPairTable
+{
+public:
+    CollisionPairTable();
+
+    // Returns the pair's entry, adding it if needed. New entries have a lastStep of 0.
+    CollisionPair*  FindOrAdd(GameObject* a, GameObject* b);
+    CollisionPair*  Find(GameObject* a, GameObject* b);
+
+    // Removes the pair at the given index. The last pair takes its place.
+    void            Remove(unsigned int index);
+    void            Clear();
+
+    unsigned int    GetCount();
+    CollisionPair&  GetPair(unsigned int index);
+
+private:
+    unsigned int    FindSlot(unsigned int idA, unsigned int idB);    // Slot holding the pair, or the empty slot that ends its probe chain
+    unsigned int    GetHomeSlot(unsigned int idA, unsigned int idB);
+    void            Grow();
+
+    vector<CollisionPair>   m_pairs;
+    vector<int>             m_slots;        // Indices into m_pairs, -1 when empty
+};
\ No newline at end of file
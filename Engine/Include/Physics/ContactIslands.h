@@ -0,0 +1,55 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Splits the rigid bodies into islands: groups of bodies that touch each
+// other, directly or through other bodies in the group. Islands are found
+// with union-find over the contacts, and each one can then be solved and
+// put to sleep on its own. Bodies with infinite mass don't join islands,
+// so the ground doesn't connect everything that rests on it.
+//////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+using std::vector;
+
+class RigidBody;
+class RigidBodyContact;
+
+class ContactIslands
+{
+public:
+    ContactIslands();
+
+    struct Island
+    {
+        unsigned int    FirstContact;
+        unsigned int    ContactCount;
+        unsigned int    FirstBody;
+        unsigned int    BodyCount;
+    };
+
+    void                Build(vector<RigidBody*>& bodies, RigidBodyContact* contacts, unsigned int numContacts);
+
+    unsigned int        GetIslandCount();
+    const Island&       GetIsland(unsigned int index);
+
+    // The contacts and bodies of each island are stored contiguously
+    RigidBodyContact*   GetContacts(const Island& island);
+    RigidBody**         GetBodies(const Island& island);
+
+private:
+    int                 Find(int body);
+    void                Union(int a, int b);
+    int                 GetBodyIndex(RigidBody* body);     // -1 if the body isn't registered
+    int                 GetLinkIndex(RigidBody* body);     // -1 if the body can't join an island
+
+    vector<RigidBody*>*         m_inputBodies;
+
+    vector<int>                 m_parent;
+    vector<int>                 m_size;
+    vector<int>                 m_islandOfRoot;
+    vector<int>                 m_contactIsland;
+    vector<Island>              m_islands;
+    vector<RigidBodyContact>    m_contacts;
+    vector<RigidBody*>          m_bodies;
+};
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Persistent contact manifolds. The narrow phase only reports a contact
+// or two per collider pair each step, so the points are cached per pair
+// and kept for as long as the two colliders stay in contact. Every step,
+// cached points are moved along with their colliders and dropped once they
+// separate, slide apart or go unconfirmed for too long. New contacts
+// replace the cached point with the same feature ID (or the nearest one),
+// which keeps that point's accumulated impulses for warm starting. Each
+// manifold keeps up to four points, preferring the deepest point and the
+// widest spread of points.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Math/Algebra.h"
+#include <vector>
+
+#define MAX_MANIFOLD_POINTS 4
+#define MANIFOLD_MATCH_DISTANCE 0.05f       // New contacts this close to a cached point replace it
+#define MANIFOLD_BREAKING_DISTANCE 0.05f    // Cached points are dropped once their colliders separate or slide this far
+#define MANIFOLD_MAX_AGE 30                 // Steps a cached point is kept without the narrow phase reporting it again
+
+using std::vector;
+
+class Collider;
+struct CollisionContact;
+struct CollisionData;
+
+struct ManifoldPoint
+{
+    Vector3             LocalPointA;        // Contact point on each collider, in that collider's local space
+    Vector3             LocalPointB;
+    Vector3             ContactPoint;
+    Vector3             ContactNormal;      // From collider A's perspective, like CollisionContact
+    float               Penetration;
+    unsigned int        FeatureId;
+    int                 Age;                // Steps since the narrow phase last reported this point
+
+    // Accumulated by the contact solver, and used to warm start it the next step
+    float               NormalImpulse;
+    Vector3             TangentImpulse;
+};
+
+struct ContactManifold
+{
+    ContactManifold();
+    ContactManifold(Collider* a, Collider* b);
+
+    Collider*           ColliderA;
+    Collider*           ColliderB;
+    ManifoldPoint       Points[MAX_MANIFOLD_POINTS];
+    int                 PointCount;
+};
+
+class ContactManifoldCache
+{
+public:
+    // Merges this step's contacts into the cached manifolds, then replaces the contents of the
+    // collision data with every manifold point. Pairs that had no contacts this step are dropped.
+    void                Update(CollisionData* data);
+    void                Clear();
+
+    unsigned int        GetManifoldCount();
+
+private:
+    void                RefreshPoints(ContactManifold& manifold);
+    void                AddContact(ContactManifold& manifold, const CollisionContact& contact);
+    int                 FindMatchingPoint(ContactManifold& manifold, const ManifoldPoint& point, bool matchFeature);
+    int                 ChoosePointToReplace(ContactManifold& manifold, const ManifoldPoint& point);
+
+    static bool         ManifoldComparator(const ContactManifold& lhs, const ContactManifold& rhs);
+
+    vector<ContactManifold>     m_manifolds;            // In the order the narrow phase first reported each pair this step
+    vector<ContactManifold>     m_previousManifolds;    // Sorted by collider pair, for lookup
+    vector<CollisionContact>    m_contacts;             // This step's contacts from the narrow phase
+};
\ No newline at end of file
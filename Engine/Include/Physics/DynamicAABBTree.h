@@ -0,0 +1,80 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Persistent bounding volume hierarchy for moving colliders.
+// Leaves store "fat" boxes (enlarged by a margin and by the expected
+// displacement), so a collider only needs to be reinserted when it moves
+// outside of its fat box. The tree is kept balanced with rotations.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Physics/BoundingBox.h"
+#include "Physics/BroadPhase.h"
+#include "Rendering/Color.h"
+#include <vector>
+
+using std::vector;
+
+class Collider;
+struct PotentialContact;
+
+class DynamicAABBTree : public BroadPhase
+{
+public:
+    static const int NULL_NODE = -1;
+
+    DynamicAABBTree();
+
+    virtual void            AddCollider(Collider* collider);
+    virtual void            RemoveCollider(Collider* collider);
+    virtual void            UpdateCollider(Collider* collider, const BoundingBox& box, const Vector3& displacement);
+
+    int                 CreateProxy(Collider* collider, const BoundingBox& box);
+    void                DestroyProxy(int proxy);
+    bool                MoveProxy(int proxy, const BoundingBox& box, const Vector3& displacement);
+
+    Collider*           GetCollider(int proxy);
+    const BoundingBox&  GetFatBox(int proxy);
+    int                 GetHeight();
+
+    // Appends the proxies of all leaves whose fat box overlaps the given box
+    void                Query(const BoundingBox& box, vector<int>& results);
+
+    // Appends all overlapping leaf pairs in the tree to the given buffer
+    virtual unsigned int    GetPotentialContacts(vector<PotentialContact>& contacts, CollisionFilter* filter);
+
+    virtual void            QueryBox(const BoundingBox& box, vector<Collider*>& results);
+    virtual void            QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, BroadPhaseRayCallback* callback);
+
+    virtual void            DrawDebugInfo(ColorRGB color);
+
+    const static float  FAT_BOX_MARGIN;
+    const static float  DISPLACEMENT_MULTIPLIER;
+
+private:
+    struct Node
+    {
+        BoundingBox Box;
+        Collider*   Object;             // This will be NULL for all non-leaf nodes
+        int         Parent;             // Doubles as the "next" index when the node is on the free list
+        int         Children[2];
+        int         Height;             // Leaves have height 0, free nodes have height -1
+        int         LeafIndex;          // Position of this leaf in m_leaves
+
+        bool        IsLeaf() const { return Children[0] == NULL_NODE; }
+    };
+
+    int                 AllocateNode();
+    void                FreeNode(int node);
+
+    void                InsertLeaf(int leaf);
+    void                RemoveLeaf(int leaf);
+    void                RefitAncestors(int node);
+    int                 Balance(int node);
+
+    vector<Node>        m_nodes;
+    vector<int>         m_leaves;           // Proxies of all live leaves, used for pair generation
+    vector<int>         m_queryStack;
+    vector<int>         m_queryResults;
+    int                 m_root;
+    int                 m_freeList;
+};
\ No newline at end of file
@@ -10,14 +10,29 @@ class RigidBody;
 class ForceGenerator
 {
 public:
-    virtual void UpdateForce(RigidBody* body, float deltaTime) = 0;
+    enum ForceGeneratorType
+    {
+        CUSTOM_FORCE_GENERATOR,             // Generators defined outside the engine, which are updated through UpdateForce
+        GRAVITY_GENERATOR,
+        DRAG_GENERATOR,
+        SPRING_GENERATOR,
+        ANCHORED_SPRING_GENERATOR,
+        BUNGEE_GENERATOR,
+        BUOYANCY_GENERATOR,
+        NUM_FORCE_GENERATOR_TYPES
+    };
+
+    virtual ForceGeneratorType  GetType();
+    virtual void                UpdateForce(RigidBody* body, float deltaTime) = 0;
 };
 
+// Gravity for bodies that need something other than the physics engine's global gravity
 class GravityGenerator : public ForceGenerator
 {
 public:
     GravityGenerator(Vector3& gravity);
-    virtual void UpdateForce(RigidBody* body, float deltaTime);
+    virtual ForceGeneratorType  GetType();
+    virtual void                UpdateForce(RigidBody* body, float deltaTime);
 
 private:
     Vector3 m_gravity;
@@ -28,7 +43,8 @@ class DragGenerator : public ForceGenerator
 {
 public:
     DragGenerator(float k1, float k2);
-    virtual void UpdateForce(RigidBody* body, float deltaTime);
+    virtual ForceGeneratorType  GetType();
+    virtual void                UpdateForce(RigidBody* body, float deltaTime);
 
 private:
     float   m_k1;
@@ -43,7 +59,8 @@ public:
                     float restLength,
                     Vector3& connectionPoint,
                     Vector3& otherConnectionPoint);
-    virtual void UpdateForce(RigidBody* body, float deltaTime);
+    virtual ForceGeneratorType  GetType();
+    virtual void                UpdateForce(RigidBody* body, float deltaTime);
 
 private:
     RigidBody*  m_other;
@@ -57,7 +74,8 @@ class AnchoredSpringGenerator : public ForceGenerator
 {
 public:
     AnchoredSpringGenerator(Vector3& anchor, float springConstant, float restLength);
-    virtual void UpdateForce(RigidBody* body, float deltaTime);
+    virtual ForceGeneratorType  GetType();
+    virtual void                UpdateForce(RigidBody* body, float deltaTime);
 
 private:
     Vector3 m_anchor;
@@ -69,7 +87,8 @@ class BungeeGenerator : public ForceGenerator
 {
 public:
     BungeeGenerator(RigidBody* other, float springConstant, float restLength);
-    virtual void UpdateForce(RigidBody* body, float deltaTime);
+    virtual ForceGeneratorType  GetType();
+    virtual void                UpdateForce(RigidBody* body, float deltaTime);
 
 private:
     RigidBody*  m_other;
@@ -81,7 +100,8 @@ class BuoyancyGenerator : public ForceGenerator
 {
 public:
     BuoyancyGenerator(float maxDepth, float volume, float waterHeight, float liquidDensity = 1000.0f);
-    virtual void UpdateForce(RigidBody* body, float deltaTime);
+    virtual ForceGeneratorType  GetType();
+    virtual void                UpdateForce(RigidBody* body, float deltaTime);
 
 private:
     float   m_maxDepth;
@@ -90,11 +110,16 @@ private:
     float   m_liquidDensity;
 };
 
+// Registrations are stored in one array per generator type, so each type is updated in a tight loop
+// without virtual calls. Register returns a handle, which Unregister uses to remove the registration
+// in constant time.
 class ForceRegistry
 {
 public:
-    void    Register(RigidBody* body, ForceGenerator* generator);
-    void    Unregister(RigidBody* body, ForceGenerator* generator);
+    ForceRegistry();
+
+    int     Register(RigidBody* body, ForceGenerator* generator);
+    void    Unregister(int handle);
     void    Clear();
     void    UpdateForces(float deltaTime);
 
@@ -103,9 +128,22 @@ protected:
     {
         RigidBody*      Body;
         ForceGenerator* Generator;
+        int             Handle;
 
-        RegistrationInfo(RigidBody* body, ForceGenerator* generator);
-        bool operator==(const RegistrationInfo &other) const;
+        RegistrationInfo(RigidBody* body, ForceGenerator* generator, int handle);
     };
-    vector<RegistrationInfo> m_registry;
+
+    // Where a handle's registration is stored, or the next free handle if it's not in use
+    struct HandleInfo
+    {
+        int             Type;
+        int             Index;
+    };
+
+    template <class GeneratorType>
+    void    UpdateBatch(vector<RegistrationInfo>& batch, float deltaTime);
+
+    vector<RegistrationInfo>    m_registry[ForceGenerator::NUM_FORCE_GENERATOR_TYPES];
+    vector<HandleInfo>          m_handles;
+    int                         m_firstFreeHandle;
 };
\ No newline at end of file
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <vector>
+#include "Physics/CollisionDetection.h"
+#include "Physics/ContactIslands.h"
 #include "Physics/ForceGenerator.h"
 #include "Physics/RigidBodyContact.h"
+#include "Physics/RigidBodyPool.h"
+#include "Physics/SequentialImpulseSolver.h"
 
-#define MAX_RESOLUTION_ITERATIONS 25
-#define MAX_RIGID_BODY_CONTACTS 25
+#define MAX_RESOLUTION_ITERATIONS 25             // Per island
+#define RESOLUTION_ITERATIONS_PER_CONTACT 4
+#define MAX_RIGID_BODY_CONTACTS 65536     // Safety limit; the contact buffer otherwise grows as needed
 
 using std::vector;
 
@@ -27,20 +32,33 @@ public:
 
     void    UpdateBodies(float deltaTime);
     void    ResolveCollisions(float deltaTime);
+    void    UpdateGameObjects(float interpolation = 1.0f);
 
     void    RegisterRigidBody(RigidBody* rigidBody);
     void    UnregisterRigidBody(RigidBody* rigidBody);
 
-    void    RegisterForce(RigidBody* rigidBody, ForceGenerator* forceGenerator);
-    void    UnregisterForce(RigidBody* rigidBody, ForceGenerator* forceGenerator);
+    int     RegisterForce(RigidBody* rigidBody, ForceGenerator* forceGenerator);   // Returns a handle for UnregisterForce
+    void    UnregisterForce(int handle);
 
-    GravityGenerator*   GetGravityGenerator();
+    Vector3             GetGravity();
+    void                SetGravity(Vector3& gravity);
+    RigidBodyPool&      GetRigidBodyPool();
+
+    const ContactBufferStats&   GetRigidBodyContactStats();
 
 private:
+    bool    IsIslandAsleep(const ContactIslands::Island& island);
+    void    UpdateIslandSleepState(const ContactIslands::Island& island);
+
     vector<RigidBody*>  m_rigidBodies;
+    RigidBodyPool       m_rigidBodyPool;        // State of every rigid body, including ones that aren't registered
     ContactResolver     m_contactResolver;
-    RigidBodyContact    m_rigiBodyContacts[MAX_RIGID_BODY_CONTACTS];
+    SequentialImpulseSolver m_sequentialImpulseSolver;
+    bool                m_useSequentialImpulse;     // Otherwise the worst-first ContactResolver is used
+    ContactIslands      m_contactIslands;
+    vector<RigidBodyContact>    m_rigiBodyContacts;     // Keeps its capacity across frames
+    ContactBufferStats  m_rigidBodyContactStats;
 
     ForceRegistry       m_forceRegistry;
-    GravityGenerator*   m_gravityGenerator;
+    Vector3             m_gravity;              // Applied during integration to every body that uses gravity
 };
\ No newline at end of file
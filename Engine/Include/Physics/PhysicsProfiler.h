@@ -0,0 +1,106 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Always-on counters and wall times for the physics step. The engines
+// add to the current step's stats as they run, and EndStep moves them
+// into a ring buffer of recent steps, which can be read back or summed
+// over. Steps can also be appended to a CSV or JSON lines file as they
+// finish, for profiling longer runs.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Physics/Collider.h"
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define PHYSICS_PROFILER_HISTORY 240        // Steps kept for GetHistoryTotals (four seconds at 60Hz)
+
+using std::string;
+using std::vector;
+
+enum PhysicsPhase
+{
+    PHYSICS_PHASE_FORCES,
+    PHYSICS_PHASE_INTEGRATE,
+    PHYSICS_PHASE_BROAD_PHASE,
+    PHYSICS_PHASE_NARROW_PHASE,
+    PHYSICS_PHASE_MANIFOLDS,                // Contact caching and collision pair tracking
+    PHYSICS_PHASE_ISLANDS,                  // Gathering rigid body contacts and building islands
+    PHYSICS_PHASE_SOLVER,
+    PHYSICS_PHASE_SYNC,                     // Copying rigid body state back to the game objects
+    PHYSICS_PHASE_EVENTS,
+    NUM_PHYSICS_PHASES
+};
+
+typedef std::chrono::high_resolution_clock PhysicsClock;
+
+struct PhysicsStepStats
+{
+    PhysicsStepStats();
+
+    void                Reset();
+    void                Add(const PhysicsStepStats& other);
+
+    unsigned int        GetNarrowPhaseTests() const;
+    unsigned int        GetNarrowPhaseTests(Collider::ColliderType a, Collider::ColliderType b) const;
+    double              GetTotalSeconds() const;
+
+    unsigned int        Step;
+    unsigned int        BroadPhasePairs;
+    unsigned int        NarrowPhaseTests[Collider::NUM_COLLIDER_TYPES][Collider::NUM_COLLIDER_TYPES];  // Lower collider type first
+    unsigned int        Contacts;                   // Generated by the narrow phase
+    unsigned int        TriggerOverlaps;            // Pairs with a trigger that overlap
+    unsigned int        RigidBodyContacts;          // Passed on to the solver
+    unsigned int        Islands;
+    unsigned int        SolvedIslands;              // Islands that had contacts and weren't asleep
+    unsigned int        PositionIterations;         // Summed over the solved islands
+    unsigned int        VelocityIterations;
+    unsigned int        IterationLimitHits;         // Solves that stopped at the iteration limit with contacts left
+    unsigned int        AwakeBodies;
+    unsigned int        AsleepBodies;
+    double              PhaseSeconds[NUM_PHYSICS_PHASES];
+};
+
+class PhysicsProfiler
+{
+public:
+    enum DumpFormat { DUMP_CSV, DUMP_JSON };
+
+    static PhysicsProfiler& Singleton()
+    {
+        static PhysicsProfiler singleton;
+        return singleton;
+    }
+    PhysicsProfiler();
+
+    static const char*      GetPhaseName(PhysicsPhase phase);
+
+    void                    BeginStep();
+    void                    EndStep();
+    PhysicsStepStats&       GetCurrentStep();                   // For the engines to add to while the step runs
+    void                    AddPhaseTime(PhysicsPhase phase, PhysicsClock::time_point start);
+
+    const PhysicsStepStats& GetLastStep();
+    unsigned int            GetHistorySize();
+    const PhysicsStepStats& GetHistory(unsigned int index);     // 0 is the oldest step kept
+    unsigned int            GetHistoryTotals(PhysicsStepStats& totals);     // Returns the number of steps summed
+
+    // Appends every Nth finished step to the file, one CSV row or one JSON object per line.
+    // The file is flushed as it goes, so it stays readable if the game is killed.
+    bool                    StartDump(string path, DumpFormat format, unsigned int stepInterval = 1);
+    void                    StopDump();
+
+private:
+    void                    WriteDumpHeader();
+    void                    WriteDumpRow(const PhysicsStepStats& stats);
+
+    PhysicsStepStats        m_current;
+    vector<PhysicsStepStats>    m_history;                      // Ring buffer
+    unsigned int            m_historyNext;
+    unsigned int            m_step;
+
+    FILE*                   m_dumpFile;
+    DumpFormat              m_dumpFormat;
+    unsigned int            m_dumpInterval;
+};
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Scene queries against the colliders registered with the collision
+// engine: ray casts, sphere casts and sphere overlaps. Static colliders
+// are found through the static bounding volume hierarchy and dynamic
+// colliders through the broad phase, so only colliders near the query
+// are tested in detail. Casts visit nearer volumes first and shorten the
+// ray at every hit, so anything behind the closest hit is skipped.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Math/Algebra.h"
+#include "Physics/Collider.h"
+#include <vector>
+
+using std::vector;
+
+struct RaycastHit
+{
+    RaycastHit();
+
+    Collider*           HitCollider;
+    Vector3             Point;              // Point on the surface of the collider
+    Vector3             Normal;             // Surface normal at the hit point, facing back along the ray
+    float               Distance;           // Distance along the ray (for sphere casts, how far the sphere moved)
+};
+
+class PhysicsQuery
+{
+public:
+    static PhysicsQuery& Singleton()
+    {
+        static PhysicsQuery singleton;
+        return singleton;
+    }
+    PhysicsQuery();
+
+    // Find the closest collider hit within maxDistance, ignoring colliders that already contain the start of
+    // the ray (or that the sphere already overlaps). Only colliders on the layers in the mask are considered.
+    bool            Raycast(Vector3 origin, Vector3 direction, float maxDistance, RaycastHit& hit, unsigned int layerMask = ALL_COLLISION_LAYERS);
+    bool            SphereCast(Vector3 origin, float radius, Vector3 direction, float maxDistance, RaycastHit& hit, unsigned int layerMask = ALL_COLLISION_LAYERS);
+
+    // Appends the colliders that overlap the sphere to the results, and returns how many were added
+    unsigned int    OverlapSphere(Vector3 center, float radius, vector<Collider*>& results, unsigned int layerMask = ALL_COLLISION_LAYERS);
+
+private:
+    bool            OverlapsCollider(Collider* collider);
+
+    SphereCollider  m_querySphere;          // Stands in for the query sphere in the narrow phase tests
+    vector<Collider*>   m_candidates;
+    vector<int>         m_children;         // Children of a compound near the query sphere
+};
\ No newline at end of file
@@ -1,21 +1,23 @@
 #pragma once
 
 #include "Math/Algebra.h"
-#include "Math/Transform.h"
 
 class GameObjectBase;
 class HierarchicalDeserializer;
 class HierarchicalSerializer;
+class RigidBodyPool;
 
+// A handle to a body's state in the physics engine's RigidBodyPool
 class RigidBody
 {
 public:
     RigidBody(GameObjectBase* gameObject);
+    ~RigidBody();
 
     Vector3     GetPosition();
     void        SetPosition(Vector3& position);
 
-    Quaternion& GetRotation();
+    Quaternion  GetRotation();
     void        SetRotation(Quaternion& rotation);
 
     Vector3     GetVelocity();
@@ -40,16 +42,17 @@ public:
     bool        HasFiniteMass();
 
     void        SetInertiaTensor(Matrix3x3& inertiaTensor);
+    void        UpdateInertiaTensor();      // Works the tensor out again from the game object's colliders
 
-    Matrix3x3&  GetInverseIntertiaTensorWorld();
+    Matrix3x3   GetInverseIntertiaTensorWorld();
 
     Vector3     GetPointInLocalSpace(const Vector3& point);
     Vector3     GetPointInWorldSpace(const Vector3& point);
     Vector3     GetDirectionInLocalSpace(const Vector3& direction);
     Vector3     GetDirectionInWorldSpace(const Vector3& direction);
 
-    // Integrates the body forward in time (i.e. updates position and velocity)
-    void        Integrate(float deltaTime);
+    // Remembers the current position/rotation, so rendering can interpolate from it during the next step
+    void        SavePreviousState();
 
     // "AddForce" functions apply and next integration only
 
@@ -76,58 +79,39 @@ public:
     bool        IsAwake();
     void        SetCanSleep(bool canSleep);
     bool        CanSleep();
+    bool        IsBelowSleepThreshold();    // Whether the body has been moving slowly enough to sleep (its island decides)
     void        SetUsesGravity(bool usesGravity);
     bool        UsesGravity();
 
     void        OnCreate();     // TODO there should be a separate rigidbody game component that has this instead
 
-    void        UpdateGameObject();
+    // Copies the body's position/rotation to the game object. An interpolation value below 1 blends
+    // between the state before and after the last physics step.
+    void        UpdateGameObject(float interpolation = 1.0f);
+
+    void        SetIslandIndex(int index);
+    int         GetIslandIndex();
+
+    unsigned int GetPoolIndex();
 
 protected:
-    void        ClearAccumulators();
-    void        CalculateCachedData();
-    void        TransformInertiaTensor(const Quaternion& q, const Matrix3x3& iitLocal, const Matrix4x4 transformWorld, Matrix3x3& iitWorld);
+    Matrix4x4   CalculateWorldMatrix();     // World transform built from the pooled position/rotation
+    const Matrix4x4& GetInverseWorldMatrix();   // Cached, and rebuilt when the pooled position/rotation change
 
     GameObjectBase* m_gameObject;
-    bool            m_isAwake;
-    bool            m_canSleep;                     // Indicates whether object is allowed to sleep (e.g. user controlled objects probably shouldn't sleep ever)
+    RigidBodyPool*  m_pool;
+    unsigned int    m_poolIndex;                    // Position, velocity, etc. are stored in the pool (in world space)
+
     bool            m_isEnabled;                    // Set by game code (default is true)
     bool            m_usesGravity;                  // Set by game code (default is true)
 
-    // Transform values are in world space
-    Vector3         m_position;
-    Quaternion      m_rotation;
-    Vector3         m_velocity;
-    Vector3         m_angularVelocity;
-    Vector3         m_acceleration;
-    Vector3         m_previousAcceleration;         // Tracks only linear acceleration - using angular as well would be more accurate but is unnecessary
-
-    Transform       m_transform;                    // TODO reconcile with go transform
-
-    // Inverse mass is used here instead of simply mass, so that we can represent "infinite" mass (with an
-    // inverse mass of 0), and *cannot* represent zero mass (which we don't want to allow).
-    float           m_inverseMass;
-
-    // This is calculated from the inverse mass, and then cached. It is not set directly.
+    // Inverse mass is stored in the pool, so that we can represent "infinite" mass (with an inverse
+    // mass of 0), and *cannot* represent zero mass (which we don't want to allow). Mass is cached here.
     float           m_mass;
 
-    // Inverse inertia tensor is used here for similar reasons to why inverse mass is used (see above).
-    // Given in local space.
-    Matrix3x3       m_inverseInertiaTensor;
-
-    // IIT in world space (calculated and cached)
-    Matrix3x3       m_inverseInertiaTensorWorld;
-
-    Vector3         m_accumulatedForce;
-    Vector3         m_accumulatedTorque;
-
-    // Recency-weighted mean that's used to determine when an object should sleep
-    float           m_motion;
-
-    // Damping is required to remove energy added from numerical instability in physics integration step.
-    const float     LINEAR_DAMPING = 0.999f;
-    const float     ANGULAR_DAMPING = 0.999f;
+    int             m_islandIndex;                  // Scratch index used by ContactIslands
 
-    const float     SLEEP_EPSILON = 0.6f;    // TODO physics: this needs tuning
-    const float     MOTION_RWA_BIAS = 0.1f;     // TODO physics: this needs tuning
+    Matrix4x4       m_inverseWorldMatrix;
+    Vector3         m_inversePosition;              // Position/rotation the inverse world matrix was built from
+    Quaternion      m_inverseRotation;
 };
\ No newline at end of file
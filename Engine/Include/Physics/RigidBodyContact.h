@@ -3,6 +3,7 @@
 #include "Math/Algebra.h"
 
 class RigidBody;
+struct ManifoldPoint;
 
 // A RigidBodyContact represents two (rigid body) objects in contact.
 //
@@ -20,6 +21,7 @@ class RigidBody;
 class RigidBodyContact
 {
 friend class ContactResolver;
+friend class SequentialImpulseSolver;
 
 public:
 
@@ -38,6 +40,8 @@ public:
     float               Penetration;                                // The depth of penetration at the contact
     float               Friction;                                   // The lateral friction coefficient at the contact
 
+    ManifoldPoint*      CachedPoint;                                // Persistent manifold point, which holds accumulated impulses across steps (may be NULL)
+
 protected:
     const static float  MIN_VELOCITY_LIMIT;
 
@@ -70,10 +74,17 @@ public:
     void                SetMaxIterations(unsigned int maxIterations);
     void                ResolveContacts(RigidBodyContact* contacts, unsigned int numContacts, float deltaTime);
 
+    // Iterations the last ResolveContacts took, and whether it stopped at the limit with contacts left
+    unsigned int        GetPositionIterationsUsed();
+    unsigned int        GetVelocityIterationsUsed();
+    bool                HitIterationLimit();
+
 protected:
     void                PrepareContacts(RigidBodyContact* contacts, unsigned int numContacts, float deltaTime);
     void                AdjustPositions(RigidBodyContact* contacts, unsigned int numContacts, float deltaTime);
     void                AdjustVelocities(RigidBodyContact* contacts, unsigned int numContacts, float deltaTime);
 
     unsigned int        m_maxIterations;
+    unsigned int        m_positionIterationsUsed;
+    unsigned int        m_velocityIterationsUsed;
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Rigid body state, stored as a structure of arrays: one array per float
+// component, indexed by body slot. Integration runs over four bodies at a
+// time with SSE (eight with AVX). Slots never move, so a body's index stays
+// valid until it is released, and RigidBody is just a handle to its slot.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Math/Algebra.h"
+#include <vector>
+
+using std::vector;
+
+#define RIGID_BODY_POOL_SIMD_WIDTH 8    // Capacity is always a multiple of this, so the kernel needs no tail loop
+
+// Damping is required to remove energy added from numerical instability in physics integration step.
+#define RIGID_BODY_LINEAR_DAMPING 0.999f
+#define RIGID_BODY_ANGULAR_DAMPING 0.999f
+
+#define RIGID_BODY_SLEEP_EPSILON 0.6f       // TODO physics: this needs tuning
+#define RIGID_BODY_MOTION_RWA_BIAS 0.1f     // TODO physics: this needs tuning
+
+class RigidBodyPool
+{
+public:
+    // Each stream holds one float component for every slot. Vector and matrix fields take up
+    // consecutive streams (x/y/z, r/i/j/k, or row-major 3x3).
+    enum Stream
+    {
+        POSITION                = 0,
+        ROTATION                = 3,
+        PREVIOUS_POSITION       = 7,        // State at the start of the last step, for interpolation
+        PREVIOUS_ROTATION       = 10,
+        VELOCITY                = 14,
+        ANGULAR_VELOCITY        = 17,
+        ACCELERATION            = 20,
+        PREVIOUS_ACCELERATION   = 23,       // Linear acceleration used by the last step, including forces
+        ACCUMULATED_FORCE       = 26,
+        ACCUMULATED_TORQUE      = 29,
+        INVERSE_INERTIA_LOCAL   = 32,
+        INVERSE_INERTIA_WORLD   = 41,
+        INVERSE_MASS            = 50,
+        MOTION                  = 51,       // Recency-weighted mean that's used to determine when a body should sleep
+        AWAKE                   = 52,       // Flags are stored as 0 or 1
+        CAN_SLEEP               = 53,       // User controlled bodies probably shouldn't ever sleep
+        SIMULATED               = 54,       // Set while the body is registered with the physics engine
+        USES_GRAVITY            = 55,
+        NUM_STREAMS             = 56
+    };
+
+    RigidBodyPool();
+
+    unsigned int    Allocate();
+    void            Release(unsigned int index);
+    unsigned int    GetCapacity();
+
+    float           GetScalar(unsigned int index, Stream stream);
+    void            SetScalar(unsigned int index, Stream stream, float value);
+    Vector3         GetVector(unsigned int index, Stream stream);
+    void            SetVector(unsigned int index, Stream stream, const Vector3& v);
+    void            AddVector(unsigned int index, Stream stream, const Vector3& v);
+    Quaternion      GetQuaternion(unsigned int index, Stream stream);
+    void            SetQuaternion(unsigned int index, Stream stream, const Quaternion& q);
+    Matrix3x3       GetMatrix(unsigned int index, Stream stream);
+    void            SetMatrix(unsigned int index, Stream stream, const Matrix3x3& m);
+
+    // Saves the previous state of every slot, then integrates the bodies that are simulated and awake.
+    // Gravity is added to the acceleration of bodies that use it and have finite mass.
+    void            Integrate(float deltaTime, const Vector3& gravity);
+
+    // Normalizes the rotation and recomputes the world space inverse inertia tensor for one body
+    void            CalculateCachedData(unsigned int index);
+
+private:
+    void            ResetSlot(unsigned int index);
+
+    vector<float>           m_streams[NUM_STREAMS];
+    vector<unsigned int>    m_freeSlots;
+};
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Sequential impulse (projected Gauss-Seidel) contact solver. Every
+// iteration visits each contact once and applies the impulse that brings
+// its relative velocity to the target, clamping the accumulated impulse so
+// the normal impulse only ever pushes, and friction stays inside the
+// friction cone. Penetration is removed with split impulses: a second
+// solve on pseudo velocities that move the bodies apart without adding to
+// their real velocities, so resting contacts don't bounce. Impulses are
+// stored in the contacts' persistent manifold points, and used to warm
+// start the next step, so resting contacts converge in a few iterations.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Math/Algebra.h"
+#include <vector>
+
+using std::vector;
+
+#define SEQUENTIAL_IMPULSE_ITERATIONS 10
+#define SEQUENTIAL_IMPULSE_POSITION_CORRECTION 0.4f         // Fraction of the penetration removed per step
+#define SEQUENTIAL_IMPULSE_PENETRATION_SLOP 0.01f           // Penetration that is left alone, so resting contacts stay touching
+#define SEQUENTIAL_IMPULSE_RESTITUTION_THRESHOLD 1.0f       // Closing speed below which contacts don't bounce
+#define SEQUENTIAL_IMPULSE_CONVERGENCE_THRESHOLD 0.0001f    // A solve stops early once no impulse changes by more than this in an iteration
+
+class RigidBody;
+class RigidBodyContact;
+struct ManifoldPoint;
+
+class SequentialImpulseSolver
+{
+public:
+    SequentialImpulseSolver(unsigned int iterations);
+
+    void                SetIterations(unsigned int iterations);
+
+    // Iterations the last ResolveContacts ran, which is fewer than the limit if a solve converged early
+    unsigned int        GetPositionIterationsUsed();
+    unsigned int        GetVelocityIterationsUsed();
+
+    void                ResolveContacts(RigidBodyContact* contacts, unsigned int numContacts, float deltaTime);
+
+private:
+    struct Constraint
+    {
+        RigidBody*      Body[2];                // Body[1] may be NULL
+        int             BodyIndex[2];           // Index into the pseudo velocities, or -1 for bodies that can't move
+        float           InverseMass[2];         // Zero for missing bodies and bodies with infinite mass
+        Matrix3x3       InverseInertia[2];
+        Vector3         RelativePosition[2];    // Contact point relative to each body, in world space
+        Vector3         Normal;
+        Vector3         Tangent[2];
+        float           NormalMass;             // Effective mass along each axis
+        float           TangentMass[2];
+        float           Bias;                   // Target separating velocity, from restitution
+        float           PositionBias;           // Target separating pseudo velocity, from penetration
+        float           Friction;
+        float           NormalImpulse;          // Accumulated over the step
+        float           TangentImpulse[2];
+        float           PositionImpulse;
+        ManifoldPoint*  CachedPoint;            // Where the impulses are kept between steps (may be NULL)
+    };
+
+    void                PrepareConstraint(RigidBodyContact& contact, Constraint& constraint, float deltaTime);
+    void                WarmStart(Constraint& constraint);
+    float               SolveConstraint(Constraint& constraint);            // Both return the largest change in the accumulated impulses
+    float               SolvePositionConstraint(Constraint& constraint);
+    void                StoreImpulse(Constraint& constraint);
+
+    Vector3             GetRelativeVelocity(Constraint& constraint);
+    float               GetEffectiveMass(Constraint& constraint, const Vector3& axis);
+    void                ApplyImpulse(Constraint& constraint, const Vector3& impulse);
+    void                ApplyPositionImpulse(Constraint& constraint, const Vector3& impulse);
+    void                ApplyPseudoVelocities(float deltaTime);
+
+    unsigned int            m_iterations;
+    unsigned int            m_positionIterationsUsed;
+    unsigned int            m_velocityIterationsUsed;
+    vector<Constraint>      m_constraints;
+    vector<RigidBody*>      m_bodies;               // Bodies that can move, sorted so constraints can find their index
+    vector<Vector3>         m_pseudoVelocities;
+    vector<Vector3>         m_pseudoAngularVelocities;
+};
\ No newline at end of file
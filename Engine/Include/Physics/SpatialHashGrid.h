@@ -0,0 +1,71 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Uniform grid broad phase, for large numbers of similarly sized
+// colliders. Each collider is placed in the one cell that contains its
+// center, so pairs are found by looking at neighboring cells only.
+// Occupied cells are stored in an open-addressed hash table that is
+// rebuilt every frame, and colliders that are too big to fit in a
+// single cell are kept in a fallback list and tested against everything.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Physics/BroadPhase.h"
+#include <vector>
+
+using std::vector;
+
+class SpatialHashGrid : public BroadPhase
+{
+public:
+    SpatialHashGrid(float cellSize = 0.0f);     // A cell size of 0 means it is derived from the collider sizes
+
+    virtual void            AddCollider(Collider* collider);
+    virtual void            RemoveCollider(Collider* collider);
+    virtual void            UpdateCollider(Collider* collider, const BoundingBox& box, const Vector3&);     // Ignores the displacement
+
+    virtual unsigned int    GetPotentialContacts(vector<PotentialContact>& contacts, CollisionFilter* filter);
+
+    virtual void            QueryBox(const BoundingBox& box, vector<Collider*>& results);
+    virtual void            QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, BroadPhaseRayCallback* callback);
+
+    virtual void            DrawDebugInfo(ColorRGB color);
+
+    float                   GetCellSize();
+
+    const static float      AUTO_CELL_SIZE_SCALE;
+
+private:
+    struct Proxy
+    {
+        BoundingBox Box;
+        Collider*   Object;             // NULL if this proxy is on the free list
+        int         LiveIndex;          // Position in m_liveProxies, so it can be removed by swapping in the last one
+        int         Cell[3];
+    };
+
+    struct Cell
+    {
+        int         Coords[3];
+        int         First;              // Index of the first proxy of this cell in m_cellProxies
+        int         Count;              // Number of proxies in this cell (0 if the slot is empty)
+    };
+
+    void                    CalculateAutoCellSize();
+    void                    BuildCells();
+    int                     FindCell(int x, int y, int z);
+    int                     FindOrAddCell(int x, int y, int z);
+    unsigned int            HashCoords(int x, int y, int z);
+
+    vector<Proxy>           m_proxies;
+    vector<int>             m_freeProxies;
+    vector<int>             m_liveProxies;
+    vector<int>             m_fallbackProxies;
+
+    vector<Cell>            m_cells;            // Open-addressed hash table (size is a power of two)
+    vector<int>             m_occupiedCells;
+    vector<int>             m_cellProxies;      // Proxies grouped contiguously by cell
+
+    float                   m_cellSize;
+    bool                    m_autoCellSize;
+    bool                    m_cellSizeDirty;
+};
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Bounding volume hierarchy over the static colliders. It's built top
+// down with the surface area heuristic once a scene has loaded, and kept
+// as a flat array of 32 byte nodes (a box plus two indices), with the two
+// children of a node stored next to each other so that only the first
+// needs an index. Colliders added or removed after the build are linked
+// in or out in place and the boxes above them refit, which is cheap but
+// lowers the tree's quality, so the owner can rebuild it once enough of
+// it has changed. Queries walk the tree with an explicit stack.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Physics/BoundingBox.h"
+#include "Rendering/Color.h"
+#include <vector>
+
+#define STATIC_BVH_SAH_BINS 12          // Candidate split planes per axis, less one
+#define STATIC_BVH_SAH_MAX_DEPTH 32     // Below this depth, nodes are split at the median to bound the tree's depth
+
+using std::vector;
+
+class BroadPhaseRayCallback;
+class Collider;
+class CollisionFilter;
+struct PotentialContact;
+
+class StaticBVH
+{
+public:
+    StaticBVH();
+
+    // Replaces the tree with one built over the given colliders
+    void                Build(const vector<Collider*>& colliders);
+    void                Clear();
+
+    // Links a collider into the tree or out of it, refitting the boxes above it. Both take O(log n) in a balanced tree.
+    void                Insert(Collider* collider);
+    void                Remove(Collider* collider);
+
+    // Colliders inserted or removed since the last build
+    unsigned int        GetChangeCount();
+    unsigned int        GetColliderCount();
+
+    // Appends the potential contacts between a collider outside the tree, with the given bounds, and the colliders in
+    // the tree that the filter accepts (all of them if it's NULL). Returns how many were added.
+    unsigned int        GetPotentialContacts(Collider* collider, const BoundingBox& box, vector<PotentialContact>& contacts, CollisionFilter* filter);
+
+    // Scene queries, as for the broad phase. Rays visit the nearer child first, so that the callback can shorten the
+    // ray before the farther one is tested, and the shortened max distance is returned.
+    void                QueryBox(const BoundingBox& box, vector<Collider*>& results);
+    float               QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, BroadPhaseRayCallback* callback);
+
+    void                DrawDebugInfo(ColorRGB color);
+
+private:
+    struct Node
+    {
+        BoundingBox     Box;
+        int             Child;          // Inner nodes: the first of the two children. Leaves: -1.
+        int             Parent;         // -1 for the root, which is always node 0
+
+        bool            IsLeaf() const { return Child < 0; }
+    };
+
+    void                BuildNode(int index, int begin, int end, int depth, vector<BoundingBox>& bounds, vector<Vector3>& centroids,
+                                  vector<int>& order, const vector<Collider*>& colliders);
+    void                SetLeaf(int index, const BoundingBox& box, Collider* collider);
+    int                 AllocatePair(int parent);
+    void                Refit(int index);
+
+    vector<Node>        m_nodes;
+    vector<Collider*>   m_colliders;    // By node, NULL for inner nodes and free nodes. Kept apart so the nodes stay small.
+    vector<int>         m_freePairs;    // First node of each pair that was freed by a removal
+    vector<int>         m_stack;        // Traversal stack, kept to save allocations
+    unsigned int        m_colliderCount;
+    unsigned int        m_changeCount;
+};
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Incremental sweep-and-prune (sort and sweep) broad phase.
+// Box endpoints are kept sorted along the axis along which colliders are
+// spread out the most (e.g. the ground plane axes in a flat level), and
+// pairs are generated by sweeping that axis. Boxes are enlarged by a
+// margin and by the predicted displacement, like DynamicAABBTree's, so
+// their endpoints only change when a collider leaves its box. When they
+// do change, the list is nearly sorted and insertion sort brings it back
+// in order in close to linear time.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Physics/BroadPhase.h"
+#include <vector>
+
+using std::vector;
+
+class SweepAndPrune : public BroadPhase
+{
+public:
+    SweepAndPrune();
+
+    virtual void            AddCollider(Collider* collider);
+    virtual void            RemoveCollider(Collider* collider);
+    virtual void            UpdateCollider(Collider* collider, const BoundingBox& box, const Vector3& displacement);
+
+    virtual unsigned int    GetPotentialContacts(vector<PotentialContact>& contacts, CollisionFilter* filter);
+
+    virtual void            QueryBox(const BoundingBox& box, vector<Collider*>& results);
+    virtual void            QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, BroadPhaseRayCallback* callback);
+
+    virtual void            DrawDebugInfo(ColorRGB color);
+
+    const static float      FAT_BOX_MARGIN;
+    const static float      DISPLACEMENT_MULTIPLIER;
+
+private:
+    struct Endpoint
+    {
+        float       Value;
+        int         Proxy;
+        bool        IsMin;
+    };
+
+    struct Proxy
+    {
+        BoundingBox Box;
+        Collider*   Object;             // NULL if this proxy is on the free list
+        int         ActiveIndex;        // Position in the active list during a sweep (-1 if not active)
+    };
+
+    void                    RefreshEndpoints();
+    void                    SortEndpoints();
+    int                     ChooseSweepAxis();
+
+    vector<Proxy>           m_proxies;
+    vector<int>             m_freeProxies;
+    vector<Endpoint>        m_endpoints;        // Along the sweep axis
+    vector<int>             m_active;
+    int                     m_proxyCount;
+    int                     m_sweepAxis;
+    bool                    m_endpointsDirty;   // Set when a box changed or endpoints were added since the last sort
+};
\ No newline at end of file
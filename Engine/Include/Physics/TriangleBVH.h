@@ -0,0 +1,59 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Static bounding volume hierarchy over the triangles of a mesh, built
+// once in the mesh's model space. Splits are chosen with the surface area
+// heuristic over a few bins per axis. Nodes are stored depth first in a
+// flat array, so the first child of an inner node is always the next node
+// and only the second child needs an index. The triangle vertices are
+// copied into leaf order, so the triangles of a leaf sit next to each other.
+//////////////////////////////////////////////////////////////////////////
+
+#include "Physics/BoundingBox.h"
+#include <vector>
+
+#define TRIANGLE_BVH_LEAF_SIZE 4        // Nodes with this many triangles or fewer are not split
+#define TRIANGLE_BVH_MAX_LEAF_SIZE 16   // Nodes with more triangles than this are split even if the split costs more
+#define TRIANGLE_BVH_SAH_BINS 12        // Candidate split planes per axis, less one
+#define TRIANGLE_BVH_SAH_MAX_DEPTH 32   // Below this depth, nodes are split at the median to bound the tree's depth
+#define TRIANGLE_BVH_MAX_DEPTH 64       // Size of the traversal stack
+
+using std::vector;
+
+class TriangleBVH
+{
+public:
+    TriangleBVH(const vector<Vector3>& positions, const vector<unsigned int>& indices);
+
+    // Appends the triangles whose bounds overlap the given box, which is given in model space.
+    // Doesn't modify the tree, so it's safe to query from several threads at once.
+    void                Query(const BoundingBox& box, vector<int>& results) const;
+
+    // Finds the closest triangle the ray hits within maxDistance. The ray is given in model space, and the
+    // distance is measured in multiples of the direction, so the direction doesn't need to be normalized.
+    bool                Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, float& hitDistance, int& hitTriangle) const;
+
+    // Appends the triangles whose bounds, grown by the margin, the ray passes through within maxDistance
+    void                QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, vector<int>& results) const;
+
+    int                 GetTriangleCount() const;
+    void                GetTriangle(int index, Vector3* triangle) const;
+    const BoundingBox&  GetBounds() const;
+
+private:
+    struct Node
+    {
+        BoundingBox     Box;
+        int             Start;          // Leaves: first triangle. Inner nodes: index of the second child.
+        int             Count;          // Number of triangles in a leaf, 0 for inner nodes
+
+        bool            IsLeaf() const { return Count > 0; }
+    };
+
+    static bool         IntersectTriangle(const Vector3& origin, const Vector3& direction, const Vector3* triangle, float& distance);
+
+    void                BuildNode(int begin, int end, int depth, vector<BoundingBox>& bounds, vector<Vector3>& centroids, vector<int>& order);
+
+    vector<Node>        m_nodes;
+    vector<Vector3>     m_vertices;     // Three per triangle, in leaf order
+};
\ No newline at end of file
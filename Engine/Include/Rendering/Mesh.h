@@ -11,6 +11,7 @@
 
 class Material;
 class ResourceInfo;
+class TriangleBVH;
 
 class Mesh : public Resource
 {
@@ -25,6 +26,9 @@ public:
     int     GetTriangleCount();
     void    GetTriangle(int index, Vector3* triangle);
 
+    // Built the first time it's requested, then kept for as long as the mesh is loaded
+    TriangleBVH*    GetTriangleBVH();
+
 private:
     void    CalculateBoundingRadius(std::vector<Vector3>& vertices);
 
@@ -37,10 +41,13 @@ private:
     GLsizei     m_vertexCount;
     GLsizei     m_indexedVertexCount;
     bool        m_hasUVs;
+    bool        m_uploaded;     // False if the GL buffers were never created (headless mode)
 
     std::vector<Vector3> m_positions;
     std::vector<GLuint>  m_indices;
 
     GLenum      m_drawMode;
     float       m_boundingRadius;
+
+    TriangleBVH*    m_triangleBVH;
 };
\ No newline at end of file
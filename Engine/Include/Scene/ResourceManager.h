@@ -31,6 +31,7 @@ public:
     virtual void        Unload();
     virtual string      TypeName() = 0;
     virtual void        AddToGameObject(ToolsideGameObject* gameObject) = 0;
+    virtual bool        RequiresRenderer() { return false; }     // Resources that can't be loaded in headless mode
 
     bool                operator<(const ResourceInfo& other) const;
 
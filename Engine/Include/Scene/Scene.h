@@ -31,6 +31,7 @@ public:
     ToolsideGameObject* GetToolsideRootObject();
 
     bool                IsLoaded();
+    string              GetFilename();
 
 private:
     Scene();
@@ -43,7 +44,7 @@ private:
     void                SaveMaterial(HierarchicalSerializer* serializer, ToolsideGameObject* gameObject, unordered_set<unsigned int>& guids);
     void                SaveMaterialColors(HierarchicalSerializer* serializer, Material* material);
     void                SaveMaterialTextures(HierarchicalSerializer* serializer, Material* material, unordered_set<unsigned int>& guids);
-    void                SaveColliders(HierarchicalSerializer* serializer, ToolsideGameObject* gameObject);
+    void                SaveColliders(HierarchicalSerializer* serializer, ToolsideGameObject* gameObject, unordered_set<unsigned int>& guids);
     void                SaveRigidBodies(HierarchicalSerializer* serializer, ToolsideGameObject* gameObject);
     void                SaveComponents(HierarchicalSerializer* serializer, ToolsideGameObject* gameObject, unordered_set<unsigned int>& guids);
     void                SaveResourceList(HierarchicalSerializer* serializer, unordered_set<unsigned int>& guids);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+// A piece of work that can be split into index ranges and run on several threads at once
+class WorkerJob
+{
+public:
+    virtual ~WorkerJob() {}
+    virtual void Run(unsigned int threadIndex, unsigned int begin, unsigned int end) = 0;
+};
+
+// A fixed set of worker threads. The calling thread takes part in every job as thread 0,
+// so a pool started with a single thread runs everything inline.
+class WorkerPool
+{
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    void            Startup(unsigned int threadCount);      // 0 = one thread per hardware core
+    void            Shutdown();
+
+    unsigned int    GetThreadCount();
+
+    // Splits [0, count) into one contiguous range per thread and blocks until every range has run.
+    // Range i always goes to thread index i, so per-thread results can be merged in a fixed order.
+    void            Run(WorkerJob* job, unsigned int count);
+
+private:
+    void            WorkerMain(unsigned int threadIndex);
+    void            RunRange(unsigned int threadIndex);
+
+    vector<std::thread>     m_threads;
+    std::mutex              m_mutex;
+    std::condition_variable m_jobPosted;
+    std::condition_variable m_jobFinished;
+
+    WorkerJob*              m_job;
+    unsigned int            m_count;
+    unsigned int            m_threadCount;
+    unsigned int            m_generation;       // Bumped for every job, so workers can tell a new one was posted
+    unsigned int            m_workersBusy;
+    bool                    m_shuttingDown;
+};
\ No newline at end of file
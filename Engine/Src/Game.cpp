@@ -1,6 +1,7 @@
 #include "Game.h"
 
 #include <chrono>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <thread>
@@ -10,6 +11,7 @@
 #include "Input\XInputGamePad.h"
 #include "Physics\CollisionEngine.h"
 #include "Physics\PhysicsEngine.h"
+#include "Physics\PhysicsProfiler.h"
 #include "Rendering\RenderManager.h"
 #include "Scene\ResourceManager.h"
 #include "Scene\Scene.h"
@@ -17,17 +19,39 @@
 #include "GameObjectManager.h"
 #include "GameProject.h"
 
-void Game::Init(string projectPath, GameComponentFactory* componentFactory)
+typedef std::chrono::high_resolution_clock HeadlessClock;
+
+static double SecondsSince(HeadlessClock::time_point start)
+{
+    return std::chrono::duration<double>(HeadlessClock::now() - start).count();
+}
+
+static string JsonEscape(string value)
+{
+    string ret;
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        if (value[i] == '\\' || value[i] == '"')
+        {
+            ret += '\\';
+        }
+        ret += value[i];
+    }
+    return ret;
+}
+
+void Game::Init(string projectPath, GameComponentFactory* componentFactory, bool headless)
 {
     printf("=============== GAME INIT ===============\n");
 
     srand((unsigned int)time(NULL));
+    m_headless = headless;
 
     // Resource setup
     ResourceManager::Singleton().Startup();
 
     // Project setup
-    GameProject::Singleton().Startup();
+    GameProject::Singleton().Startup(false, headless);
     bool success = GameProject::Singleton().Load(projectPath);
     if (!success)
         return;
@@ -40,7 +64,10 @@ void Game::Init(string projectPath, GameComponentFactory* componentFactory)
     // Window setup
     int windowWidth, windowHeight;
     GameProject::Singleton().GetResolution(windowWidth, windowHeight);
-    m_gameWindow.Setup(GameProject::Singleton().GetName(), windowWidth, windowHeight);
+    if (!m_headless)
+    {
+        m_gameWindow.Setup(GameProject::Singleton().GetName(), windowWidth, windowHeight);
+    }
 
     // Physics setup
     if (GameProject::Singleton().GetPhysicsSettings().Enabled)
@@ -50,10 +77,13 @@ void Game::Init(string projectPath, GameComponentFactory* componentFactory)
     }
 
     // Rendering setup
-    RenderManager::Singleton().Startup(windowWidth, windowHeight);
+    if (!m_headless)
+    {
+        RenderManager::Singleton().Startup(windowWidth, windowHeight);
+    }
 
-    // Input setup
-    InputManager::Singleton().Startup(&m_gameWindow);
+    // Input setup (with no window, keyboard and mouse always read as released)
+    InputManager::Singleton().Startup(m_headless ? NULL : &m_gameWindow);
     XInputGamepad* xbox360controller = new XInputGamepad(0);            // TODO make this configurable
     InputManager::Singleton().EnableGamePad(xbox360controller, 0);
 
@@ -75,28 +105,28 @@ void Game::Run(Scene* scene)
     m_timeSinceFPSSnapshot = 0;
     m_framesSinceFPSSnapshot = 0;
 
-    int framesSinceLastPhysicsUpdate = 0;
-    int physicsUpdateInterval = 0;          // Set > 1 to slow down physics for easier debugging
-    bool physicsEnabled = GameProject::Singleton().GetPhysicsSettings().Enabled;
+    // Physics time setup
+    GameProject::PhysicsSettings& physicsSettings = GameProject::Singleton().GetPhysicsSettings();
+    m_physicsTimeStep = 1 / (float)physicsSettings.StepRate;
+    m_maxPhysicsSteps = physicsSettings.MaxStepsPerFrame;
+    m_physicsAccumulator = 0;
+
+    float physicsTimeScale = 1.0f;          // Set < 1 to slow down physics for easier debugging
+    bool physicsEnabled = physicsSettings.Enabled;
 
     // Game loop!
     while (!m_gameWindow.ShouldClose())
     {
-        framesSinceLastPhysicsUpdate++;
-
         // Input update
         InputManager::Singleton().PollEvents(m_deltaTime);
 
         // Game Object update
         GameObjectManager::Singleton().Update(m_deltaTime);
 
-        if (physicsEnabled && framesSinceLastPhysicsUpdate > physicsUpdateInterval)
+        if (physicsEnabled)
         {
             // Physics update
-            PhysicsEngine::Singleton().UpdateBodies(m_deltaTime);
-            CollisionEngine::Singleton().CalculateCollisions(m_deltaTime);       // TODO fixed physics timestep?
-            PhysicsEngine::Singleton().ResolveCollisions(m_deltaTime);
-            framesSinceLastPhysicsUpdate = 0;
+            UpdatePhysics(m_deltaTime * physicsTimeScale);
         }
 
         // Rendering update
@@ -106,25 +136,180 @@ void Game::Run(Scene* scene)
         UpdateTime();
     }
 
+    Shutdown();
+    exit(EXIT_SUCCESS);
+}
+
+void Game::RunHeadless(Scene* scene, int frameCount, FILE* output)
+{
+    printf("\n=============== GAME RUN (HEADLESS) ===============\n");
+
+    m_rootObject = scene->GetRuntimeRootObject();
+
+    // Every frame is exactly one physics step, so results don't depend on how fast the machine is
+    GameProject::PhysicsSettings& physicsSettings = GameProject::Singleton().GetPhysicsSettings();
+    float timeStep = 1 / (float)physicsSettings.StepRate;
+    bool physicsEnabled = physicsSettings.Enabled;
+
+    double gameObjectTime = 0;
+    double integrateTime = 0;
+    double collisionTime = 0;
+    double resolveTime = 0;
+    double potentialContactTotal = 0;
+    double contactTotal = 0;
+
+    HeadlessClock::time_point runStart = HeadlessClock::now();
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        HeadlessClock::time_point phaseStart = HeadlessClock::now();
+        GameObjectManager::Singleton().Update(timeStep);
+        gameObjectTime += SecondsSince(phaseStart);
+
+        if (!physicsEnabled)
+            continue;
+
+        PhysicsProfiler::Singleton().BeginStep();
+
+        phaseStart = HeadlessClock::now();
+        PhysicsEngine::Singleton().UpdateBodies(timeStep);
+        integrateTime += SecondsSince(phaseStart);
+
+        phaseStart = HeadlessClock::now();
+        CollisionEngine::Singleton().CalculateCollisions(timeStep);
+        collisionTime += SecondsSince(phaseStart);
+
+        phaseStart = HeadlessClock::now();
+        PhysicsEngine::Singleton().ResolveCollisions(timeStep);
+        CollisionEngine::Singleton().DispatchCollisionEvents();
+        resolveTime += SecondsSince(phaseStart);
+
+        PhysicsProfiler::Singleton().EndStep();
+        potentialContactTotal += CollisionEngine::Singleton().GetPotentialContactStats().Count;
+        contactTotal += CollisionEngine::Singleton().GetContactStats().Count;
+    }
+    double totalTime = SecondsSince(runStart);
+
+    // Report
+    const ContactBufferStats& potentialStats = CollisionEngine::Singleton().GetPotentialContactStats();
+    const ContactBufferStats& contactStats = CollisionEngine::Singleton().GetContactStats();
+    const ContactBufferStats& rigidBodyStats = PhysicsEngine::Singleton().GetRigidBodyContactStats();
+    double frames = frameCount > 0 ? (double)frameCount : 1.0;
+
+    // The profiler only keeps the most recent steps, so its averages cover the end of the run
+    PhysicsStepStats recent;
+    unsigned int recentSteps = PhysicsProfiler::Singleton().GetHistoryTotals(recent);
+    double steps = recentSteps > 0 ? (double)recentSteps : 1.0;
+
+    fprintf(output, "{\n");
+    fprintf(output, "    \"project\": \"%s\",\n", JsonEscape(GameProject::Singleton().GetName()).c_str());
+    fprintf(output, "    \"scene\": \"%s\",\n", JsonEscape(scene->GetFilename()).c_str());
+    fprintf(output, "    \"broad-phase\": %d,\n", (int)physicsSettings.BroadPhase);
+    fprintf(output, "    \"step-rate\": %d,\n", physicsSettings.StepRate);
+    fprintf(output, "    \"narrow-phase-threads\": %u,\n", CollisionEngine::Singleton().GetNarrowPhaseThreadCount());
+    fprintf(output, "    \"contact-solver\": %d,\n", (int)physicsSettings.ContactSolver);
+    fprintf(output, "    \"speculative-contacts\": %s,\n", physicsSettings.SpeculativeContacts ? "true" : "false");
+    fprintf(output, "    \"frames\": %d,\n", frameCount);
+    fprintf(output, "    \"total-seconds\": %f,\n", totalTime);
+    fprintf(output, "    \"steps-per-second\": %f,\n", totalTime > 0 ? frameCount / totalTime : 0.0);
+    fprintf(output, "    \"average-ms\": {\n");
+    fprintf(output, "        \"game-objects\": %f,\n", 1000.0 * gameObjectTime / frames);
+    fprintf(output, "        \"integrate\": %f,\n", 1000.0 * integrateTime / frames);
+    fprintf(output, "        \"collision\": %f,\n", 1000.0 * collisionTime / frames);
+    fprintf(output, "        \"resolve\": %f\n", 1000.0 * resolveTime / frames);
+    fprintf(output, "    },\n");
+    fprintf(output, "    \"contacts\": {\n");
+    fprintf(output, "        \"potential-average\": %f,\n", potentialContactTotal / frames);
+    fprintf(output, "        \"potential-peak\": %u,\n", potentialStats.Peak);
+    fprintf(output, "        \"average\": %f,\n", contactTotal / frames);
+    fprintf(output, "        \"peak\": %u,\n", contactStats.Peak);
+    fprintf(output, "        \"rigid-body-peak\": %u,\n", rigidBodyStats.Peak);
+    fprintf(output, "        \"truncated\": %u\n", potentialStats.TotalTruncated + contactStats.TotalTruncated + rigidBodyStats.TotalTruncated);
+    fprintf(output, "    },\n");
+    fprintf(output, "    \"recent-steps\": {\n");
+    fprintf(output, "        \"steps\": %u,\n", recentSteps);
+    fprintf(output, "        \"broad-phase-pairs\": %f,\n", recent.BroadPhasePairs / steps);
+    fprintf(output, "        \"narrow-phase-tests\": %f,\n", recent.GetNarrowPhaseTests() / steps);
+    fprintf(output, "        \"position-iterations\": %f,\n", recent.PositionIterations / steps);
+    fprintf(output, "        \"velocity-iterations\": %f,\n", recent.VelocityIterations / steps);
+    fprintf(output, "        \"iteration-limit-hits\": %f,\n", recent.IterationLimitHits / steps);
+    fprintf(output, "        \"awake-bodies\": %f,\n", recent.AwakeBodies / steps);
+    fprintf(output, "        \"asleep-bodies\": %f,\n", recent.AsleepBodies / steps);
+    fprintf(output, "        \"average-ms\": {\n");
+    for (int i = 0; i < NUM_PHYSICS_PHASES; i++)
+    {
+        fprintf(output, "            \"%s\": %f,\n", PhysicsProfiler::GetPhaseName((PhysicsPhase)i), 1000.0 * recent.PhaseSeconds[i] / steps);
+    }
+    fprintf(output, "            \"total\": %f\n", 1000.0 * recent.GetTotalSeconds() / steps);
+    fprintf(output, "        }\n");
+    fprintf(output, "    }\n");
+    fprintf(output, "}\n");
+    fflush(output);
+
     Shutdown();
 }
 
 void Game::Shutdown()
 {
     // Manager shutdown
+    PhysicsProfiler::Singleton().StopDump();
     GameObjectManager::Singleton().Shutdown();
     CollisionEngine::Singleton().Shutdown();
     PhysicsEngine::Singleton().Shutdown();
     GameProject::Singleton().Shutdown();
     ResourceManager::Singleton().Shutdown();
     InputManager::Singleton().Shutdown();
-    RenderManager::Singleton().Shutdown();
+    if (!m_headless)
+    {
+        RenderManager::Singleton().Shutdown();
+    }
 
     delete m_engineComponentFactory;
 
     // Window cleanup
-    m_gameWindow.Destroy();
-    exit(EXIT_SUCCESS);
+    if (!m_headless)
+    {
+        m_gameWindow.Destroy();
+    }
+}
+
+void Game::UpdatePhysics(float deltaTime)
+{
+    // Physics always advances in fixed steps, so the simulation doesn't depend on the frame rate.
+    // Leftover time carries over to the next frame.
+    m_physicsAccumulator += deltaTime;
+    if (m_physicsAccumulator >= m_physicsTimeStep)
+    {
+        // Colliders read the game object transforms, which currently hold the interpolated state
+        PhysicsEngine::Singleton().UpdateGameObjects();
+    }
+
+    int steps = 0;
+    while (m_physicsAccumulator >= m_physicsTimeStep && steps < m_maxPhysicsSteps)
+    {
+        StepPhysics(m_physicsTimeStep);
+        m_physicsAccumulator -= m_physicsTimeStep;
+        steps++;
+    }
+
+    // If we still can't catch up, drop the extra time rather than trying to simulate it next frame,
+    // which would only make that frame slower too
+    if (m_physicsAccumulator >= m_physicsTimeStep)
+    {
+        m_physicsAccumulator = fmodf(m_physicsAccumulator, m_physicsTimeStep);
+    }
+
+    // Render objects partway between the last two physics states
+    PhysicsEngine::Singleton().UpdateGameObjects(m_physicsAccumulator / m_physicsTimeStep);
+}
+
+void Game::StepPhysics(float deltaTime)
+{
+    PhysicsProfiler::Singleton().BeginStep();
+    PhysicsEngine::Singleton().UpdateBodies(deltaTime);
+    CollisionEngine::Singleton().CalculateCollisions(deltaTime);
+    PhysicsEngine::Singleton().ResolveCollisions(deltaTime);
+    CollisionEngine::Singleton().DispatchCollisionEvents();
+    PhysicsProfiler::Singleton().EndStep();
 }
 
 void Game::UpdateTime()
@@ -1,9 +1,11 @@
 #include "GameComponent.h"
 
+#include "GameObject.h"
+
 #include <stdio.h>
 
 GameComponent::GameComponent()
-    : m_gameObject(NULL)
+    : m_gameObject(NULL), m_collisionEventTypes(0)
 {}
 
 bool GameComponent::IsEnabled()
@@ -11,6 +13,20 @@ bool GameComponent::IsEnabled()
     return m_enabled;
 }
 
+void GameComponent::ListenForCollisions(unsigned int eventTypes)
+{
+    m_collisionEventTypes = eventTypes;
+    if (m_gameObject != NULL)
+    {
+        m_gameObject->UpdateCollisionListener(this);
+    }
+}
+
+unsigned int GameComponent::GetCollisionEventTypes()
+{
+    return m_collisionEventTypes;
+}
+
 GameObject* GameComponent::GetGameObject()
 {
     return m_gameObject;
@@ -7,8 +7,10 @@
 #include "Rendering/MeshInstance.h"
 #include "Physics/RigidBody.h"      // TODO make an actual rigidbody game component to fix this dependency
 
+#include <algorithm>
+
 GameObject::GameObject(unsigned int guid, string name, GameObjectBase* parent)
- : GameObjectBase(guid, name, parent), m_active(true)
+ : GameObjectBase(guid, name, parent), m_active(true), m_collisionEventTypes(0)
 {
     SetParent(parent);
 
@@ -22,6 +24,11 @@ void GameObject::AddComponent(GameComponent* component)
     {
         component->SetGameObject(this);
         m_components.push_back(component);
+
+        if (component->GetCollisionEventTypes() != 0)
+        {
+            UpdateCollisionListener(component);
+        }
     }
 }
 
@@ -119,36 +126,63 @@ void GameObject::OnDeactivate()
     }
 }
 
-void GameObject::OnCollisionEnter()
+void GameObject::OnCollision(CollisionEventType type, const Collision& collision)
 {
-    // Notify all components of collision enter
-    std::vector<GameComponent*>::iterator compIter;
-    for (compIter = m_components.begin(); compIter != m_components.end(); compIter++)
+    // Notify the components that listen for this type of collision event. Callbacks can start or stop listening,
+    // which changes the listener list, so walk it by index and check it again after each callback.
+    size_t i = 0;
+    while (i < m_collisionListeners.size())
     {
-        GameComponent* component = *compIter;
-        component->OnCollisionEnter();
+        GameComponent* component = m_collisionListeners[i];
+        if ((component->GetCollisionEventTypes() & type) == 0)
+        {
+            i++;
+            continue;
+        }
+
+        switch (type)
+        {
+        case COLLISION_EVENT_ENTER: component->OnCollisionEnter(collision);  break;
+        case COLLISION_EVENT_HOLD:  component->OnCollisionHold(collision);   break;
+        case COLLISION_EVENT_EXIT:  component->OnCollisionExit(collision);   break;
+        case TRIGGER_EVENT_ENTER:   component->OnTriggerEnter(collision);    break;
+        case TRIGGER_EVENT_EXIT:    component->OnTriggerExit(collision);     break;
+        case COLLISION_EVENT_ALL:
+        case TRIGGER_EVENT_ALL:     break;      // Masks for listening, never events
+        }
+
+        // If this or an earlier listener was removed, the next one has moved down into this slot
+        if (i < m_collisionListeners.size() && m_collisionListeners[i] == component)
+        {
+            i++;
+        }
     }
 }
 
-void GameObject::OnCollisionHold()
+bool GameObject::ListensForCollisions(CollisionEventType type)
 {
-    // Notify all components of collision hold
-    std::vector<GameComponent*>::iterator compIter;
-    for (compIter = m_components.begin(); compIter != m_components.end(); compIter++)
-    {
-        GameComponent* component = *compIter;
-        component->OnCollisionHold();
-    }
+    return (m_collisionEventTypes & type) != 0;
 }
 
-void GameObject::OnCollisionExit()
+void GameObject::UpdateCollisionListener(GameComponent* component)
 {
-    // Notify all components of collision exit
-    std::vector<GameComponent*>::iterator compIter;
-    for (compIter = m_components.begin(); compIter != m_components.end(); compIter++)
+    std::vector<GameComponent*>::iterator iter = std::find(m_collisionListeners.begin(), m_collisionListeners.end(), component);
+    if (component->GetCollisionEventTypes() == 0)
     {
-        GameComponent* component = *compIter;
-        component->OnCollisionExit();
+        if (iter != m_collisionListeners.end())
+        {
+            m_collisionListeners.erase(iter);
+        }
+    }
+    else if (iter == m_collisionListeners.end())
+    {
+        m_collisionListeners.push_back(component);
+    }
+
+    m_collisionEventTypes = 0;
+    for (iter = m_collisionListeners.begin(); iter != m_collisionListeners.end(); iter++)
+    {
+        m_collisionEventTypes |= (*iter)->GetCollisionEventTypes();
     }
 }
 
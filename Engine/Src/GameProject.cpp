@@ -1,4 +1,5 @@
 #include "GameProject.h"
+#include "Physics\Collider.h"
 #include "Scene\ResourceManager.h"
 #include "Serialization\HierarchicalSerializer.h"
 
@@ -8,17 +9,34 @@ GameProject::PhysicsSettings::PhysicsSettings()
 {
     Enabled = true;
     Gravity = -2.0f;
+    BroadPhase = BROAD_PHASE_BVH;
+    GridCellSize = 0.0f;
+    StepRate = DEFAULT_STEP_RATE;
+    MaxStepsPerFrame = DEFAULT_MAX_STEPS_PER_FRAME;
+    NarrowPhaseThreads = 0;
+    ContactSolver = CONTACT_SOLVER_WORST_FIRST;
+    SolverIterations = 0;
+    SpeculativeContacts = false;
 }
 
 GameProject::PhysicsSettings::PhysicsSettings(bool enabled, float gravity)
 {
     Enabled = enabled;
     Gravity = gravity;
+    BroadPhase = BROAD_PHASE_BVH;
+    GridCellSize = 0.0f;
+    StepRate = DEFAULT_STEP_RATE;
+    MaxStepsPerFrame = DEFAULT_MAX_STEPS_PER_FRAME;
+    NarrowPhaseThreads = 0;
+    ContactSolver = CONTACT_SOLVER_WORST_FIRST;
+    SolverIterations = 0;
+    SpeculativeContacts = false;
 }
 
-void GameProject::Startup(bool toolside)
+void GameProject::Startup(bool toolside, bool headless)
 {
     m_toolside = toolside;
+    m_headless = headless;
     m_loaded = false;
     m_filename = "";
     m_resourceDir = "";
@@ -34,6 +52,11 @@ bool GameProject::IsToolside()
     return m_toolside;
 }
 
+bool GameProject::IsHeadless()
+{
+    return m_headless;
+}
+
 bool GameProject::New(string name, string filename, string resourcePath)
 {
     if (m_loaded)
@@ -249,7 +272,54 @@ void GameProject::LoadSettings(HierarchicalDeserializer* deserializer)
         {
             deserializer->GetAttribute("enabled", m_physicsSettings.Enabled);
             deserializer->GetAttribute("gravity", m_physicsSettings.Gravity);
+            deserializer->GetAttribute("broad-phase", (int&)m_physicsSettings.BroadPhase);
+            deserializer->GetAttribute("grid-cell-size", m_physicsSettings.GridCellSize);
+            deserializer->GetAttribute("step-rate", m_physicsSettings.StepRate);
+            deserializer->GetAttribute("max-steps-per-frame", m_physicsSettings.MaxStepsPerFrame);
+            deserializer->GetAttribute("narrow-phase-threads", m_physicsSettings.NarrowPhaseThreads);
+            deserializer->GetAttribute("contact-solver", (int&)m_physicsSettings.ContactSolver);
+            deserializer->GetAttribute("solver-iterations", m_physicsSettings.SolverIterations);
+            deserializer->GetAttribute("speculative-contacts", m_physicsSettings.SpeculativeContacts);
+
+            // The last NextSiblingScope leaves the Layer-Collisions scope on its own
+            m_physicsSettings.LayerCollisionMasks.clear();
+            bool layersToProcess = deserializer->PushScope("Layer-Collisions");
+            while (layersToProcess)
+            {
+                int layer = -1;
+                unsigned int mask = ALL_COLLISION_LAYERS;
+                deserializer->GetAttribute("layer", layer);
+                deserializer->GetAttribute("mask", mask);
+                if (layer >= 0 && layer < MAX_COLLISION_LAYERS)
+                {
+                    if (layer >= (int)m_physicsSettings.LayerCollisionMasks.size())
+                    {
+                        m_physicsSettings.LayerCollisionMasks.resize(layer + 1, ALL_COLLISION_LAYERS);
+                    }
+                    m_physicsSettings.LayerCollisionMasks[layer] = mask;
+                }
+
+                layersToProcess = deserializer->NextSiblingScope("Layer-Collisions");
+            }
             deserializer->PopScope();
+
+            // Older projects don't have timestep settings
+            if (m_physicsSettings.StepRate <= 0)
+            {
+                m_physicsSettings.StepRate = PhysicsSettings::DEFAULT_STEP_RATE;
+            }
+            if (m_physicsSettings.MaxStepsPerFrame <= 0)
+            {
+                m_physicsSettings.MaxStepsPerFrame = PhysicsSettings::DEFAULT_MAX_STEPS_PER_FRAME;
+            }
+            if (m_physicsSettings.NarrowPhaseThreads < 0)
+            {
+                m_physicsSettings.NarrowPhaseThreads = 0;
+            }
+            if (m_physicsSettings.SolverIterations < 0)
+            {
+                m_physicsSettings.SolverIterations = 0;
+            }
         }
 
         deserializer->PopScope();
@@ -277,6 +347,26 @@ void GameProject::SerializeSettings(HierarchicalSerializer* serializer)
     serializer->PushScope("Physics-Settings");
     serializer->SetAttribute("enabled", m_physicsSettings.Enabled);
     serializer->SetAttribute("gravity", m_physicsSettings.Gravity);
+    serializer->SetAttribute("broad-phase", m_physicsSettings.BroadPhase);
+    serializer->SetAttribute("grid-cell-size", m_physicsSettings.GridCellSize);
+    serializer->SetAttribute("step-rate", m_physicsSettings.StepRate);
+    serializer->SetAttribute("max-steps-per-frame", m_physicsSettings.MaxStepsPerFrame);
+    serializer->SetAttribute("narrow-phase-threads", m_physicsSettings.NarrowPhaseThreads);
+    serializer->SetAttribute("contact-solver", m_physicsSettings.ContactSolver);
+    serializer->SetAttribute("solver-iterations", m_physicsSettings.SolverIterations);
+    serializer->SetAttribute("speculative-contacts", m_physicsSettings.SpeculativeContacts);
+
+    // Only layers that are filtered are written out
+    for (unsigned int i = 0; i < m_physicsSettings.LayerCollisionMasks.size(); i++)
+    {
+        if (m_physicsSettings.LayerCollisionMasks[i] != ALL_COLLISION_LAYERS)
+        {
+            serializer->PushScope("Layer-Collisions");
+            serializer->SetAttribute("layer", (int)i);
+            serializer->SetAttribute("mask", m_physicsSettings.LayerCollisionMasks[i]);
+            serializer->PopScope();
+        }
+    }
     serializer->PopScope();
 
     serializer->PopScope();
@@ -33,6 +33,10 @@ void InputManager::PollEvents(float deltaTime)
 
 eKeyState InputManager::GetKey(eKeyValue key)
 {
+    // There's no window to read from in headless mode
+    if (m_gameWindow == NULL)
+        return DGWD_KEY_RELEASE;
+
     int glfwKey = DGWDKeyToGLFWKey(key);
     int ret = glfwGetKey(m_gameWindow->GetGLFWWindow(), glfwKey);
     if (ret == GLFW_PRESS)
@@ -49,6 +53,9 @@ bool InputManager::GetKeyPressed(eKeyValue key)
 
 eMouseButtonState InputManager::GetMouseButton(eMouseButtonValue button)
 {
+    if (m_gameWindow == NULL)
+        return DGWD_MOUSE_BUTTON_RELEASE;
+
     int glfwButton = DGWDMouseButtonToGLFWMouseButton(button);
     int ret = glfwGetMouseButton(m_gameWindow->GetGLFWWindow(), glfwButton);
     if (ret == GLFW_PRESS)
@@ -65,6 +72,9 @@ bool InputManager::GetMouseButtonPressed(eMouseButtonValue button)
 
 CursorPos InputManager::GetCursorPos()
 {
+    if (m_gameWindow == NULL)
+        return CursorPos(0.0f, 0.0f);
+
     double xPos, yPos;
     glfwGetCursorPos(m_gameWindow->GetGLFWWindow(), &xPos, &yPos);
 
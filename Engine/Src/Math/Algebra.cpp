@@ -598,7 +598,7 @@ void Matrix3x3::SetColumns(Vector3& col0, Vector3& col1, Vector3& col2)
     m_values[5] = col2[1];
 
     m_values[6] = col0[2];
-    m_values[7] = col1[3];
+    m_values[7] = col1[2];
     m_values[8] = col2[2];
 }
 
@@ -1289,6 +1289,20 @@ Quaternion operator *(const Quaternion& a, const Quaternion& b)
     return ret;
 }
 
+Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t)
+{
+    // q and -q are the same rotation, so flip b if needed to interpolate the short way around
+    float dot = a.r()*b.r() + a.i()*b.i() + a.j()*b.j() + a.k()*b.k();
+    float sign = dot < 0 ? -1.0f : 1.0f;
+
+    Quaternion ret(a.r() + (sign*b.r() - a.r())*t,
+                   a.i() + (sign*b.i() - a.i())*t,
+                   a.j() + (sign*b.j() - a.j())*t,
+                   a.k() + (sign*b.k() - a.k())*t);
+    ret.Normalize();
+    return ret;
+}
+
 Quaternion Quaternion::Identity = Quaternion(1, 0, 0, 0);
 
 float DegreesToRadians(float degrees)
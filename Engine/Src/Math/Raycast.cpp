@@ -1,8 +1,217 @@
 #include "Math\Raycast.h"
 
 #include "GameObjectBase.h"
+#include "Math/PackedFloat.h"
+#include "Physics/TriangleBVH.h"
+#include "Rendering/Mesh.h"
 #include "Rendering/MeshInstance.h"
 
+namespace
+{
+#if defined(PACKED_FLOAT_SSE) || defined(PACKED_FLOAT_AVX)
+    typedef PackedFloat RayLanes;
+#else
+    typedef Float1 RayLanes;
+#endif
+
+    // A packet of rays in structure of arrays form, along with the distance of the closest hit so far
+    template <typename Real>
+    struct RayPacket
+    {
+        Real    Origin[3];
+        Real    Direction[3];
+        Real    Distance;
+        int     First;      // Index of the ray in the first lane
+        int     Count;      // Number of lanes in use; the rest repeat the last ray, and are never written back
+    };
+
+    template <typename Real>
+    void LoadPacket(const Raycast::Ray* rays, const Raycast::HitInfo* hits, int first, int count, RayPacket<Real>& packet)
+    {
+        float lanes[7][Real::Width];
+        for (int lane = 0; lane < (int)Real::Width; lane++)
+        {
+            int index = first + (lane < count ? lane : count - 1);
+            Vector3 direction = rays[index].direction.Normalized();
+            for (int axis = 0; axis < 3; axis++)
+            {
+                lanes[axis][lane] = rays[index].origin[axis];
+                lanes[3 + axis][lane] = direction[axis];
+            }
+            lanes[6][lane] = hits[index].distance;
+        }
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            packet.Origin[axis] = Real::Load(lanes[axis]);
+            packet.Direction[axis] = Real::Load(lanes[3 + axis]);
+        }
+        packet.Distance = Real::Load(lanes[6]);
+        packet.First = first;
+        packet.Count = count;
+    }
+
+    // Writes back the lanes that found a closer hit, and returns how many there were
+    template <typename Real>
+    int StorePacket(const Raycast::Ray* rays, const RayPacket<Real>& packet, Real closer, Raycast::HitInfo* hits)
+    {
+        unsigned int mask = MoveMask(closer);
+        if (mask == 0)
+            return 0;
+
+        float distances[Real::Width];
+        packet.Distance.Store(distances);
+
+        int stored = 0;
+        for (int lane = 0; lane < packet.Count; lane++)
+        {
+            if ((mask & (1 << lane)) == 0)
+                continue;
+
+            const Raycast::Ray& ray = rays[packet.First + lane];
+            hits[packet.First + lane] = Raycast::HitInfo(ray.origin + distances[lane] * ray.direction.Normalized(), distances[lane]);
+            stored++;
+        }
+        return stored;
+    }
+
+    // Runs one of the packet tests below over every packet of rays
+    template <typename Real, typename PacketTest>
+    int RaycastPackets(const Raycast::Ray* rays, int rayCount, const PacketTest& test, Raycast::HitInfo* hits)
+    {
+        int hitCount = 0;
+        for (int first = 0; first < rayCount; first += Real::Width)
+        {
+            int count = rayCount - first < (int)Real::Width ? rayCount - first : (int)Real::Width;
+            RayPacket<Real> packet;
+            LoadPacket(rays, hits, first, count, packet);
+            hitCount += StorePacket(rays, packet, test(packet), hits);
+        }
+        return hitCount;
+    }
+
+    struct SpherePacketTest
+    {
+        const float*    Radii;
+        const Vector3*  Centers;
+        int             SphereCount;
+
+        // Returns the mask of lanes that found a closer hit, and moves their distances up to it
+        template <typename Real>
+        Real operator()(RayPacket<Real>& packet) const
+        {
+            Real zero(0.0f);
+            Real closer(0.0f);
+            for (int i = 0; i < SphereCount; i++)
+            {
+                Real offset[3];
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    offset[axis] = packet.Origin[axis] - Real(Centers[i][axis]);
+                }
+                Real b = offset[0]*packet.Direction[0] + offset[1]*packet.Direction[1] + offset[2]*packet.Direction[2];
+                Real c = offset[0]*offset[0] + offset[1]*offset[1] + offset[2]*offset[2] - Real(Radii[i]*Radii[i]);
+                Real discriminant = b*b - c;
+                Real root = Sqrt(Max(discriminant, zero));
+
+                // Take the entry point, or the exit point for rays that start inside the sphere
+                Real distance = zero - b - root;
+                distance = Select(GreaterThan(zero, distance), root - b, distance);
+
+                Real valid = MaskAnd(GreaterEqual(discriminant, zero), GreaterEqual(distance, zero));
+                valid = MaskAnd(valid, GreaterThan(packet.Distance, distance));
+                packet.Distance = Select(valid, distance, packet.Distance);
+                closer = MaskOr(closer, valid);
+            }
+            return closer;
+        }
+    };
+
+    struct BoxPacketTest
+    {
+        const Vector3*  Mins;
+        const Vector3*  Maxes;
+        int             BoxCount;
+
+        template <typename Real>
+        Real operator()(RayPacket<Real>& packet) const
+        {
+            Real one(1.0f);
+            Real inverseDirection[3];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                inverseDirection[axis] = one / packet.Direction[axis];
+            }
+
+            Real closer(0.0f);
+            for (int i = 0; i < BoxCount; i++)
+            {
+                // Slab test, clipping the ray against each pair of planes in turn
+                Real entry(0.0f);
+                Real exit = packet.Distance;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    Real toMin = (Real(Mins[i][axis]) - packet.Origin[axis]) * inverseDirection[axis];
+                    Real toMax = (Real(Maxes[i][axis]) - packet.Origin[axis]) * inverseDirection[axis];
+                    entry = Max(entry, Min(toMin, toMax));
+                    exit = Min(exit, Max(toMin, toMax));
+                }
+
+                // Rays that start inside the box hit it at their origin
+                Real valid = MaskAnd(GreaterEqual(exit, entry), GreaterThan(packet.Distance, entry));
+                packet.Distance = Select(valid, entry, packet.Distance);
+                closer = MaskOr(closer, valid);
+            }
+            return closer;
+        }
+    };
+
+    struct TrianglePacketTest
+    {
+        const Vector3*  Triangles;
+        int             TriangleCount;
+
+        // Moller-Trumbore, one triangle against every lane at a time
+        template <typename Real>
+        Real operator()(RayPacket<Real>& packet) const
+        {
+            Real zero(0.0f);
+            Real one(1.0f);
+            Real closer(0.0f);
+            for (int i = 0; i < TriangleCount; i++)
+            {
+                const Vector3* triangle = &Triangles[i * 3];
+                Real edge1[3], edge2[3], s[3];
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    edge1[axis] = Real(triangle[1][axis] - triangle[0][axis]);
+                    edge2[axis] = Real(triangle[2][axis] - triangle[0][axis]);
+                    s[axis] = packet.Origin[axis] - Real(triangle[0][axis]);
+                }
+
+                const Real* d = packet.Direction;
+                Real h[3] = { d[1]*edge2[2] - d[2]*edge2[1], d[2]*edge2[0] - d[0]*edge2[2], d[0]*edge2[1] - d[1]*edge2[0] };
+                Real q[3] = { s[1]*edge1[2] - s[2]*edge1[1], s[2]*edge1[0] - s[0]*edge1[2], s[0]*edge1[1] - s[1]*edge1[0] };
+                Real a = edge1[0]*h[0] + edge1[1]*h[1] + edge1[2]*h[2];
+
+                // Rays parallel to the triangle get a harmless divisor, and are masked out
+                Real valid = GreaterThan(Abs(a), Real(1e-12f));
+                Real f = one / Select(valid, a, one);
+                Real u = f * (s[0]*h[0] + s[1]*h[1] + s[2]*h[2]);
+                Real v = f * (d[0]*q[0] + d[1]*q[1] + d[2]*q[2]);
+                Real t = f * (edge2[0]*q[0] + edge2[1]*q[1] + edge2[2]*q[2]);
+
+                valid = MaskAnd(valid, MaskAnd(GreaterEqual(u, zero), GreaterEqual(v, zero)));
+                valid = MaskAnd(valid, GreaterEqual(one, u + v));
+                valid = MaskAnd(valid, MaskAnd(GreaterThan(t, zero), GreaterThan(packet.Distance, t)));
+                packet.Distance = Select(valid, t, packet.Distance);
+                closer = MaskOr(closer, valid);
+            }
+            return closer;
+        }
+    };
+}
+
 // Based on equations from: http://antongerdelan.net/opengl/raycasting.html
 bool Raycast::RaycastSphere(Vector3 rayOrigin,
     Vector3 rayDirection,
@@ -92,28 +301,24 @@ bool Raycast::RaycastMesh(Vector3 rayOrigin,
     MeshInstance* meshInstance,
     HitInfo& hitInfo)
 {
-    // Iterate through each triangle in the mesh
-    Vector3 triangle[3];
-    bool hit = false;
-    float closestHitDistance = FLT_MAX;
-    for (int i = 0; i < meshInstance->GetTriangleCount(); i++)
-    {
-        meshInstance->GetTriangle(i, triangle, true);
+    if (meshInstance->GetMesh() == NULL)
+        return false;
+    TriangleBVH* bvh = meshInstance->GetMesh()->GetTriangleBVH();
 
-        // Raycast against the current triangle
-        HitInfo currentHitInfo;
-        if (RaycastTriangle(rayOrigin, rayDirection, triangle, currentHitInfo))
-        {
-            hit = true;
-            if (currentHitInfo.distance < closestHitDistance)
-            {
-                closestHitDistance = currentHitInfo.distance;
-                hitInfo = currentHitInfo;
-            }
-        }
-    }
+    // Move the ray into the mesh's model space once, rather than moving every triangle into world space. The
+    // direction isn't renormalized, so distances along the ray are measured the same way in both spaces.
+    Transform& transform = meshInstance->GetGameObject()->GetTransform();
+    Vector3 localOrigin = transform.InverseTransformPoint(rayOrigin);
+    Vector3 localDirection = transform.InverseTransformVector(rayDirection);
+
+    float distance;
+    int triangle;
+    if (!bvh->Raycast(localOrigin, localDirection, FLT_MAX, distance, triangle) || Approximately(distance, 0))
+        return false;
 
-    return hit;
+    hitInfo.point = rayOrigin + distance * rayDirection;
+    hitInfo.distance = (hitInfo.point - rayOrigin).Magnitude();
+    return true;
 }
 
 bool Raycast::RaycastGameObject(Vector3 rayOrigin,
@@ -181,4 +386,49 @@ bool Raycast::RaycastGameObject(Vector3 rayOrigin,
     }
 
     return false;
+}
+
+int Raycast::GetBatchWidth()
+{
+    return RayLanes::Width;
+}
+
+int Raycast::RaycastSphereBatch(const Ray* rays,
+    int rayCount,
+    const float* sphereRadii,
+    const Vector3* spherePositions,
+    int sphereCount,
+    HitInfo* hits)
+{
+    SpherePacketTest test;
+    test.Radii = sphereRadii;
+    test.Centers = spherePositions;
+    test.SphereCount = sphereCount;
+    return RaycastPackets<RayLanes>(rays, rayCount, test, hits);
+}
+
+int Raycast::RaycastBoxBatch(const Ray* rays,
+    int rayCount,
+    const Vector3* boxMins,
+    const Vector3* boxMaxes,
+    int boxCount,
+    HitInfo* hits)
+{
+    BoxPacketTest test;
+    test.Mins = boxMins;
+    test.Maxes = boxMaxes;
+    test.BoxCount = boxCount;
+    return RaycastPackets<RayLanes>(rays, rayCount, test, hits);
+}
+
+int Raycast::RaycastTriangleBatch(const Ray* rays,
+    int rayCount,
+    const Vector3* triangles,
+    int triangleCount,
+    HitInfo* hits)
+{
+    TrianglePacketTest test;
+    test.Triangles = triangles;
+    test.TriangleCount = triangleCount;
+    return RaycastPackets<RayLanes>(rays, rayCount, test, hits);
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "Math/RaycastBenchmark.h"
+
+#include "Math/Raycast.h"
+
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <vector>
+
+using std::vector;
+
+#define RAYCAST_BENCHMARK_SPHERES 32
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+namespace
+{
+    // Small deterministic generator, so every run and every platform tests the same scene
+    struct RandomSequence
+    {
+        RandomSequence(unsigned int seed) : State(seed) {}
+
+        float Next(float min, float max)
+        {
+            State = State * 1664525u + 1013904223u;
+            return min + (max - min) * ((State >> 8) * (1.0f / 16777216.0f));
+        }
+
+        Vector3 NextPoint(float extent)
+        {
+            float x = Next(-extent, extent);
+            float y = Next(-extent, extent);
+            float z = Next(-extent, extent);
+            return Vector3(x, y, z);
+        }
+
+        unsigned int State;
+    };
+
+    double SecondsSince(BenchmarkClock::time_point start)
+    {
+        return std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+    }
+
+    void ResetHits(vector<Raycast::HitInfo>& hits)
+    {
+        for (unsigned int i = 0; i < hits.size(); i++)
+        {
+            hits[i].distance = FLT_MAX;
+        }
+    }
+
+    // Counts the rays where one path hit and the other didn't, or where they found different distances
+    int CountMismatches(const vector<Raycast::HitInfo>& scalarHits, const vector<Raycast::HitInfo>& batchHits)
+    {
+        int mismatches = 0;
+        for (unsigned int i = 0; i < scalarHits.size(); i++)
+        {
+            float scalar = scalarHits[i].distance;
+            float batch = batchHits[i].distance;
+            bool scalarHit = scalar < FLT_MAX;
+            bool batchHit = batch < FLT_MAX;
+            if (scalarHit != batchHit || (scalarHit && fabsf(scalar - batch) > 1e-3f * fmaxf(1.0f, scalar)))
+                mismatches++;
+        }
+        return mismatches;
+    }
+}
+
+void RaycastBenchmark::Run(int rayCount, int triangleCount, int iterations, FILE* output)
+{
+    // An empty scene still gets a report, with nothing timed
+    rayCount = rayCount > 0 ? rayCount : 0;
+    triangleCount = triangleCount > 0 ? triangleCount : 0;
+
+    RandomSequence random(12345);
+
+    // Rays start outside the scene and aim at points inside it, with directions left unnormalized
+    vector<Raycast::Ray> rays(rayCount);
+    for (int i = 0; i < rayCount; i++)
+    {
+        Vector3 origin = random.NextPoint(1.0f).Normalized() * 50.0f;
+        rays[i] = Raycast::Ray(origin, random.NextPoint(10.0f) - origin);
+    }
+
+    vector<Vector3> sphereCenters(RAYCAST_BENCHMARK_SPHERES);
+    vector<float> sphereRadii(RAYCAST_BENCHMARK_SPHERES);
+    for (int i = 0; i < RAYCAST_BENCHMARK_SPHERES; i++)
+    {
+        sphereCenters[i] = random.NextPoint(15.0f);
+        sphereRadii[i] = random.Next(0.5f, 2.0f);
+    }
+
+    vector<Vector3> triangles(triangleCount * 3);
+    for (int i = 0; i < triangleCount; i++)
+    {
+        Vector3 center = random.NextPoint(15.0f);
+        for (int j = 0; j < 3; j++)
+        {
+            triangles[i * 3 + j] = center + random.NextPoint(2.0f);
+        }
+    }
+
+    vector<Raycast::HitInfo> scalarSphereHits(rayCount);
+    vector<Raycast::HitInfo> batchSphereHits(rayCount);
+    vector<Raycast::HitInfo> scalarTriangleHits(rayCount);
+    vector<Raycast::HitInfo> batchTriangleHits(rayCount);
+    double scalarSphereTime = 0;
+    double batchSphereTime = 0;
+    double scalarTriangleTime = 0;
+    double batchTriangleTime = 0;
+
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        // Scalar: every ray against every shape, keeping the closest hit in front of the ray
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        ResetHits(scalarSphereHits);
+        for (int i = 0; i < rayCount; i++)
+        {
+            Vector3 direction = rays[i].direction.Normalized();
+            for (int j = 0; j < RAYCAST_BENCHMARK_SPHERES; j++)
+            {
+                Raycast::HitInfo hit;
+                if (Raycast::RaycastSphere(rays[i].origin, direction, sphereRadii[j], sphereCenters[j], hit)
+                    && hit.distance >= 0 && hit.distance < scalarSphereHits[i].distance)
+                {
+                    scalarSphereHits[i] = hit;
+                }
+            }
+        }
+        scalarSphereTime += SecondsSince(start);
+
+        start = BenchmarkClock::now();
+        ResetHits(scalarTriangleHits);
+        for (int i = 0; i < rayCount; i++)
+        {
+            Vector3 direction = rays[i].direction.Normalized();
+            for (int j = 0; j < triangleCount; j++)
+            {
+                Raycast::HitInfo hit;
+                if (Raycast::RaycastTriangle(rays[i].origin, direction, &triangles[j * 3], hit) && hit.distance < scalarTriangleHits[i].distance)
+                    scalarTriangleHits[i] = hit;
+            }
+        }
+        scalarTriangleTime += SecondsSince(start);
+
+        // Batched
+        start = BenchmarkClock::now();
+        ResetHits(batchSphereHits);
+        if (rayCount > 0)
+        {
+            Raycast::RaycastSphereBatch(rays.data(), rayCount, sphereRadii.data(), sphereCenters.data(), RAYCAST_BENCHMARK_SPHERES, batchSphereHits.data());
+        }
+        batchSphereTime += SecondsSince(start);
+
+        start = BenchmarkClock::now();
+        ResetHits(batchTriangleHits);
+        if (rayCount > 0 && triangleCount > 0)
+        {
+            Raycast::RaycastTriangleBatch(rays.data(), rayCount, triangles.data(), triangleCount, batchTriangleHits.data());
+        }
+        batchTriangleTime += SecondsSince(start);
+    }
+
+    double runs = iterations > 0 ? (double)iterations : 1.0;
+
+    fprintf(output, "{\n");
+    fprintf(output, "    \"rays\": %d,\n", rayCount);
+    fprintf(output, "    \"spheres\": %d,\n", RAYCAST_BENCHMARK_SPHERES);
+    fprintf(output, "    \"triangles\": %d,\n", triangleCount);
+    fprintf(output, "    \"iterations\": %d,\n", iterations);
+    fprintf(output, "    \"batch-width\": %d,\n", Raycast::GetBatchWidth());
+    fprintf(output, "    \"spheres-ms\": {\n");
+    fprintf(output, "        \"scalar\": %f,\n", 1000.0 * scalarSphereTime / runs);
+    fprintf(output, "        \"batched\": %f,\n", 1000.0 * batchSphereTime / runs);
+    fprintf(output, "        \"speedup\": %f,\n", batchSphereTime > 0 ? scalarSphereTime / batchSphereTime : 0.0);
+    fprintf(output, "        \"mismatches\": %d\n", CountMismatches(scalarSphereHits, batchSphereHits));
+    fprintf(output, "    },\n");
+    fprintf(output, "    \"triangles-ms\": {\n");
+    fprintf(output, "        \"scalar\": %f,\n", 1000.0 * scalarTriangleTime / runs);
+    fprintf(output, "        \"batched\": %f,\n", 1000.0 * batchTriangleTime / runs);
+    fprintf(output, "        \"speedup\": %f,\n", batchTriangleTime > 0 ? scalarTriangleTime / batchTriangleTime : 0.0);
+    fprintf(output, "        \"mismatches\": %d\n", CountMismatches(scalarTriangleHits, batchTriangleHits));
+    fprintf(output, "    }\n");
+    fprintf(output, "}\n");
+}
\ No newline at end of file
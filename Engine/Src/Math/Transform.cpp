@@ -267,6 +267,12 @@ Vector3 Transform::InverseTransformVector(Vector3 vector)
     return (m_inverseWorldMatrix * Vector4(vector, 0)).xyz();
 }
 
+void Transform::RecomputeIfDirty()
+{
+    RecomputeWorldIfDirty();
+    RecomputeInverseIfDirty();
+}
+
 void Transform::RemoveChild(Transform* transform)
 {
     m_children.erase(
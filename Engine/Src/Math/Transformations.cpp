@@ -181,6 +181,28 @@ Matrix3x3 InertiaTensorSphere(float radius, float mass)
     return m;
 }
 
+Matrix3x3 InertiaTensorCapsule(float radius, float height, eAXIS axis, float mass)
+{
+    // Split the mass between the cylinder and the two hemispheres by volume
+    float r2 = radius*radius;
+    float cylinderVolume = height*r2;
+    float sphereVolume = 1.33333f*radius*r2;    // 4/3 = 1.33333... (pi cancels out)
+    float cylinderMass = mass*cylinderVolume/(cylinderVolume + sphereVolume);
+    float sphereMass = mass - cylinderMass;
+
+    // The hemispheres are offset from the center, which adds to the inertia about the other axes
+    float axial = 0.5f*cylinderMass*r2 + 0.4f*sphereMass*r2;
+    float other = cylinderMass*(0.08333f*height*height + 0.25f*r2) +
+                  sphereMass*(0.4f*r2 + 0.25f*height*height + 0.375f*height*radius);
+
+    Vector3 diagonal(other, other, other);
+    diagonal[axis] = axial;
+
+    Matrix3x3 m;
+    m.SetDiagonal(diagonal);
+    return m;
+}
+
 // rotation decomposition formula from http://nghiaho.com/?page_id=846
 void DecomposeTRSMatrix(const Matrix4x4& matrix, Vector3& position, Vector3& rotation, Vector3& scale)
 {
@@ -223,7 +245,7 @@ void CalculateTRMatrix(const Vector3& position, const Quaternion& rotation, Matr
 
     matrix[1][0] = 2 * rotation.i()*rotation.j() + 2 * rotation.r()*rotation.k();
     matrix[1][1] = 1 - 2 * rotation.i()*rotation.i() - 2 * rotation.k()*rotation.k();
-    matrix[1][2] = 2 * rotation.k()*rotation.k() - 2 * rotation.r()*rotation.i();
+    matrix[1][2] = 2 * rotation.j()*rotation.k() - 2 * rotation.r()*rotation.i();
     matrix[1][3] = position.y();
 
     matrix[2][0] = 2 * rotation.i()*rotation.k() - 2 * rotation.r()*rotation.j();
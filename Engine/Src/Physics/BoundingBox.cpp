@@ -0,0 +1,118 @@
+#include "Physics/BoundingBox.h"
+#include "Physics/Collider.h"
+
+BoundingBox::BoundingBox()
+{
+    Min = Vector3(-1, -1, -1);
+    Max = Vector3(1, 1, 1);
+}
+
+BoundingBox::BoundingBox(const Vector3& min, const Vector3& max)
+{
+    Min = min;
+    Max = max;
+}
+
+BoundingBox::BoundingBox(const BoundingBox& a, const BoundingBox& b)
+{
+    Min = Vector3(fminf(a.Min.x(), b.Min.x()), fminf(a.Min.y(), b.Min.y()), fminf(a.Min.z(), b.Min.z()));
+    Max = Vector3(fmaxf(a.Max.x(), b.Max.x()), fmaxf(a.Max.y(), b.Max.y()), fmaxf(a.Max.z(), b.Max.z()));
+}
+
+BoundingBox::BoundingBox(Collider* collider)
+{
+    if (collider != NULL)
+    {
+        // Colliders only expose a bounding radius, so use the box that encloses the bounding sphere
+        Vector3 center = collider->GetWorldPosition();
+        float radius = collider->GetWorldspaceBoundingRadius();
+        Vector3 halfsize(radius, radius, radius);
+        Min = center - halfsize;
+        Max = center + halfsize;
+    }
+}
+
+bool BoundingBox::Overlaps(const BoundingBox* other) const
+{
+    // Boxes overlap only if their extents overlap along every axis
+    return Min.x() <= other->Max.x() && Max.x() >= other->Min.x() &&
+           Min.y() <= other->Max.y() && Max.y() >= other->Min.y() &&
+           Min.z() <= other->Max.z() && Max.z() >= other->Min.z();
+}
+
+bool BoundingBox::Contains(const BoundingBox* other) const
+{
+    return Min.x() <= other->Min.x() && Max.x() >= other->Max.x() &&
+           Min.y() <= other->Min.y() && Max.y() >= other->Max.y() &&
+           Min.z() <= other->Min.z() && Max.z() >= other->Max.z();
+}
+
+float BoundingBox::GetSize()
+{
+    // Calculate the volume of the box
+    Vector3 extents = Max - Min;
+    return extents.x() * extents.y() * extents.z();
+}
+
+float BoundingBox::GetSurfaceArea() const
+{
+    Vector3 extents = Max - Min;
+    return 2.0f * (extents.x()*extents.y() + extents.y()*extents.z() + extents.z()*extents.x());
+}
+
+float BoundingBox::GetGrowth(BoundingBox& volume)
+{
+    BoundingBox newBox(*this, volume);
+
+    // Return the change in surface area
+    return newBox.GetSurfaceArea() - GetSurfaceArea();
+}
+
+bool BoundingBox::IntersectsRay(const Vector3& origin, const Vector3& inverseDirection, float maxDistance, float margin, float& entryDistance) const
+{
+    float entry = 0.0f;
+    float exit = maxDistance;
+    for (int i = 0; i < 3; i++)
+    {
+        float t0 = (Min[i] - margin - origin[i]) * inverseDirection[i];
+        float t1 = (Max[i] + margin - origin[i]) * inverseDirection[i];
+        entry = fmaxf(entry, fminf(t0, t1));
+        exit = fminf(exit, fmaxf(t0, t1));
+    }
+
+    entryDistance = entry;
+    return entry <= exit;
+}
+
+Vector3 BoundingBox::GetCenter() const
+{
+    return (Min + Max) * 0.5f;
+}
+
+Vector3 BoundingBox::GetHalfsize() const
+{
+    return (Max - Min) * 0.5f;
+}
+
+void BoundingBox::Expand(float margin)
+{
+    Vector3 marginVector(margin, margin, margin);
+    Min -= marginVector;
+    Max += marginVector;
+}
+
+void BoundingBox::ExpandByDisplacement(const Vector3& displacement)
+{
+    // Grow the box only on the side that the displacement points toward
+    for (int i = 0; i < 3; i++)
+    {
+        if (displacement[i] < 0)
+        {
+            Min[i] += displacement[i];
+        }
+        else
+        {
+            Max[i] += displacement[i];
+        }
+    }
+}
\ No newline at end of file
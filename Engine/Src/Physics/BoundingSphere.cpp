@@ -69,6 +69,28 @@ bool BoundingSphere::Overlaps(const BoundingSphere* other)
     return distanceSquared < (Radius + other->Radius)*(Radius + other->Radius);
 }
 
+bool BoundingSphere::IntersectsRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, float& entryDistance) const
+{
+    Vector3 offset = origin - Center;
+    float radius = Radius + margin;
+    float c = offset.MagnitudeSqrd() - radius * radius;
+    if (c <= 0.0f)
+    {
+        // The ray starts inside the sphere
+        entryDistance = 0.0f;
+        return true;
+    }
+
+    // Solve |offset + t * direction| = radius for the first t, if the ray is heading toward the sphere
+    float b = offset.Dot(direction);
+    float discriminant = b * b - c;
+    if (b > 0.0f || discriminant < 0.0f)
+        return false;
+
+    entryDistance = -b - sqrtf(discriminant);
+    return entryDistance <= maxDistance;
+}
+
 float BoundingSphere::GetSize()
 {
     // Calculate the volume of the sphere
@@ -2,12 +2,73 @@
 
 #include "Debugging/DebugDraw.h"
 #include "Math/Transformations.h"
+#include "Physics/CollisionEngine.h"
+#include "Physics/RigidBody.h"
+#include "Physics/TriangleBVH.h"
+#include "Rendering/Mesh.h"
+#include "Rendering/MeshInstance.h"
+#include "Scene/ResourceManager.h"
 #include "Serialization/HierarchicalSerializer.h"
 #include "GameObjectBase.h"
+#include "GameProject.h"
 #include "Util.h"
 
+#include <algorithm>
+
+namespace
+{
+    // Orders a compound's children by the center of their bounds along one axis
+    struct BoundsCenterComparator
+    {
+        BoundsCenterComparator(const vector<BoundingBox>& bounds, int axis)
+            : Bounds(bounds), Axis(axis)
+        {}
+
+        bool operator()(int lhs, int rhs) const
+        {
+            return Bounds[lhs].Min[Axis] + Bounds[lhs].Max[Axis] < Bounds[rhs].Min[Axis] + Bounds[rhs].Max[Axis];
+        }
+
+        const vector<BoundingBox>&  Bounds;
+        int                         Axis;
+    };
+
+    // The rotation part of a transform's world matrix, with the scale taken out
+    Matrix3x3 GetWorldRotation(Transform& transform)
+    {
+        Matrix4x4& world = transform.GetWorldMatrix();
+        Vector3 x = world.Column(0).xyz().Normalized();
+        Vector3 y = world.Column(1).xyz().Normalized();
+        Vector3 z = world.Column(2).xyz().Normalized();
+
+        Matrix3x3 rotation;
+        rotation.SetColumns(x, y, z);
+        return rotation;
+    }
+
+    // World space volume, used to share a compound's mass out between its children
+    float GetColliderVolume(Collider* collider)
+    {
+        switch (collider->GetType())
+        {
+        case Collider::BOX_COLLIDER:
+        {
+            Vector3 halfsize = ((BoxCollider*)collider)->GetWorldScaleHalfsize();
+            return 8.0f * fabsf(halfsize.x() * halfsize.y() * halfsize.z());
+        }
+        default:
+        {
+            // Approximate everything else with its bounding sphere
+            float radius = collider->GetWorldspaceBoundingRadius();
+            return (4.0f / 3.0f) * MATH_PI * radius * radius * radius;
+        }
+        }
+    }
+}
+
 Collider::Collider(GameObjectBase* gameObject)
-    : m_isStatic(true), m_gameObject(gameObject), m_center(Vector3::Zero)
+    : m_isStatic(true), m_isTrigger(false), m_layer(0), m_broadPhaseProxy(-1), m_hierarchyProxy(-1), m_registryIndex(-1), m_compound(NULL), m_gameObject(gameObject),
+      m_center(Vector3::Zero)
 {
     if (m_gameObject != NULL)
     {
@@ -31,6 +92,9 @@ Collider* Collider::Load(HierarchicalDeserializer* deserializer, GameObjectBase*
     case SPHERE_COLLIDER:   collider = new SphereCollider(gameObject);  break;
     case BOX_COLLIDER:      collider = new BoxCollider(gameObject);     break;
     case CAPSULE_COLLIDER:  collider = new CapsuleCollider(gameObject); break;
+    case MESH_COLLIDER:     collider = new MeshCollider(gameObject);    break;
+    case COMPOUND_COLLIDER: collider = new CompoundCollider(gameObject); break;
+    default:                break;      // Not a collider type
     }
 
     if (collider != NULL)
@@ -50,6 +114,9 @@ void Collider::AddToGameObject(GameObjectBase* gameObject, ColliderType type)
     case SPHERE_COLLIDER:   collider = new SphereCollider(gameObject);  break;
     case BOX_COLLIDER:      collider = new BoxCollider(gameObject);     break;
     case CAPSULE_COLLIDER:  collider = new CapsuleCollider(gameObject); break;
+    case MESH_COLLIDER:     collider = new MeshCollider(gameObject);    break;
+    case COMPOUND_COLLIDER: collider = new CompoundCollider(gameObject); break;
+    default:                break;      // Not a collider type
     }
 
     if (collider != NULL)
@@ -82,22 +149,95 @@ Transform& Collider::GetTransform()
     return m_transform;
 }
 
+bool Collider::IsTrigger()
+{
+    return m_isTrigger;
+}
+
 Vector3 Collider::GetCenter()
 {
     return m_center;
 }
 
+int Collider::GetLayer()
+{
+    return m_layer;
+}
+
+unsigned int Collider::GetLayerMask()
+{
+    return 1u << m_layer;
+}
+
 void Collider::SetStatic(bool isStatic)
 {
     m_isStatic = isStatic;
 }
 
+void Collider::SetTrigger(bool isTrigger)
+{
+    m_isTrigger = isTrigger;
+}
+
 void Collider::SetCenter(Vector3 center)
 {
     m_center = center;
     m_transform.SetLocalPosition(m_center);
 }
 
+void Collider::SetLayer(int layer)
+{
+    if (layer < 0 || layer >= MAX_COLLISION_LAYERS)
+        layer = 0;
+
+    m_layer = layer;
+}
+
+int Collider::GetBroadPhaseProxy()
+{
+    return m_broadPhaseProxy;
+}
+
+void Collider::SetBroadPhaseProxy(int proxy)
+{
+    m_broadPhaseProxy = proxy;
+}
+
+int Collider::GetHierarchyProxy()
+{
+    return m_hierarchyProxy;
+}
+
+void Collider::SetHierarchyProxy(int proxy)
+{
+    m_hierarchyProxy = proxy;
+}
+
+int Collider::GetRegistryIndex()
+{
+    return m_registryIndex;
+}
+
+void Collider::SetRegistryIndex(int index)
+{
+    m_registryIndex = index;
+}
+
+CompoundCollider* Collider::GetCompound()
+{
+    return m_compound;
+}
+
+void Collider::SetCompound(CompoundCollider* compound)
+{
+    m_compound = compound;
+}
+
+GameObjectBase* Collider::GetBodyObject()
+{
+    return m_compound != NULL ? m_compound->GetGameObject() : m_gameObject;
+}
+
 //------------------------------------------------------------------------------------
 
 SphereCollider::SphereCollider(GameObjectBase* gameObject, float radius)
@@ -110,6 +250,8 @@ void SphereCollider::Save(HierarchicalSerializer* serializer)
     serializer->PushScope("Collider");
     serializer->SetAttribute("Type", Collider::SPHERE_COLLIDER);
     serializer->SetAttribute("IsStatic", m_isStatic);
+    serializer->SetAttribute("IsTrigger", m_isTrigger);
+    serializer->SetAttribute("Layer", m_layer);
     serializer->SetAttribute("Radius", m_radius);
     serializer->InsertLeafVector3("Center", m_center);
     serializer->PopScope();
@@ -121,6 +263,14 @@ void SphereCollider::Load(HierarchicalDeserializer* deserializer)
     deserializer->GetAttribute("IsStatic", isStatic);
     SetStatic(isStatic);
 
+    bool isTrigger = false;
+    deserializer->GetAttribute("IsTrigger", isTrigger);
+    SetTrigger(isTrigger);
+
+    int layer = 0;
+    deserializer->GetAttribute("Layer", layer);
+    SetLayer(layer);
+
     Vector3 center;
     deserializer->ReadLeafVector3("Center", center);
     SetCenter(center);
@@ -175,6 +325,8 @@ void BoxCollider::Save(HierarchicalSerializer* serializer)
     serializer->PushScope("Collider");
     serializer->SetAttribute("Type", Collider::BOX_COLLIDER);
     serializer->SetAttribute("IsStatic", m_isStatic);
+    serializer->SetAttribute("IsTrigger", m_isTrigger);
+    serializer->SetAttribute("Layer", m_layer);
     serializer->InsertLeafVector3("Center", m_center);
     serializer->InsertLeafVector3("Size", m_size);
     serializer->PopScope();
@@ -186,6 +338,14 @@ void BoxCollider::Load(HierarchicalDeserializer* deserializer)
     deserializer->GetAttribute("IsStatic", isStatic);
     SetStatic(isStatic);
 
+    bool isTrigger = false;
+    deserializer->GetAttribute("IsTrigger", isTrigger);
+    SetTrigger(isTrigger);
+
+    int layer = 0;
+    deserializer->GetAttribute("Layer", layer);
+    SetLayer(layer);
+
     Vector3 center;
     deserializer->ReadLeafVector3("Center", center);
     SetCenter(center);
@@ -252,6 +412,8 @@ void CapsuleCollider::Save(HierarchicalSerializer* serializer)
     serializer->PushScope("Collider");
     serializer->SetAttribute("Type", Collider::CAPSULE_COLLIDER);
     serializer->SetAttribute("IsStatic", m_isStatic);
+    serializer->SetAttribute("IsTrigger", m_isTrigger);
+    serializer->SetAttribute("Layer", m_layer);
     serializer->SetAttribute("Radius", m_radius);
     serializer->SetAttribute("Height", m_height);
     serializer->SetAttribute("Axis", m_axis);
@@ -265,6 +427,14 @@ void CapsuleCollider::Load(HierarchicalDeserializer* deserializer)
     deserializer->GetAttribute("IsStatic", isStatic);
     SetStatic(isStatic);
 
+    bool isTrigger = false;
+    deserializer->GetAttribute("IsTrigger", isTrigger);
+    SetTrigger(isTrigger);
+
+    int layer = 0;
+    deserializer->GetAttribute("Layer", layer);
+    SetLayer(layer);
+
     Vector3 center;
     deserializer->ReadLeafVector3("Center", center);
     SetCenter(center);
@@ -296,8 +466,7 @@ float CapsuleCollider::GetWorldspaceBoundingRadius()
 
 Matrix3x3 CapsuleCollider::GetInertiaTensor(float mass)
 {
-    // TODO implement for real
-    return Matrix3x3::Identity;
+    return InertiaTensorCapsule(m_radius, m_height, m_axis, mass);
 }
 
 void CapsuleCollider::DebugDraw(ColorRGB color, bool useDepth)
@@ -305,6 +474,8 @@ void CapsuleCollider::DebugDraw(ColorRGB color, bool useDepth)
     if (m_debugCapsule == NULL)
     {
         RefreshDebugInfo();
+        if (m_debugCapsule == NULL)
+            return;
     }
 
     Matrix4x4 r = RotationEulerAngles(m_transform.GetWorldRotation());
@@ -371,11 +542,496 @@ void CapsuleCollider::RefreshDebugInfo()
     if (m_debugCapsule != NULL)
     {
         delete m_debugCapsule;
+        m_debugCapsule = NULL;
     }
 
+    // There's no GL context to build the capsule's buffers in when running headless
+    if (GameProject::Singleton().IsHeadless())
+        return;
+
     float worldRadius = CalculateWorldRadius();
     float worldHeight = CalculateWorldHeight();
 
     m_debugCapsule = new DebugCapsule();
     m_debugCapsule->Init(worldRadius, worldHeight, 10, m_axis);
+}
+
+//------------------------------------------------------------------------------------
+
+MeshCollider::MeshCollider(GameObjectBase* gameObject, Mesh* mesh)
+    : Collider(gameObject), m_mesh(NULL)
+{
+    SetMesh(mesh);
+}
+
+void MeshCollider::Save(HierarchicalSerializer* serializer)
+{
+    unsigned int guid = 0;
+    if (m_mesh != NULL)
+    {
+        guid = m_mesh->GetResourceInfo()->guid;
+    }
+
+    serializer->PushScope("Collider");
+    serializer->SetAttribute("Type", Collider::MESH_COLLIDER);
+    serializer->SetAttribute("IsStatic", m_isStatic);
+    serializer->SetAttribute("IsTrigger", m_isTrigger);
+    serializer->SetAttribute("Layer", m_layer);
+    serializer->SetAttribute("Mesh", guid);
+    serializer->InsertLeafVector3("Center", m_center);
+    serializer->PopScope();
+}
+
+void MeshCollider::Load(HierarchicalDeserializer* deserializer)
+{
+    bool isStatic;
+    deserializer->GetAttribute("IsStatic", isStatic);
+    SetStatic(isStatic);
+
+    bool isTrigger = false;
+    deserializer->GetAttribute("IsTrigger", isTrigger);
+    SetTrigger(isTrigger);
+
+    int layer = 0;
+    deserializer->GetAttribute("Layer", layer);
+    SetLayer(layer);
+
+    Vector3 center;
+    deserializer->ReadLeafVector3("Center", center);
+    SetCenter(center);
+
+    unsigned int guid = 0;
+    deserializer->GetAttribute("Mesh", guid);
+    Mesh* mesh = NULL;
+    if (guid != 0)
+    {
+        mesh = ResourceManager::Singleton().GetMesh(guid);
+        if (mesh == NULL)
+        {
+            printf("Warning: mesh referenced by mesh collider is not loaded\n");
+        }
+    }
+    SetMesh(mesh);
+}
+
+Collider::ColliderType MeshCollider::GetType()
+{
+    return Collider::MESH_COLLIDER;
+}
+
+float MeshCollider::GetWorldspaceBoundingRadius()
+{
+    if (m_mesh == NULL)
+        return 0.0f;
+
+    float scale = m_transform.GetWorldScale().MaxElement();
+    return m_mesh->GetBoundingRadius() * scale;
+}
+
+Matrix3x3 MeshCollider::GetInertiaTensor(float mass)
+{
+    // Mesh colliders are meant to be static, so approximate the mesh with its bounding box
+    TriangleBVH* triangleBVH = GetTriangleBVH();
+    if (triangleBVH == NULL || triangleBVH->GetTriangleCount() == 0)
+        return Matrix3x3::Identity;
+
+    return InertiaTensorCuboid(triangleBVH->GetBounds().GetHalfsize(), mass);
+}
+
+void MeshCollider::DebugDraw(ColorRGB color, bool useDepth)
+{
+    TriangleBVH* triangleBVH = GetTriangleBVH();
+    if (triangleBVH == NULL || triangleBVH->GetTriangleCount() == 0)
+        return;
+
+    const BoundingBox& bounds = triangleBVH->GetBounds();
+    Matrix4x4 m = m_transform.GetWorldMatrix() * Translation(bounds.GetCenter()) * Scaling(bounds.GetHalfsize());
+    DebugDraw::Singleton().DrawCube(m, color, useDepth);
+}
+
+Mesh* MeshCollider::GetMesh()
+{
+    return m_mesh;
+}
+
+void MeshCollider::SetMesh(Mesh* mesh)
+{
+    if (mesh == NULL && m_gameObject != NULL && m_gameObject->GetMeshInstance() != NULL)
+    {
+        mesh = m_gameObject->GetMeshInstance()->GetMesh();
+    }
+
+    // Build the tree now, so the narrow phase never has to
+    m_mesh = mesh;
+    if (m_mesh != NULL)
+    {
+        m_mesh->GetTriangleBVH();
+    }
+}
+
+TriangleBVH* MeshCollider::GetTriangleBVH()
+{
+    // Looked up every time, since the mesh frees its tree when it's deleted
+    return m_mesh != NULL ? m_mesh->GetTriangleBVH() : NULL;
+}
+
+//------------------------------------------------------------------------------------
+
+CompoundCollider::CompoundCollider(GameObjectBase* gameObject)
+    : Collider(gameObject), m_localRadius(0.0f), m_triggerChildCount(0), m_inertiaTensor(Matrix3x3::Identity),
+      m_boundsDirty(false), m_childrenChanged(false), m_inertiaDirty(false)
+{
+}
+
+CompoundCollider::~CompoundCollider()
+{
+    for (unsigned int i = 0; i < m_children.size(); i++)
+    {
+        m_children[i]->SetCompound(NULL);
+    }
+}
+
+void CompoundCollider::Save(HierarchicalSerializer* serializer)
+{
+    // Children are added at runtime, so only the compound's own settings are saved
+    serializer->PushScope("Collider");
+    serializer->SetAttribute("Type", Collider::COMPOUND_COLLIDER);
+    serializer->SetAttribute("IsStatic", m_isStatic);
+    serializer->SetAttribute("IsTrigger", m_isTrigger);
+    serializer->SetAttribute("Layer", m_layer);
+    serializer->PopScope();
+}
+
+void CompoundCollider::Load(HierarchicalDeserializer* deserializer)
+{
+    bool isStatic;
+    deserializer->GetAttribute("IsStatic", isStatic);
+    SetStatic(isStatic);
+
+    bool isTrigger = false;
+    deserializer->GetAttribute("IsTrigger", isTrigger);
+    SetTrigger(isTrigger);
+
+    int layer = 0;
+    deserializer->GetAttribute("Layer", layer);
+    SetLayer(layer);
+}
+
+Collider::ColliderType CompoundCollider::GetType()
+{
+    return Collider::COMPOUND_COLLIDER;
+}
+
+float CompoundCollider::GetWorldspaceBoundingRadius()
+{
+    return m_localRadius * m_transform.GetWorldScale().MaxElement();
+}
+
+Matrix3x3 CompoundCollider::GetInertiaTensor(float mass)
+{
+    if (m_inertiaDirty)
+    {
+        CalculateInertiaTensor();
+        m_inertiaDirty = false;
+    }
+    return m_inertiaTensor * mass;
+}
+
+void CompoundCollider::DebugDraw(ColorRGB color, bool useDepth)
+{
+    for (unsigned int i = 0; i < m_children.size(); i++)
+    {
+        m_children[i]->DebugDraw(color, useDepth);
+    }
+}
+
+void CompoundCollider::AddChild(Collider* child)
+{
+    if (child == NULL || child->GetType() == COMPOUND_COLLIDER || std::find(m_children.begin(), m_children.end(), child) != m_children.end())
+        return;
+
+    // From now on the child is only tested through the compound
+    CollisionEngine::Singleton().UnregisterCollider(child);
+    child->SetCompound(this);
+    m_children.push_back(child);
+    m_boundsDirty = true;
+    m_childrenChanged = true;
+}
+
+void CompoundCollider::RemoveChild(Collider* child)
+{
+    vector<Collider*>::iterator iter = std::find(m_children.begin(), m_children.end(), child);
+    if (iter == m_children.end())
+        return;
+
+    m_children.erase(iter);
+    child->SetCompound(NULL);
+    CollisionEngine::Singleton().RegisterCollider(child);
+    m_boundsDirty = true;
+    m_childrenChanged = true;
+}
+
+void CompoundCollider::MarkChildrenMoved()
+{
+    m_boundsDirty = true;
+    m_childrenChanged = true;
+}
+
+int CompoundCollider::GetChildCount()
+{
+    return m_children.size();
+}
+
+bool CompoundCollider::HasTriggerChildren()
+{
+    return m_triggerChildCount > 0;
+}
+
+Collider* CompoundCollider::GetChild(int index)
+{
+    return m_children[index];
+}
+
+void CompoundCollider::RecomputeChildTransforms()
+{
+    for (unsigned int i = 0; i < m_children.size(); i++)
+    {
+        m_children[i]->GetTransform().RecomputeIfDirty();
+    }
+}
+
+void CompoundCollider::QueryChildren(const BoundingBox& worldBox, vector<int>& results)
+{
+    if (m_nodes.size() == 0)
+        return;
+
+    // Bring the box into the compound's space, growing it to hold the rotated box
+    Matrix4x4& inverse = m_transform.GetInverseWorldMatrix();
+    Vector3 worldCenter = worldBox.GetCenter();
+    Vector3 worldHalfsize = worldBox.GetHalfsize();
+    Vector3 center = (inverse * Vector4(worldCenter, 1)).xyz();
+    Vector3 halfsize;
+    for (int i = 0; i < 3; i++)
+    {
+        halfsize[i] = fabsf(inverse[i][0]) * worldHalfsize.x() + fabsf(inverse[i][1]) * worldHalfsize.y() + fabsf(inverse[i][2]) * worldHalfsize.z();
+    }
+    BoundingBox box(center - halfsize, center + halfsize);
+
+    int stack[COMPOUND_BVH_MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        int index = stack[--stackSize];
+        const Node& node = m_nodes[index];
+        if (!node.Box.Overlaps(&box))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            for (int i = node.Start; i < node.Start + node.Count; i++)
+            {
+                results.push_back(i);
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.Start;
+            stack[stackSize++] = index + 1;
+        }
+    }
+}
+
+void CompoundCollider::QueryChildrenRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, vector<int>& results)
+{
+    if (m_nodes.size() == 0)
+        return;
+
+    // Distances along the ray are the same in the compound's space, since the direction is transformed without
+    // normalizing. The margin shrinks by the smallest scale at most.
+    Vector3 localOrigin = m_transform.InverseTransformPoint(origin);
+    Vector3 localDirection = m_transform.InverseTransformVector(direction);
+    Vector3 inverseDirection(1.0f / localDirection.x(), 1.0f / localDirection.y(), 1.0f / localDirection.z());
+    float minScale = m_transform.GetWorldScale().MinElement();
+    float localMargin = minScale > 0.0f ? margin / minScale : margin;
+
+    int stack[COMPOUND_BVH_MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        int index = stack[--stackSize];
+        const Node& node = m_nodes[index];
+        float entryDistance;
+        if (!node.Box.IntersectsRay(localOrigin, inverseDirection, maxDistance, localMargin, entryDistance))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            for (int i = node.Start; i < node.Start + node.Count; i++)
+            {
+                results.push_back(i);
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.Start;
+            stack[stackSize++] = index + 1;
+        }
+    }
+}
+
+void CompoundCollider::Refresh()
+{
+    if (m_boundsDirty)
+    {
+        m_boundsDirty = false;
+        RebuildBounds();
+
+        m_triggerChildCount = 0;
+        for (unsigned int i = 0; i < m_children.size(); i++)
+        {
+            if (m_children[i]->IsTrigger())
+            {
+                m_triggerChildCount++;
+            }
+        }
+    }
+
+    if (m_childrenChanged)
+    {
+        // The tensor itself is worked out when the rigid body asks for it
+        m_childrenChanged = false;
+        m_inertiaDirty = true;
+        RigidBody* rigidBody = (m_gameObject != NULL ? m_gameObject->GetRigidBody() : NULL);
+        if (rigidBody != NULL)
+        {
+            rigidBody->UpdateInertiaTensor();
+        }
+    }
+}
+
+void CompoundCollider::RebuildBounds()
+{
+    m_nodes.clear();
+    m_localRadius = 0.0f;
+    if (m_children.size() == 0 || m_gameObject == NULL)
+        return;
+
+    // Find each child's bounds in the game object's space, and center the compound on all of them
+    Transform& objectTransform = m_gameObject->GetTransform();
+    float minScale = objectTransform.GetWorldScale().MinElement();
+    float inverseScale = minScale > 0.0f ? 1.0f / minScale : 1.0f;
+
+    int childCount = m_children.size();
+    vector<BoundingBox> bounds(childCount);
+    vector<int> order(childCount);
+    BoundingBox merged;
+    for (int i = 0; i < childCount; i++)
+    {
+        Vector3 center = objectTransform.InverseTransformPoint(m_children[i]->GetWorldPosition());
+        float radius = m_children[i]->GetWorldspaceBoundingRadius() * inverseScale;
+        Vector3 halfsize(radius, radius, radius);
+        bounds[i] = BoundingBox(center - halfsize, center + halfsize);
+        merged = (i == 0 ? bounds[i] : BoundingBox(merged, bounds[i]));
+        order[i] = i;
+    }
+
+    Vector3 mergedCenter = merged.GetCenter();
+    m_transform.SetLocalPosition(mergedCenter);
+    for (int i = 0; i < childCount; i++)
+    {
+        bounds[i].Min -= mergedCenter;
+        bounds[i].Max -= mergedCenter;
+
+        Vector3 halfsize = bounds[i].GetHalfsize();
+        m_localRadius = fmaxf(m_localRadius, bounds[i].GetCenter().Magnitude() + halfsize.x());
+    }
+
+    m_nodes.reserve(childCount * 2);
+    BuildNode(0, childCount, bounds, order);
+
+    // Store the children in the order the leaves reference them
+    vector<Collider*> children(m_children);
+    for (int i = 0; i < childCount; i++)
+    {
+        m_children[i] = children[order[i]];
+    }
+}
+
+void CompoundCollider::BuildNode(int begin, int end, vector<BoundingBox>& bounds, vector<int>& order)
+{
+    int index = m_nodes.size();
+    m_nodes.push_back(Node());
+
+    BoundingBox box = bounds[order[begin]];
+    for (int i = begin + 1; i < end; i++)
+    {
+        box = BoundingBox(box, bounds[order[i]]);
+    }
+    m_nodes[index].Box = box;
+
+    if (end - begin <= COMPOUND_BVH_LEAF_SIZE)
+    {
+        m_nodes[index].Start = begin;
+        m_nodes[index].Count = end - begin;
+        return;
+    }
+
+    // Compounds hold a few hundred children at most, so a median split on the longest axis is enough
+    Vector3 extents = box.Max - box.Min;
+    int axis = 0;
+    if (extents.y() > extents[axis])    axis = 1;
+    if (extents.z() > extents[axis])    axis = 2;
+
+    int middle = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, BoundsCenterComparator(bounds, axis));
+
+    BuildNode(begin, middle, bounds, order);
+    m_nodes[index].Start = m_nodes.size();
+    m_nodes[index].Count = 0;
+    BuildNode(middle, end, bounds, order);
+}
+
+void CompoundCollider::CalculateInertiaTensor()
+{
+    m_inertiaTensor = Matrix3x3::Identity;
+    if (m_children.size() == 0 || m_gameObject == NULL)
+        return;
+
+    // Share the mass out by volume
+    vector<float> volumes(m_children.size());
+    float totalVolume = 0.0f;
+    for (unsigned int i = 0; i < m_children.size(); i++)
+    {
+        volumes[i] = GetColliderVolume(m_children[i]);
+        totalVolume += volumes[i];
+    }
+
+    // Sum the children's tensors in the body's space, about the game object's origin (which the body turns about)
+    Transform& objectTransform = m_gameObject->GetTransform();
+    Vector3 origin = objectTransform.GetWorldPosition();
+    Matrix3x3 inverseBodyRotation = GetWorldRotation(objectTransform).Transpose();
+
+    Matrix3x3 tensor;
+    for (unsigned int i = 0; i < m_children.size(); i++)
+    {
+        Collider* child = m_children[i];
+        float mass = totalVolume > 0.0f ? volumes[i] / totalVolume : 1.0f / m_children.size();
+
+        Matrix3x3 rotation = inverseBodyRotation * GetWorldRotation(child->GetTransform());
+        Matrix3x3 childTensor = rotation * child->GetInertiaTensor(mass) * rotation.Transpose();
+
+        // Parallel axis theorem, to move the child's tensor from its own center to the body's origin
+        Vector3 d = inverseBodyRotation * (child->GetWorldPosition() - origin);
+        float dd = d.MagnitudeSqrd();
+        Matrix3x3 offset(Vector3(dd - d.x()*d.x(),    -d.x()*d.y(),      -d.x()*d.z()),
+                         Vector3(   -d.y()*d.x(), dd - d.y()*d.y(),      -d.y()*d.z()),
+                         Vector3(   -d.z()*d.x(),    -d.z()*d.y(), dd - d.z()*d.z()));
+
+        tensor = (i == 0 ? childTensor + offset * mass : tensor + childTensor + offset * mass);
+    }
+    m_inertiaTensor = tensor;
 }
\ No newline at end of file
@@ -3,48 +3,83 @@
 #include "GameObjectBase.h"
 #include "Math\Transformations.h"
 #include "Physics\Collider.h"
+#include "Physics\TriangleBVH.h"
+
+#define CLIP_FEATURE_ID_BASE 8              // Incident vertices use IDs 0-7, clipped points (edge or side plane, and clipping plane) follow
+#define EDGE_EDGE_FEATURE_ID_BASE 1024      // Face contact feature IDs are all below this
+#define EDGE_AXIS_RELATIVE_TOLERANCE 0.05f  // Edge axes must beat the best face axis by this fraction of their overlap...
+#define EDGE_AXIS_ABSOLUTE_TOLERANCE 0.01f  // ...plus this distance
+#define TRIANGLE_FEATURE_ID_SHIFT 10        // Mesh contacts put the triangle above the features of the contact within the triangle
+#define BOX_FACE_FEATURE_ID_BASE 64         // Triangle face contacts use IDs below this, box face contacts follow...
+#define TRIANGLE_EDGE_FEATURE_ID_BASE 512   // ...then box edge and triangle edge contacts
+
+// Packs the signs of a point's coordinates into three bits, to tell apart the vertices or edges of a box
+unsigned int GetSignBits(const Vector3& point)
+{
+    return (point.x() < 0 ? 1 : 0) | (point.y() < 0 ? 2 : 0) | (point.z() < 0 ? 4 : 0);
+}
+
+// Empty buffer for the triangles a mesh test finds. There's one per thread, as the narrow phase runs on the
+// worker pool, and it keeps its capacity so the tests don't allocate.
+vector<int>& GetMeshTriangleScratch()
+{
+    static thread_local vector<int> triangles;
+    triangles.clear();
+    triangles.reserve(MESH_QUERY_CAPACITY);
+    return triangles;
+}
+
+ContactBufferStats::ContactBufferStats()
+    : Count(0), Peak(0), Truncated(0), TotalTruncated(0)
+{}
+
+void ContactBufferStats::Record(unsigned int count, unsigned int truncated)
+{
+    Count = count;
+    Truncated = truncated;
+    TotalTruncated += truncated;
+    if (count > Peak)
+    {
+        Peak = count;
+    }
+}
 
 CollisionData::CollisionData(int maxContacts)
 {
-    Contacts = new CollisionContact[maxContacts];
-    NextEmptyContact = Contacts;
+    Contacts.reserve(INITIAL_CONTACT_CAPACITY);
     ContactsUsed = 0;
-    ContactsRemaining = maxContacts;
+    ContactsDropped = 0;
     MaxContacts = maxContacts;
 }
 
-CollisionData::~CollisionData()
-{
-    delete[] Contacts;
-};
-
 CollisionContact* CollisionData::ClaimNextContact()
 {
-    if (ContactsRemaining <= 0)
+    if (ContactsUsed >= MaxContacts)
     {
+        ContactsDropped++;
         return NULL;
     }
 
-    CollisionContact* ret = NextEmptyContact;
-    ContactsRemaining--;
-    ContactsUsed++;
-    NextEmptyContact++;
-    return ret;
+    // Contacts are never removed, so the buffer only grows until it reaches the busiest frame's size
+    if (ContactsUsed == (int)Contacts.size())
+    {
+        Contacts.push_back(CollisionContact());
+    }
 
+    CollisionContact* contact = &Contacts[ContactsUsed++];
+    contact->FeatureId = 0;
+    contact->CachedPoint = NULL;
+    return contact;
 }
 
 void CollisionData::Reset()
 {
-    NextEmptyContact = Contacts;
     ContactsUsed = 0;
-    ContactsRemaining = MaxContacts;
+    ContactsDropped = 0;
 }
 
-unsigned int CollisionDetection::SphereAndSphere(SphereCollider* a, SphereCollider* b, CollisionData* data)
+unsigned int CollisionDetection::SphereAndSphere(SphereCollider* a, SphereCollider* b, CollisionData* data, float speculativeDistance)
 {
-    if (data->ContactsRemaining <= 0)
-        return 0;
-
     // Cache world positions & radii
     Vector3 aPos = a->GetWorldPosition();
     Vector3 bPos = b->GetWorldPosition();
@@ -54,13 +89,16 @@ unsigned int CollisionDetection::SphereAndSphere(SphereCollider* a, SphereCollid
     // See if distance between positions is small enough
     Vector3 midline = aPos - bPos;
     float distance = midline.Magnitude();
-    if (distance <= 0.0f || distance >= aRadius + bRadius)
+    if (distance <= 0.0f || distance >= aRadius + bRadius + speculativeDistance)
     {
         return 0;
     }
 
     // There is contact, so add contact data to the list
     CollisionContact* contact = data->ClaimNextContact();
+    if (contact == NULL)
+        return 0;
+
     contact->ContactPoint = aPos - midline * 0.5f;
     contact->ContactNormal = midline * (1.0f / distance);
     contact->Penetration = aRadius + bRadius - distance;
@@ -70,7 +108,7 @@ unsigned int CollisionDetection::SphereAndSphere(SphereCollider* a, SphereCollid
     return 1;
 }
 
-unsigned int CollisionDetection::SphereAndBox(SphereCollider* s, BoxCollider* b, CollisionData* data)
+unsigned int CollisionDetection::SphereAndBox(SphereCollider* s, BoxCollider* b, CollisionData* data, float speculativeDistance)
 {
     // If the box has zero scale along any axis, no collision is possible
     Vector3 boxWorldScale = b->GetTransform().GetWorldScale();
@@ -88,7 +126,8 @@ unsigned int CollisionDetection::SphereAndBox(SphereCollider* s, BoxCollider* b,
 
     // Convert the scale (radius) of the sphere into the local space of the box
     float sphereWorldRadius = s->GetWorldspaceBoundingRadius();
-    Vector3 sphereBoxspaceScale = sphereWorldRadius * boxWorldScale.ComponentwiseInverse();
+    float contactRadius = sphereWorldRadius + speculativeDistance;
+    Vector3 sphereBoxspaceScale = contactRadius * boxWorldScale.ComponentwiseInverse();
 
     // Early out check to see if we can exclude the contact
     if (abs(sphereBoxspacePos.x()) - sphereBoxspaceScale.x() > boxHalfsize.x() ||
@@ -122,13 +161,16 @@ unsigned int CollisionDetection::SphereAndBox(SphereCollider* s, BoxCollider* b,
     // we are close enough for contact
     Vector3 closestPointWorldspace = b->GetTransform().TransformPoint(closestPoint);
     float distanceSqrd = (closestPointWorldspace - sphereWorldPos).MagnitudeSqrd();
-    if (distanceSqrd > sphereWorldRadius * sphereWorldRadius)
+    if (distanceSqrd > contactRadius * contactRadius)
     {
         return 0;
     }
 
     // The point is close enough and therefore there is a contact. Set contact data
     CollisionContact* contact = data->ClaimNextContact();
+    if (contact == NULL)
+        return 0;
+
     contact->ContactPoint = closestPointWorldspace;
     // TODO ontact normal sign has been flipped - not sure if this is correct
     contact->ContactNormal = (sphereWorldPos - closestPointWorldspace).Normalized();
@@ -139,14 +181,14 @@ unsigned int CollisionDetection::SphereAndBox(SphereCollider* s, BoxCollider* b,
     return 1;
 }
 
-unsigned int CollisionDetection::BoxAndBox(BoxCollider* a, BoxCollider* b, CollisionData* data)
+unsigned int CollisionDetection::BoxAndBox(BoxCollider* a, BoxCollider* b, CollisionData* data, float speculativeDistance)
 {
     // Determine whether the boxes overlap by performing separating axis tests (SATs)
     // In this case (box-and-box) there are 15 axis tests to consider.
     const int NUM_CASES = 15;
     Vector3 axes[NUM_CASES];
-    Transform aTrans = a->GetTransform();
-    Transform bTrans = b->GetTransform();
+    Transform& aTrans = a->GetTransform();
+    Transform& bTrans = b->GetTransform();
 
     // Face axes for box A
     axes[0] = aTrans.GetRight();
@@ -171,6 +213,7 @@ unsigned int CollisionDetection::BoxAndBox(BoxCollider* a, BoxCollider* b, Colli
 
     // Perform test for each axis to find the case with the best overlap
     float bestOverlap = FLT_MAX;
+    float bestScore = FLT_MAX;
     unsigned int bestCase;
     Vector3 centerAToCenterB = b->GetTransform().GetWorldPosition() - a->GetTransform().GetWorldPosition();
     for (int i = 0; i < NUM_CASES; i++)
@@ -185,14 +228,24 @@ unsigned int CollisionDetection::BoxAndBox(BoxCollider* a, BoxCollider* b, Colli
 
         axis.Normalize();
         float overlap = PenetrationOnAxis(a, b, axis, centerAToCenterB);
-        if (overlap < 0)
+        if (overlap < -speculativeDistance)
         {
             // A single case of negative overlap indicates that there can be no collision
+            // (or, for speculative contacts, that the boxes are too far apart to touch this step)
             return 0;
         }
-        if (overlap < bestOverlap)
+
+        // Face contacts give a full manifold, so an edge axis is only used when it's clearly better.
+        // Otherwise a face resting almost flat flickers between face and edge contacts.
+        float score = overlap;
+        if (i >= 6)
+        {
+            score = overlap + abs(overlap) * EDGE_AXIS_RELATIVE_TOLERANCE + EDGE_AXIS_ABSOLUTE_TOLERANCE;
+        }
+        if (score < bestScore)
         {
-            // Overlap is positive, indiating there *may* be a contact
+            // Overlap is positive (or within the speculative distance), indiating there *may* be a contact
+            bestScore = score;
             bestOverlap = overlap;
             bestCase = i;
         }
@@ -202,15 +255,14 @@ unsigned int CollisionDetection::BoxAndBox(BoxCollider* a, BoxCollider* b, Colli
     Vector3 axis = axes[bestCase];
     if (bestCase < 3)
     {
-        // Contact between face of box A and vertex of box B
-        SetFaceVertexContactData(a, b, centerAToCenterB, data, axis, bestOverlap);
-        return 1;
+        // Contact between face of box A and face, edge or vertex of box B
+        return SetFaceContactData(a, b, centerAToCenterB, data, axis, bestCase, speculativeDistance);
     }
     else if (bestCase < 6)
     {
-        // Contact between face of box B and vertex of box A
-        SetFaceVertexContactData(b, a, -1.0f*centerAToCenterB, data, axis, bestOverlap);
-        return 1;
+        // Contact between face of box B and face, edge or vertex of box A
+        Vector3 centerBToCenterA = -1.0f * centerAToCenterB;
+        return SetFaceContactData(b, a, centerBToCenterA, data, axis, bestCase, speculativeDistance);
     }
     else
     {
@@ -220,8 +272,7 @@ unsigned int CollisionDetection::BoxAndBox(BoxCollider* a, BoxCollider* b, Colli
         unsigned int twoAxisIndex = bestCase % 3;
 
         // Calculate contact data
-        SetEdgeEdgeContactData(a, b, data, oneAxisIndex, twoAxisIndex, centerAToCenterB, bestOverlap);
-        return 1;
+        return SetEdgeEdgeContactData(a, b, data, oneAxisIndex, twoAxisIndex, centerAToCenterB, bestOverlap);
     }
 
     return 0;
@@ -229,7 +280,7 @@ unsigned int CollisionDetection::BoxAndBox(BoxCollider* a, BoxCollider* b, Colli
 
 float CollisionDetection::ProjectToAxis(BoxCollider* box, Vector3& axis)
 {
-    Transform transform = box->GetTransform();
+    Transform& transform = box->GetTransform();
     Vector3 halfsize = box->GetWorldScaleHalfsize();
 
     float projection =  halfsize.x() * abs(axis.Dot(transform.GetRight())) +
@@ -250,39 +301,245 @@ float CollisionDetection::PenetrationOnAxis(BoxCollider* a, BoxCollider* b, Vect
     return projectionA + projectionB - distance;
 }
 
-void CollisionDetection::SetFaceVertexContactData(BoxCollider* faceBox, BoxCollider* vertexBox, Vector3& centerToCenter, CollisionData* data, Vector3 axis, float bestOverlap)
+unsigned int CollisionDetection::SetFaceContactData(BoxCollider* faceBox, BoxCollider* incidentBox, Vector3& centerToCenter, CollisionData* data, Vector3 axis, unsigned int faceAxisIndex, float speculativeDistance)
 {
-    // Determine which face is in contact (we know it's one of the two along the given axis)
+    // Determine which face is in contact (we know it's one of the two along the given axis). The
+    // contact normal points back into the face box, so the face's outward normal is its negation.
+    bool negativeFace = false;
     if (axis.Dot(centerToCenter) > 0)
     {
         axis = -1.0f * axis;
+        negativeFace = true;
     }
+    Vector3 faceNormal = -1.0f * axis;
+
+    // The reference face is bounded by four side planes, along the face box's other two axes
+    Transform& faceTrans = faceBox->GetTransform();
+    Vector3 faceHalfsize = faceBox->GetWorldScaleHalfsize();
+    unsigned int faceBoxAxis = faceAxisIndex % 3;
+    Vector3 faceCenter = faceTrans.GetWorldPosition() + faceNormal * faceHalfsize[faceBoxAxis];
 
-    // Determine which vertex of the other box is in the contact, in that box's coordinate space
-    Vector3 vertex = vertexBox->GetWorldScaleHalfsize();
-    if (vertexBox->GetTransform().GetRight().Dot(axis) < 0)
+    Vector3 sideNormals[4];
+    float sideOffsets[4];
+    for (int i = 0; i < 2; i++)
     {
-        vertex.SetX(-vertex.x());
+        int sideAxis = (faceBoxAxis + 1 + i) % 3;
+        Vector3 sideNormal = faceTrans.GetAxis(sideAxis);
+        float centerOffset = sideNormal.Dot(faceCenter);
+        sideNormals[i * 2] = sideNormal;
+        sideOffsets[i * 2] = centerOffset + faceHalfsize[sideAxis];
+        sideNormals[i * 2 + 1] = -1.0f * sideNormal;
+        sideOffsets[i * 2 + 1] = -centerOffset + faceHalfsize[sideAxis];
     }
-    if (vertexBox->GetTransform().GetUp().Dot(axis) < 0)
+
+    // The incident face is the face of the other box that is most anti-parallel to the reference face
+    Transform& incidentTrans = incidentBox->GetTransform();
+    unsigned int incidentAxis = 0;
+    float bestDot = 0.0f;
+    for (int i = 0; i < 3; i++)
     {
-        vertex.SetY(-vertex.y());
+        float dot = incidentTrans.GetAxis(i).Dot(faceNormal);
+        if (abs(dot) > abs(bestDot))
+        {
+            bestDot = dot;
+            incidentAxis = i;
+        }
     }
-    if (vertexBox->GetTransform().GetForward().Dot(axis) < 0)
+
+    // Build the incident face's corners (in the box's local space, so the transform applies its scale),
+    // winding around the face so that consecutive corners share an edge
+    Vector3 localSize = incidentBox->GetLocalSize();
+    unsigned int u = (incidentAxis + 1) % 3;
+    unsigned int v = (incidentAxis + 2) % 3;
+    const float windingU[4] = { 1.0f, -1.0f, -1.0f, 1.0f };
+    const float windingV[4] = { 1.0f, 1.0f, -1.0f, -1.0f };
+
+    ClipVertex polygon[MAX_CLIP_VERTICES];
+    int vertexCount = 4;
+    for (int i = 0; i < 4; i++)
     {
-        vertex.SetZ(-vertex.z());
+        Vector3 corner;
+        corner[incidentAxis] = bestDot > 0 ? -localSize[incidentAxis] : localSize[incidentAxis];
+        corner[u] = windingU[i] * localSize[u];
+        corner[v] = windingV[i] * localSize[v];
+
+        polygon[i].Point = incidentTrans.TransformPoint(corner);
+        polygon[i].FeatureId = GetSignBits(corner);
+        polygon[i].EdgeFeature = i;
     }
 
-    // Set the contact data
-    CollisionContact* contact = data->ClaimNextContact();
-    contact->ContactPoint = vertexBox->GetTransform().TransformPoint(vertex);
-    contact->ContactNormal = axis;
-    contact->Penetration = bestOverlap;
-    contact->ColliderA = faceBox;
-    contact->ColliderB = vertexBox;
+    // Clip the incident face against the side planes of the reference face
+    ClipVertex clipped[MAX_CLIP_VERTICES];
+    for (int i = 0; i < 4 && vertexCount > 0; i++)
+    {
+        vertexCount = ClipPolygon(polygon, vertexCount, sideNormals[i], sideOffsets[i], i, clipped);
+        for (int j = 0; j < vertexCount; j++)
+        {
+            polygon[j] = clipped[j];
+        }
+    }
+
+    // Only the clipped points below the reference face (or within the speculative distance above it) are in contact
+    float faceOffset = faceNormal.Dot(faceCenter);
+    float depths[MAX_CLIP_VERTICES];
+    int contactCount = 0;
+    for (int i = 0; i < vertexCount; i++)
+    {
+        float depth = faceOffset - faceNormal.Dot(polygon[i].Point);
+        if (depth >= -speculativeDistance)
+        {
+            polygon[contactCount] = polygon[i];
+            depths[contactCount] = depth;
+            contactCount++;
+        }
+    }
+
+    int selected[MAX_BOX_CONTACTS];
+    contactCount = ReduceContactPoints(polygon, depths, contactCount, selected);
+
+    unsigned int faceId = faceAxisIndex * 2 + (negativeFace ? 1 : 0);
+    unsigned int added = 0;
+    for (int i = 0; i < contactCount; i++)
+    {
+        CollisionContact* contact = data->ClaimNextContact();
+        if (contact == NULL)
+            break;
+
+        const ClipVertex& point = polygon[selected[i]];
+        contact->ContactPoint = point.Point;
+        contact->ContactNormal = axis;
+        contact->Penetration = depths[selected[i]];
+        contact->ColliderA = faceBox;
+        contact->ColliderB = incidentBox;
+
+        // Feature ID: which reference face, against which incident vertex or clipped edge
+        contact->FeatureId = 1 + ((faceId << 6) | point.FeatureId);
+        added++;
+    }
+
+    return added;
+}
+
+int CollisionDetection::ClipPolygon(ClipVertex* input, int inputCount, Vector3& planeNormal, float planeOffset, int planeIndex, ClipVertex* output)
+{
+    // Sutherland-Hodgman clipping against a single plane, keeping the side behind the plane. Each
+    // vertex remembers which line its outgoing edge lies on (an incident edge 0-3, or a side plane 4-7),
+    // so that new vertices can be named after the line and plane that created them.
+    int outputCount = 0;
+    for (int i = 0; i < inputCount; i++)
+    {
+        ClipVertex& current = input[i];
+        ClipVertex& next = input[(i + 1) % inputCount];
+        float currentDistance = planeNormal.Dot(current.Point) - planeOffset;
+        float nextDistance = planeNormal.Dot(next.Point) - planeOffset;
+
+        if (currentDistance <= 0.0f)
+        {
+            output[outputCount++] = current;
+        }
+
+        if ((currentDistance <= 0.0f) != (nextDistance <= 0.0f))
+        {
+            float t = currentDistance / (currentDistance - nextDistance);
+            ClipVertex& intersection = output[outputCount++];
+            intersection.Point = current.Point + (next.Point - current.Point) * t;
+            intersection.FeatureId = CLIP_FEATURE_ID_BASE + current.EdgeFeature * 4 + planeIndex;
+
+            // Leaving the plane, the rest of the edge runs along the plane. Entering, it continues on the original line.
+            intersection.EdgeFeature = currentDistance <= 0.0f ? 4 + planeIndex : current.EdgeFeature;
+        }
+    }
+    return outputCount;
+}
+
+int CollisionDetection::ReduceContactPoints(ClipVertex* points, float* depths, int count, int* selected)
+{
+    if (count <= MAX_BOX_CONTACTS)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            selected[i] = i;
+        }
+        return count;
+    }
+
+    // Keep the deepest point, then the point furthest from it, then the two that add the most area
+    // on either side of the line between them
+    int first = 0;
+    for (int i = 1; i < count; i++)
+    {
+        if (depths[i] > depths[first])
+        {
+            first = i;
+        }
+    }
+
+    int second = first;
+    float bestDistance = -1.0f;
+    for (int i = 0; i < count; i++)
+    {
+        float distance = (points[i].Point - points[first].Point).MagnitudeSqrd();
+        if (i != first && distance > bestDistance)
+        {
+            bestDistance = distance;
+            second = i;
+        }
+    }
+
+    Vector3 edge = points[second].Point - points[first].Point;
+    Vector3 referenceNormal;
+    bool hasReference = false;
+    int third = -1;
+    int fourth = -1;
+    float bestPositive = 0.0f;
+    float bestNegative = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        if (i == first || i == second)
+        {
+            continue;
+        }
+
+        // Signed area relative to the first triangle found, so points on the other side count as negative
+        Vector3 areaNormal = edge.Cross(points[i].Point - points[first].Point);
+        if (!hasReference)
+        {
+            referenceNormal = areaNormal;
+            hasReference = true;
+        }
+        float area = areaNormal.Magnitude();
+        if (areaNormal.Dot(referenceNormal) < 0.0f)
+        {
+            area = -area;
+        }
+
+        if (area >= bestPositive)
+        {
+            bestPositive = area;
+            third = i;
+        }
+        else if (area < bestNegative)
+        {
+            bestNegative = area;
+            fourth = i;
+        }
+    }
+
+    int selectedCount = 0;
+    selected[selectedCount++] = first;
+    selected[selectedCount++] = second;
+    if (third != -1)
+    {
+        selected[selectedCount++] = third;
+    }
+    if (fourth != -1)
+    {
+        selected[selectedCount++] = fourth;
+    }
+    return selectedCount;
 }
 
-void CollisionDetection::SetEdgeEdgeContactData(BoxCollider* a, BoxCollider* b, CollisionData* data, int oneAxisIndex, int twoAxisIndex, Vector3& centerToCenter, float bestOverlap)
+unsigned int CollisionDetection::SetEdgeEdgeContactData(BoxCollider* a, BoxCollider* b, CollisionData* data, int oneAxisIndex, int twoAxisIndex, Vector3& centerToCenter, float bestOverlap)
 {
     Vector3 oneAxis = a->GetTransform().GetAxis(oneAxisIndex);
     Vector3 twoAxis = b->GetTransform().GetAxis(twoAxisIndex);
@@ -295,8 +552,9 @@ void CollisionDetection::SetEdgeEdgeContactData(BoxCollider* a, BoxCollider* b,
         axis = -1.0f * axis;
     }
 
-    Vector3 pointOnEdgeOne = a->GetWorldScaleHalfsize();
-    Vector3 pointOnEdgeTwo = b->GetWorldScaleHalfsize();
+    // Points are found in each box's local space, so the transform applies its scale
+    Vector3 pointOnEdgeOne = a->GetLocalSize();
+    Vector3 pointOnEdgeTwo = b->GetLocalSize();
 
     for (int i = 0; i < 3; i++)
     {
@@ -306,12 +564,12 @@ void CollisionDetection::SetEdgeEdgeContactData(BoxCollider* a, BoxCollider* b,
         }
         else if (a->GetTransform().GetAxis(i).Dot(axis) > 0)
         {
-            pointOnEdgeTwo[i] = -pointOnEdgeOne[i];
+            pointOnEdgeOne[i] = -pointOnEdgeOne[i];
         }
 
         if (i == twoAxisIndex)
         {
-            pointOnEdgeOne[i] = 0;
+            pointOnEdgeTwo[i] = 0;
         }
         else if (b->GetTransform().GetAxis(i).Dot(axis) < 0)
         {
@@ -319,6 +577,9 @@ void CollisionDetection::SetEdgeEdgeContactData(BoxCollider* a, BoxCollider* b,
         }
     }
 
+    // Feature ID: which edge of each box, by edge axis and the signs of the other two coordinates
+    unsigned int featureId = EDGE_EDGE_FEATURE_ID_BASE + (((oneAxisIndex * 3 + twoAxisIndex) << 6) | (GetSignBits(pointOnEdgeOne) << 3) | GetSignBits(pointOnEdgeTwo));
+
     // Transform points into world space
     pointOnEdgeOne = a->GetTransform().TransformPoint(pointOnEdgeOne);
     pointOnEdgeTwo = b->GetTransform().TransformPoint(pointOnEdgeTwo);
@@ -328,11 +589,16 @@ void CollisionDetection::SetEdgeEdgeContactData(BoxCollider* a, BoxCollider* b,
 
     // Fill in contact data
     CollisionContact* contact = data->ClaimNextContact();
+    if (contact == NULL)
+        return 0;
+
     contact->ContactPoint = vertex;
     contact->ContactNormal = axis;
     contact->Penetration = bestOverlap;
     contact->ColliderA = a;
     contact->ColliderB = b;
+    contact->FeatureId = featureId;
+    return 1;
 }
 
 Vector3 CollisionDetection::GetContactPoint(Vector3& axisOne, Vector3& axisTwo, Vector3& pointOnEdgeOne, Vector3& pointOnEdgeTwo)
@@ -356,4 +622,609 @@ Vector3 CollisionDetection::GetContactPoint(Vector3& axisOne, Vector3& axisTwo,
     Vector3 nearestPointOne = pointOnEdgeOne + axisOne * a;
     Vector3 nearestPointTwo = pointOnEdgeTwo + axisTwo * b;
     return (nearestPointOne + nearestPointTwo) * 0.5f;
+}
+
+unsigned int CollisionDetection::SphereAndMesh(SphereCollider* s, MeshCollider* m, CollisionData* data, float speculativeDistance)
+{
+    TriangleBVH* bvh = m->GetTriangleBVH();
+    if (bvh == NULL)
+    {
+        return 0;
+    }
+
+    Vector3 sphereWorldPos = s->GetWorldPosition();
+    float sphereWorldRadius = s->GetWorldspaceBoundingRadius();
+    float contactRadius = sphereWorldRadius + speculativeDistance;
+
+    // Find the triangles near the sphere
+    Vector3 extents(contactRadius, contactRadius, contactRadius);
+    vector<int>& triangles = GetMeshTriangleScratch();
+    QueryMeshTriangles(m, BoundingBox(sphereWorldPos - extents, sphereWorldPos + extents), triangles);
+
+    Transform& meshTrans = m->GetTransform();
+    unsigned int added = 0;
+    for (unsigned int i = 0; i < triangles.size(); i++)
+    {
+        Vector3 triangle[3];
+        bvh->GetTriangle(triangles[i], triangle);
+        for (int j = 0; j < 3; j++)
+        {
+            triangle[j] = meshTrans.TransformPoint(triangle[j]);
+        }
+
+        Vector3 closestPoint = ClosestPointOnTriangle(sphereWorldPos, triangle);
+        Vector3 offset = sphereWorldPos - closestPoint;
+        float distanceSqrd = offset.MagnitudeSqrd();
+        if (distanceSqrd > contactRadius * contactRadius)
+        {
+            continue;
+        }
+
+        // A sphere centered on the triangle is pushed out along the triangle's normal
+        float distance = sqrtf(distanceSqrd);
+        Vector3 normal;
+        if (distance > 0.0001f)
+        {
+            normal = offset * (1.0f / distance);
+        }
+        else
+        {
+            normal = (triangle[1] - triangle[0]).Cross(triangle[2] - triangle[0]);
+            if (normal.MagnitudeSqrd() == 0.0f)
+            {
+                continue;
+            }
+            normal.Normalize();
+        }
+
+        CollisionContact* contact = data->ClaimNextContact();
+        if (contact == NULL)
+            break;
+
+        contact->ContactPoint = closestPoint;
+        contact->ContactNormal = normal;
+        contact->Penetration = sphereWorldRadius - distance;
+        contact->ColliderA = s;
+        contact->ColliderB = m;
+        contact->FeatureId = (triangles[i] << TRIANGLE_FEATURE_ID_SHIFT) + 1;
+        added++;
+    }
+
+    return added;
+}
+
+unsigned int CollisionDetection::BoxAndMesh(BoxCollider* b, MeshCollider* m, CollisionData* data, float speculativeDistance)
+{
+    TriangleBVH* bvh = m->GetTriangleBVH();
+    if (bvh == NULL || b->GetTransform().GetWorldScale().HasZeroComponent())
+    {
+        return 0;
+    }
+
+    // Find the triangles near the world space bounds of the box
+    Transform& boxTrans = b->GetTransform();
+    Vector3 boxCenter = boxTrans.GetWorldPosition();
+    Vector3 halfsize = b->GetWorldScaleHalfsize();
+    Vector3 extents;
+    for (int i = 0; i < 3; i++)
+    {
+        extents[i] = speculativeDistance;
+        for (int j = 0; j < 3; j++)
+        {
+            extents[i] += halfsize[j] * abs(boxTrans.GetAxis(j)[i]);
+        }
+    }
+
+    vector<int>& triangles = GetMeshTriangleScratch();
+    QueryMeshTriangles(m, BoundingBox(boxCenter - extents, boxCenter + extents), triangles);
+
+    Transform& meshTrans = m->GetTransform();
+    unsigned int added = 0;
+    for (unsigned int i = 0; i < triangles.size(); i++)
+    {
+        Vector3 triangle[3];
+        bvh->GetTriangle(triangles[i], triangle);
+        for (int j = 0; j < 3; j++)
+        {
+            triangle[j] = meshTrans.TransformPoint(triangle[j]);
+        }
+
+        added += BoxAndTriangle(b, m, triangle, triangles[i], data, speculativeDistance);
+    }
+
+    return added;
+}
+
+bool CollisionDetection::SphereOverlapsSphere(SphereCollider* a, SphereCollider* b)
+{
+    float radii = a->GetWorldspaceBoundingRadius() + b->GetWorldspaceBoundingRadius();
+    return (a->GetWorldPosition() - b->GetWorldPosition()).MagnitudeSqrd() <= radii * radii;
+}
+
+bool CollisionDetection::SphereOverlapsBox(SphereCollider* s, BoxCollider* b)
+{
+    Transform& boxTrans = b->GetTransform();
+    if (boxTrans.GetWorldScale().HasZeroComponent())
+    {
+        return false;
+    }
+
+    // Clamp the sphere's center onto the box, in box space, and measure the distance back in world space
+    Vector3 sphereWorldPos = s->GetWorldPosition();
+    Vector3 sphereBoxspacePos = boxTrans.InverseTransformPoint(sphereWorldPos);
+    Vector3 boxHalfsize = b->GetLocalSize();
+    Vector3 closestPoint;
+    for (int i = 0; i < 3; i++)
+    {
+        closestPoint[i] = fmaxf(-boxHalfsize[i], fminf(boxHalfsize[i], sphereBoxspacePos[i]));
+    }
+
+    float radius = s->GetWorldspaceBoundingRadius();
+    return (boxTrans.TransformPoint(closestPoint) - sphereWorldPos).MagnitudeSqrd() <= radius * radius;
+}
+
+bool CollisionDetection::BoxOverlapsBox(BoxCollider* a, BoxCollider* b)
+{
+    // The same separating axes as BoxAndBox, but any overlap will do, so there's no need to find the best one
+    Transform& aTrans = a->GetTransform();
+    Transform& bTrans = b->GetTransform();
+    Vector3 centerAToCenterB = bTrans.GetWorldPosition() - aTrans.GetWorldPosition();
+    for (int i = 0; i < 15; i++)
+    {
+        Vector3 axis;
+        if (i < 3)
+            axis = aTrans.GetAxis(i);
+        else if (i < 6)
+            axis = bTrans.GetAxis(i - 3);
+        else
+            axis = aTrans.GetAxis((i - 6) / 3).Cross(bTrans.GetAxis((i - 6) % 3));
+
+        if (axis.MagnitudeSqrd() < 0.001f)
+        {
+            continue;
+        }
+
+        axis.Normalize();
+        if (PenetrationOnAxis(a, b, axis, centerAToCenterB) < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CollisionDetection::SphereOverlapsMesh(SphereCollider* s, MeshCollider* m)
+{
+    TriangleBVH* bvh = m->GetTriangleBVH();
+    if (bvh == NULL)
+    {
+        return false;
+    }
+
+    Vector3 sphereWorldPos = s->GetWorldPosition();
+    float radius = s->GetWorldspaceBoundingRadius();
+    Vector3 extents(radius, radius, radius);
+    vector<int>& triangles = GetMeshTriangleScratch();
+    QueryMeshTriangles(m, BoundingBox(sphereWorldPos - extents, sphereWorldPos + extents), triangles);
+
+    Transform& meshTrans = m->GetTransform();
+    for (unsigned int i = 0; i < triangles.size(); i++)
+    {
+        Vector3 triangle[3];
+        bvh->GetTriangle(triangles[i], triangle);
+        for (int j = 0; j < 3; j++)
+        {
+            triangle[j] = meshTrans.TransformPoint(triangle[j]);
+        }
+
+        if ((ClosestPointOnTriangle(sphereWorldPos, triangle) - sphereWorldPos).MagnitudeSqrd() <= radius * radius)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CollisionDetection::BoxOverlapsMesh(BoxCollider* b, MeshCollider* m)
+{
+    TriangleBVH* bvh = m->GetTriangleBVH();
+    if (bvh == NULL || b->GetTransform().GetWorldScale().HasZeroComponent())
+    {
+        return false;
+    }
+
+    Transform& boxTrans = b->GetTransform();
+    Vector3 boxCenter = boxTrans.GetWorldPosition();
+    Vector3 halfsize = b->GetWorldScaleHalfsize();
+    Vector3 extents;
+    for (int i = 0; i < 3; i++)
+    {
+        extents[i] = 0.0f;
+        for (int j = 0; j < 3; j++)
+        {
+            extents[i] += halfsize[j] * abs(boxTrans.GetAxis(j)[i]);
+        }
+    }
+
+    vector<int>& triangles = GetMeshTriangleScratch();
+    QueryMeshTriangles(m, BoundingBox(boxCenter - extents, boxCenter + extents), triangles);
+
+    Transform& meshTrans = m->GetTransform();
+    for (unsigned int i = 0; i < triangles.size(); i++)
+    {
+        Vector3 triangle[3];
+        bvh->GetTriangle(triangles[i], triangle);
+        for (int j = 0; j < 3; j++)
+        {
+            triangle[j] = meshTrans.TransformPoint(triangle[j]);
+        }
+
+        if (BoxOverlapsTriangle(b, triangle))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CollisionDetection::BoxOverlapsTriangle(BoxCollider* box, Vector3* triangle)
+{
+    Transform& boxTrans = box->GetTransform();
+    Vector3 boxCenter = boxTrans.GetWorldPosition();
+    Vector3 halfsize = box->GetWorldScaleHalfsize();
+
+    Vector3 edges[3];
+    for (int i = 0; i < 3; i++)
+    {
+        edges[i] = triangle[(i + 1) % 3] - triangle[i];
+    }
+
+    // The triangle's normal, the box's face axes, and each box axis crossed with each triangle edge
+    for (int i = 0; i < 13; i++)
+    {
+        Vector3 axis;
+        if (i == 0)
+            axis = edges[0].Cross(edges[1]);
+        else if (i < 4)
+            axis = boxTrans.GetAxis(i - 1);
+        else
+            axis = boxTrans.GetAxis((i - 4) / 3).Cross(edges[(i - 4) % 3]);
+
+        // The scale of the axis doesn't change the outcome, as long as the box and the triangle use the same one
+        float boxProjection = halfsize.x() * abs(axis.Dot(boxTrans.GetRight())) +
+                              halfsize.y() * abs(axis.Dot(boxTrans.GetUp())) +
+                              halfsize.z() * abs(axis.Dot(boxTrans.GetForward()));
+        float triangleMin = FLT_MAX;
+        float triangleMax = -FLT_MAX;
+        for (int j = 0; j < 3; j++)
+        {
+            float projection = axis.Dot(triangle[j] - boxCenter);
+            triangleMin = fminf(triangleMin, projection);
+            triangleMax = fmaxf(triangleMax, projection);
+        }
+
+        if (triangleMin > boxProjection || triangleMax < -boxProjection)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CollisionDetection::QueryMeshTriangles(MeshCollider* mesh, const BoundingBox& worldBox, vector<int>& triangles)
+{
+    // Bound the corners of the box in the mesh's model space, which is where the BVH was built
+    Transform& meshTrans = mesh->GetTransform();
+    BoundingBox localBox;
+    for (int i = 0; i < 8; i++)
+    {
+        Vector3 corner((i & 1) ? worldBox.Max.x() : worldBox.Min.x(),
+                       (i & 2) ? worldBox.Max.y() : worldBox.Min.y(),
+                       (i & 4) ? worldBox.Max.z() : worldBox.Min.z());
+        Vector3 localCorner = meshTrans.InverseTransformPoint(corner);
+
+        localBox = (i == 0) ? BoundingBox(localCorner, localCorner) : BoundingBox(localBox, BoundingBox(localCorner, localCorner));
+    }
+
+    mesh->GetTriangleBVH()->Query(localBox, triangles);
+}
+
+Vector3 CollisionDetection::ClosestPointOnTriangle(const Vector3& point, Vector3* triangle)
+{
+    // Work out which feature of the triangle (vertex, edge or face) is closest, from the
+    // barycentric coordinates of the point (see Ericson, Real-Time Collision Detection 5.1.5)
+    Vector3 ab = triangle[1] - triangle[0];
+    Vector3 ac = triangle[2] - triangle[0];
+    Vector3 ap = point - triangle[0];
+    float d1 = ab.Dot(ap);
+    float d2 = ac.Dot(ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return triangle[0];
+
+    Vector3 bp = point - triangle[1];
+    float d3 = ab.Dot(bp);
+    float d4 = ac.Dot(bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return triangle[1];
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return triangle[0] + ab * (d1 / (d1 - d3));
+
+    Vector3 cp = point - triangle[2];
+    float d5 = ab.Dot(cp);
+    float d6 = ac.Dot(cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return triangle[2];
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return triangle[0] + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return triangle[1] + (triangle[2] - triangle[1]) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    // Inside the face
+    float denom = 1.0f / (va + vb + vc);
+    return triangle[0] + ab * (vb * denom) + ac * (vc * denom);
+}
+
+unsigned int CollisionDetection::BoxAndTriangle(BoxCollider* box, MeshCollider* mesh, Vector3* triangle, unsigned int triangleIndex, CollisionData* data, float speculativeDistance)
+{
+    Transform& boxTrans = box->GetTransform();
+    Vector3 boxCenter = boxTrans.GetWorldPosition();
+    Vector3 halfsize = box->GetWorldScaleHalfsize();
+
+    Vector3 edges[3];
+    for (int i = 0; i < 3; i++)
+    {
+        edges[i] = triangle[(i + 1) % 3] - triangle[i];
+    }
+
+    Vector3 triangleNormal = edges[0].Cross(edges[1]);
+    if (triangleNormal.MagnitudeSqrd() < 0.000001f)
+    {
+        // Degenerate triangle
+        return 0;
+    }
+    triangleNormal.Normalize();
+
+    // Separating axis tests: the triangle's normal, the box's face axes, and each box axis crossed with each triangle edge
+    const int NUM_CASES = 13;
+    Vector3 axes[NUM_CASES];
+    axes[0] = triangleNormal;
+    for (int i = 0; i < 3; i++)
+    {
+        axes[1 + i] = boxTrans.GetAxis(i);
+        for (int j = 0; j < 3; j++)
+        {
+            axes[4 + i * 3 + j] = boxTrans.GetAxis(i).Cross(edges[j].Normalized());
+        }
+    }
+
+    float bestOverlap = FLT_MAX;
+    float bestScore = FLT_MAX;
+    unsigned int bestCase = 0;
+    Vector3 bestNormal;
+    for (int i = 0; i < NUM_CASES; i++)
+    {
+        Vector3 axis = axes[i];
+
+        // Check for axes that were generated by (almost) parallel edges
+        if (axis.MagnitudeSqrd() < 0.001f)
+        {
+            continue;
+        }
+        axis.Normalize();
+
+        // Project the box and the triangle onto the axis, relative to the center of the box
+        float boxProjection = halfsize.x() * abs(axis.Dot(boxTrans.GetRight())) +
+                              halfsize.y() * abs(axis.Dot(boxTrans.GetUp())) +
+                              halfsize.z() * abs(axis.Dot(boxTrans.GetForward()));
+        float triangleMin = FLT_MAX;
+        float triangleMax = -FLT_MAX;
+        for (int j = 0; j < 3; j++)
+        {
+            float projection = axis.Dot(triangle[j] - boxCenter);
+            triangleMin = fminf(triangleMin, projection);
+            triangleMax = fmaxf(triangleMax, projection);
+        }
+
+        // The box can be pushed out either way along the axis, so take whichever is shorter
+        float overlapForward = triangleMax + boxProjection;
+        float overlapBackward = boxProjection - triangleMin;
+        float overlap = fminf(overlapForward, overlapBackward);
+        if (overlap < -speculativeDistance)
+        {
+            return 0;
+        }
+
+        // Prefer face axes, as with box-box contacts
+        float score = overlap;
+        if (i >= 4)
+        {
+            score = overlap + abs(overlap) * EDGE_AXIS_RELATIVE_TOLERANCE + EDGE_AXIS_ABSOLUTE_TOLERANCE;
+        }
+        if (score < bestScore)
+        {
+            bestScore = score;
+            bestOverlap = overlap;
+            bestCase = i;
+            bestNormal = overlapForward < overlapBackward ? axis : -1.0f * axis;
+        }
+    }
+
+    // The box is pushed out along the contact normal
+    unsigned int triangleFeature = triangleIndex << TRIANGLE_FEATURE_ID_SHIFT;
+    ClipVertex polygon[MAX_CLIP_VERTICES];
+    ClipVertex clipped[MAX_CLIP_VERTICES];
+    int vertexCount = 0;
+    Vector3 faceNormal;
+    float faceOffset;
+    unsigned int featureBase;
+
+    if (bestCase == 0)
+    {
+        // Face of the triangle against face, edge or vertex of the box. Clip the box face that is
+        // most anti-parallel to the triangle against the triangle's edges.
+        faceNormal = bestNormal;
+        faceOffset = faceNormal.Dot(triangle[0]);
+        featureBase = 1;
+
+        unsigned int incidentAxis = 0;
+        float bestDot = 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            float dot = boxTrans.GetAxis(i).Dot(faceNormal);
+            if (abs(dot) > abs(bestDot))
+            {
+                bestDot = dot;
+                incidentAxis = i;
+            }
+        }
+
+        Vector3 localSize = box->GetLocalSize();
+        unsigned int u = (incidentAxis + 1) % 3;
+        unsigned int v = (incidentAxis + 2) % 3;
+        const float windingU[4] = { 1.0f, -1.0f, -1.0f, 1.0f };
+        const float windingV[4] = { 1.0f, 1.0f, -1.0f, -1.0f };
+        for (int i = 0; i < 4; i++)
+        {
+            Vector3 corner;
+            corner[incidentAxis] = bestDot > 0 ? -localSize[incidentAxis] : localSize[incidentAxis];
+            corner[u] = windingU[i] * localSize[u];
+            corner[v] = windingV[i] * localSize[v];
+
+            polygon[i].Point = boxTrans.TransformPoint(corner);
+            polygon[i].FeatureId = GetSignBits(corner);
+            polygon[i].EdgeFeature = i;
+        }
+        vertexCount = 4;
+
+        for (int i = 0; i < 3 && vertexCount > 0; i++)
+        {
+            // Side planes face out of the triangle
+            Vector3 sideNormal = edges[i].Cross(triangleNormal);
+            if (sideNormal.Dot(triangle[(i + 2) % 3] - triangle[i]) > 0.0f)
+            {
+                sideNormal = -1.0f * sideNormal;
+            }
+            sideNormal.Normalize();
+
+            vertexCount = ClipPolygon(polygon, vertexCount, sideNormal, sideNormal.Dot(triangle[i]), i, clipped);
+            for (int j = 0; j < vertexCount; j++)
+            {
+                polygon[j] = clipped[j];
+            }
+        }
+    }
+    else if (bestCase < 4)
+    {
+        // Face of the box against face, edge or vertex of the triangle. Clip the triangle against the
+        // side planes of the box face.
+        unsigned int faceAxis = bestCase - 1;
+        bool negativeFace = boxTrans.GetAxis(faceAxis).Dot(bestNormal) > 0.0f;
+        faceNormal = -1.0f * bestNormal;
+        Vector3 faceCenter = boxCenter + faceNormal * halfsize[faceAxis];
+        faceOffset = faceNormal.Dot(faceCenter);
+        featureBase = BOX_FACE_FEATURE_ID_BASE + ((faceAxis * 2 + (negativeFace ? 1 : 0)) << 6);
+
+        for (int i = 0; i < 3; i++)
+        {
+            polygon[i].Point = triangle[i];
+            polygon[i].FeatureId = i;
+            polygon[i].EdgeFeature = i;
+        }
+        vertexCount = 3;
+
+        for (int i = 0; i < 2; i++)
+        {
+            int sideAxis = (faceAxis + 1 + i) % 3;
+            Vector3 sideNormal = boxTrans.GetAxis(sideAxis);
+            float centerOffset = sideNormal.Dot(faceCenter);
+            Vector3 oppositeNormal = -1.0f * sideNormal;
+
+            for (int side = 0; side < 2 && vertexCount > 0; side++)
+            {
+                Vector3& planeNormal = side == 0 ? sideNormal : oppositeNormal;
+                float planeOffset = (side == 0 ? centerOffset : -centerOffset) + halfsize[sideAxis];
+                vertexCount = ClipPolygon(polygon, vertexCount, planeNormal, planeOffset, i * 2 + side, clipped);
+                for (int j = 0; j < vertexCount; j++)
+                {
+                    polygon[j] = clipped[j];
+                }
+            }
+        }
+    }
+    else
+    {
+        // Edge of the box against edge of the triangle
+        unsigned int boxAxisIndex = (bestCase - 4) / 3;
+        unsigned int edgeIndex = (bestCase - 4) % 3;
+
+        // Find the box edge furthest along the triangle's side of the box
+        Vector3 pointOnBoxEdge = box->GetLocalSize();
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            if (i == boxAxisIndex)
+            {
+                pointOnBoxEdge[i] = 0;
+            }
+            else if (boxTrans.GetAxis(i).Dot(bestNormal) > 0)
+            {
+                pointOnBoxEdge[i] = -pointOnBoxEdge[i];
+            }
+        }
+        unsigned int featureId = TRIANGLE_EDGE_FEATURE_ID_BASE + (((boxAxisIndex * 3 + edgeIndex) << 3) | GetSignBits(pointOnBoxEdge));
+        pointOnBoxEdge = boxTrans.TransformPoint(pointOnBoxEdge);
+
+        Vector3 boxAxis = boxTrans.GetAxis(boxAxisIndex);
+        CollisionContact* contact = data->ClaimNextContact();
+        if (contact == NULL)
+            return 0;
+
+        contact->ContactPoint = GetContactPoint(boxAxis, edges[edgeIndex], pointOnBoxEdge, triangle[edgeIndex]);
+        contact->ContactNormal = bestNormal;
+        contact->Penetration = bestOverlap;
+        contact->ColliderA = box;
+        contact->ColliderB = mesh;
+        contact->FeatureId = triangleFeature + featureId;
+        return 1;
+    }
+
+    // Only the clipped points behind the reference face (or within the speculative distance of it) are in contact
+    float depths[MAX_CLIP_VERTICES];
+    int contactCount = 0;
+    for (int i = 0; i < vertexCount; i++)
+    {
+        float depth = faceOffset - faceNormal.Dot(polygon[i].Point);
+        if (depth >= -speculativeDistance)
+        {
+            polygon[contactCount] = polygon[i];
+            depths[contactCount] = depth;
+            contactCount++;
+        }
+    }
+
+    int selected[MAX_BOX_CONTACTS];
+    contactCount = ReduceContactPoints(polygon, depths, contactCount, selected);
+
+    unsigned int added = 0;
+    for (int i = 0; i < contactCount; i++)
+    {
+        CollisionContact* contact = data->ClaimNextContact();
+        if (contact == NULL)
+            break;
+
+        contact->ContactPoint = polygon[selected[i]].Point;
+        contact->ContactNormal = bestNormal;
+        contact->Penetration = depths[selected[i]];
+        contact->ColliderA = box;
+        contact->ColliderB = mesh;
+        contact->FeatureId = triangleFeature + featureBase + polygon[selected[i]].FeatureId;
+        added++;
+    }
+
+    return added;
 }
\ No newline at end of file
@@ -2,73 +2,307 @@
 
 #include "GameObject.h"
 #include "GameObjectBase.h"
+#include "GameProject.h"
 #include "Debugging/DebugDraw.h"
 #include "Math/Transformations.h"
 #include "Physics/Collider.h"
+#include "Physics/DynamicAABBTree.h"
+#include "Physics/PhysicsProfiler.h"
+#include "Physics/RigidBody.h"
+#include "Physics/SpatialHashGrid.h"
+#include "Physics/SweepAndPrune.h"
 #include "Util.h"
 
 #include <algorithm>
-#include <iterator>
 
-bool CollisionPairComparator(CollisionPair& lhs, CollisionPair& rhs)
+// Runs a contiguous range of potential contacts through the narrow phase, one contact buffer per thread
+class NarrowPhaseJob : public WorkerJob
 {
-    unsigned int l_0 = lhs.gameObjects[0] ? lhs.gameObjects[0]->GetID() : 0;
-    unsigned int l_1 = lhs.gameObjects[1] ? lhs.gameObjects[1]->GetID() : 0;
-    unsigned int r_0 = rhs.gameObjects[0] ? rhs.gameObjects[0]->GetID() : 0;
-    unsigned int r_1 = rhs.gameObjects[1] ? rhs.gameObjects[1]->GetID() : 0;
+public:
+    NarrowPhaseJob(vector<PotentialContact>& potentialContacts, vector<CollisionData>& threadCollisionData)
+        : m_potentialContacts(potentialContacts), m_threadCollisionData(threadCollisionData)
+    {}
+
+    void Run(unsigned int threadIndex, unsigned int begin, unsigned int end);
+
+private:
+    vector<PotentialContact>&   m_potentialContacts;
+    vector<CollisionData>&      m_threadCollisionData;
+};
+
+// Children found by the compound tests, kept per thread since the narrow phase runs on the worker pool. A compound
+// pair tests one compound's children against the other compound, so each test pushes its children on the end and
+// pops them off again when it's done, rather than clearing the buffer.
+vector<int>& GetCompoundChildScratch()
+{
+    static thread_local vector<int> children;
+    return children;
+}
+
+int CollideCompound(CompoundCollider* compound, Collider* other, bool compoundFirst, float speculativeDistance, CollisionData* collisionData);
+
+int CollidePotentialContact(PotentialContact& potentialContact, CollisionData* collisionData)
+{
+    Collider* colliderA = potentialContact.colliders[0];
+    Collider* colliderB = potentialContact.colliders[1];
 
-    if (l_1 > l_0)
+    if (colliderA->GetType() == Collider::COMPOUND_COLLIDER)
+        return CollideCompound((CompoundCollider*)colliderA, colliderB, true, potentialContact.speculativeDistance, collisionData);
+    if (colliderB->GetType() == Collider::COMPOUND_COLLIDER)
+        return CollideCompound((CompoundCollider*)colliderB, colliderA, false, potentialContact.speculativeDistance, collisionData);
+
+    switch (colliderA->GetType())
+    {
+    case Collider::SPHERE_COLLIDER:
     {
-        Swap(l_0, l_1);
+        switch (colliderB->GetType())
+        {
+        case Collider::SPHERE_COLLIDER:
+            return CollisionDetection::SphereAndSphere((SphereCollider*)colliderA, (SphereCollider*)colliderB, collisionData, potentialContact.speculativeDistance);
+        case Collider::BOX_COLLIDER:
+            return CollisionDetection::SphereAndBox((SphereCollider*)colliderA, (BoxCollider*)colliderB, collisionData, potentialContact.speculativeDistance);
+        case Collider::MESH_COLLIDER:
+            return CollisionDetection::SphereAndMesh((SphereCollider*)colliderA, (MeshCollider*)colliderB, collisionData, potentialContact.speculativeDistance);
+        default:
+            break;
+        }
+        break;
+    }
+    case Collider::BOX_COLLIDER:
+    {
+        switch (colliderB->GetType())
+        {
+        case Collider::SPHERE_COLLIDER:
+            return CollisionDetection::SphereAndBox((SphereCollider*)colliderB, (BoxCollider*)colliderA, collisionData, potentialContact.speculativeDistance);
+        case Collider::BOX_COLLIDER:
+            return CollisionDetection::BoxAndBox((BoxCollider*)colliderA, (BoxCollider*)colliderB, collisionData, potentialContact.speculativeDistance);
+        case Collider::MESH_COLLIDER:
+            return CollisionDetection::BoxAndMesh((BoxCollider*)colliderA, (MeshCollider*)colliderB, collisionData, potentialContact.speculativeDistance);
+        default:
+            break;
+        }
+        break;
     }
-    if (r_1 > r_0)
+    case Collider::CAPSULE_COLLIDER:
     {
-        Swap(r_0, r_1);
+        break;
     }
+    case Collider::MESH_COLLIDER:
+    {
+        switch (colliderB->GetType())
+        {
+        case Collider::SPHERE_COLLIDER:
+            return CollisionDetection::SphereAndMesh((SphereCollider*)colliderB, (MeshCollider*)colliderA, collisionData, potentialContact.speculativeDistance);
+        case Collider::BOX_COLLIDER:
+            return CollisionDetection::BoxAndMesh((BoxCollider*)colliderB, (MeshCollider*)colliderA, collisionData, potentialContact.speculativeDistance);
+        default:
+            break;
+        }
+        break;
+    }
+    case Collider::COMPOUND_COLLIDER:       // Compounds were sent to CollideCompound above, which tests their children
+    default:
+        break;
+    }
+    return 0;
+}
 
-    if (l_0 == r_0)
+// Tests the children of the compound near the other collider. Their contacts keep the child as the collider, so that
+// each child gets its own manifold, and are resolved against the compound's rigid body (see Collider::GetBodyObject).
+int CollideCompound(CompoundCollider* compound, Collider* other, bool compoundFirst, float speculativeDistance, CollisionData* collisionData)
+{
+    BoundingBox box(other);
+    box.Expand(speculativeDistance);
+    vector<int>& children = GetCompoundChildScratch();
+    unsigned int first = children.size();
+    children.reserve(first + COMPOUND_QUERY_CAPACITY);
+    compound->QueryChildren(box, children);
+    unsigned int end = children.size();
+
+    // Index the buffer every time, as testing against another compound may grow it. Trigger children
+    // are left to the overlap tests (see CollisionEngine::AddTriggerChildPairs).
+    int added = 0;
+    for (unsigned int i = first; i < end; i++)
     {
-        return l_1 < r_1;
+        Collider* child = compound->GetChild(children[i]);
+        if (child->IsTrigger())
+            continue;
+
+        PotentialContact childContact = compoundFirst ? PotentialContact(child, other) : PotentialContact(other, child);
+        childContact.speculativeDistance = speculativeDistance;
+        added += CollidePotentialContact(childContact, collisionData);
+    }
+    children.resize(first);
+    return added;
+}
+
+bool OverlapCompound(CompoundCollider* compound, Collider* other);
+
+// Boolean narrow phase for pairs with a trigger, which only need to know whether the colliders touch
+bool OverlapPotentialContact(PotentialContact& potentialContact)
+{
+    Collider* colliderA = potentialContact.colliders[0];
+    Collider* colliderB = potentialContact.colliders[1];
+    Collider::ColliderType typeA = colliderA->GetType();
+    Collider::ColliderType typeB = colliderB->GetType();
+
+    if (typeA == Collider::COMPOUND_COLLIDER)
+        return OverlapCompound((CompoundCollider*)colliderA, colliderB);
+    if (typeB == Collider::COMPOUND_COLLIDER)
+        return OverlapCompound((CompoundCollider*)colliderB, colliderA);
+
+    // Test each type pair once, with the lower type first
+    if (typeA > typeB)
+    {
+        std::swap(colliderA, colliderB);
+        std::swap(typeA, typeB);
+    }
+
+    switch (typeA)
+    {
+    case Collider::SPHERE_COLLIDER:
+    {
+        switch (typeB)
+        {
+        case Collider::SPHERE_COLLIDER: return CollisionDetection::SphereOverlapsSphere((SphereCollider*)colliderA, (SphereCollider*)colliderB);
+        case Collider::BOX_COLLIDER:    return CollisionDetection::SphereOverlapsBox((SphereCollider*)colliderA, (BoxCollider*)colliderB);
+        case Collider::MESH_COLLIDER:   return CollisionDetection::SphereOverlapsMesh((SphereCollider*)colliderA, (MeshCollider*)colliderB);
+        default:                        break;
+        }
+        break;
+    }
+    case Collider::BOX_COLLIDER:
+    {
+        switch (typeB)
+        {
+        case Collider::BOX_COLLIDER:    return CollisionDetection::BoxOverlapsBox((BoxCollider*)colliderA, (BoxCollider*)colliderB);
+        case Collider::MESH_COLLIDER:   return CollisionDetection::BoxOverlapsMesh((BoxCollider*)colliderA, (MeshCollider*)colliderB);
+        default:                        break;
+        }
+        break;
+    }
+    case Collider::COMPOUND_COLLIDER:       // Compounds were sent to OverlapCompound above, which tests their children
+    default:
+        break;
+    }
+    return false;
+}
+
+bool OverlapCompound(CompoundCollider* compound, Collider* other)
+{
+    vector<int>& children = GetCompoundChildScratch();
+    unsigned int first = children.size();
+    children.reserve(first + COMPOUND_QUERY_CAPACITY);
+    compound->QueryChildren(BoundingBox(other), children);
+    unsigned int end = children.size();
+
+    // Triggers don't sense each other
+    bool overlaps = false;
+    for (unsigned int i = first; i < end && !overlaps; i++)
+    {
+        Collider* child = compound->GetChild(children[i]);
+        if (child->IsTrigger() && other->IsTrigger())
+            continue;
+
+        PotentialContact childContact(child, other);
+        overlaps = OverlapPotentialContact(childContact);
+    }
+    children.resize(first);
+    return overlaps;
+}
+
+// Compounds cache their bounds and hierarchy, so bring them up to date before anything reads them
+void RefreshIfCompound(Collider* collider)
+{
+    if (collider->GetType() == Collider::COMPOUND_COLLIDER)
+    {
+        ((CompoundCollider*)collider)->Refresh();
+    }
+}
+
+void NarrowPhaseJob::Run(unsigned int threadIndex, unsigned int begin, unsigned int end)
+{
+    CollisionData* collisionData = &m_threadCollisionData[threadIndex];
+    for (unsigned int i = begin; i < end; i++)
+    {
+        CollidePotentialContact(m_potentialContacts[i], collisionData);
     }
-    return l_0 < r_0;
 }
 
 PotentialContact::PotentialContact()
+    : speculativeDistance(0.0f)
 {
     colliders[0] = NULL;
     colliders[1] = NULL;
 }
 
-CollisionPair::CollisionPair()
-{}
-
-CollisionPair::CollisionPair(GameObject* a, GameObject* b)
+PotentialContact::PotentialContact(Collider* a, Collider* b)
+    : speculativeDistance(0.0f)
 {
-    gameObjects[0] = a;
-    gameObjects[1] = b;
+    colliders[0] = a;
+    colliders[1] = b;
 }
 
 CollisionEngine::CollisionEngine()
-    : m_debugLog(false), m_debugDraw(true), m_collisionData(MAX_POTENTIAL_CONTACTS)
-{}
+    : m_staticHierarchyBuilt(false), m_staticRebuildFraction(STATIC_REBUILD_FRACTION), m_broadPhase(NULL),
+      m_collisionData(MAX_COLLISION_CONTACTS), m_step(0), m_speculativeContacts(false), m_debugLog(false), m_debugDraw(true)
+{
+    m_potentialContacts.reserve(INITIAL_CONTACT_CAPACITY);
+}
 
 void CollisionEngine::Startup()
 {
-    m_staticCollisionHierarchy = NULL;
+    m_staticHierarchy.Clear();
+    m_staticHierarchyBuilt = false;
+
+    // Create the broad phase selected in the project settings
+    GameProject::PhysicsSettings& settings = GameProject::Singleton().GetPhysicsSettings();
+    switch (settings.BroadPhase)
+    {
+    case GameProject::BROAD_PHASE_SWEEP_AND_PRUNE:  m_broadPhase = new SweepAndPrune();                         break;
+    case GameProject::BROAD_PHASE_HASH_GRID:        m_broadPhase = new SpatialHashGrid(settings.GridCellSize);  break;
+    case GameProject::BROAD_PHASE_BVH:
+    default:                                        m_broadPhase = new DynamicAABBTree();                       break;
+    }
+
+    m_speculativeContacts = settings.SpeculativeContacts;
+    m_collisionFilter.SetLayerMasks(settings.LayerCollisionMasks);
+
+    m_narrowPhaseWorkers.Startup(settings.NarrowPhaseThreads);
+    m_threadCollisionData.assign(m_narrowPhaseWorkers.GetThreadCount(), CollisionData(MAX_COLLISION_CONTACTS));
 }
 
 void CollisionEngine::Shutdown()
 {
-    // TODO clean up the collision hierarchy
+    m_staticHierarchy.Clear();
+    m_staticHierarchyBuilt = false;
+
+    if (m_broadPhase != NULL)
+    {
+        delete m_broadPhase;
+        m_broadPhase = NULL;
+    }
+
+    m_narrowPhaseWorkers.Shutdown();
+    m_threadCollisionData.clear();
+    m_contactManifolds.Clear();
+    m_collisionPairs.Clear();
+    m_triggerPairs.Clear();
+    m_triggerContacts.clear();
+    m_collisionEvents.clear();
 }
 
 void CollisionEngine::CalculateCollisions(float deltaTime)
 {
+    PhysicsProfiler& profiler = PhysicsProfiler::Singleton();
     m_collisionData.Reset();
 
     // Broad phase: generate potential contacts
-    PotentialContact potentialContacts[MAX_POTENTIAL_CONTACTS];
-    int numPotentialContacts = BroadPhaseCollision(potentialContacts);
+    PhysicsClock::time_point phaseStart = PhysicsClock::now();
+    vector<PotentialContact>& potentialContacts = m_potentialContacts;
+    int numPotentialContacts = BroadPhaseCollision(potentialContacts, deltaTime);
+    profiler.AddPhaseTime(PHYSICS_PHASE_BROAD_PHASE, phaseStart);
+    profiler.GetCurrentStep().BroadPhasePairs += numPotentialContacts + m_triggerContacts.size();
 
     if (m_debugLog)
     {
@@ -85,67 +319,90 @@ void CollisionEngine::CalculateCollisions(float deltaTime)
     }
 
     // Narrow phase: calculate actual contacts
-    int numContacts = NarrowPhaseCollision(potentialContacts, numPotentialContacts, &m_collisionData);
-
-    vector<CollisionPair> collisionPairs;
-    if (numContacts > 0)
+    phaseStart = PhysicsClock::now();
+    CountNarrowPhaseTests(potentialContacts);
+    CountNarrowPhaseTests(m_triggerContacts);
+    NarrowPhaseCollision(potentialContacts, &m_collisionData);
+    m_contactStats.Record(m_collisionData.ContactsUsed, m_collisionData.ContactsDropped);
+    TriggerOverlapTests();
+    profiler.AddPhaseTime(PHYSICS_PHASE_NARROW_PHASE, phaseStart);
+    profiler.GetCurrentStep().Contacts += m_collisionData.ContactsUsed;
+    profiler.GetCurrentStep().TriggerOverlaps += m_triggerContacts.size();
+
+    // Merge the new contacts into the persistent manifolds, which then replace them
+    phaseStart = PhysicsClock::now();
+    m_contactManifolds.Update(&m_collisionData);
+
+    if (m_debugLog && m_collisionData.ContactsUsed > 0)
     {
-        if (m_debugLog)
-        {
-            printf("\nActual Contacts\n");
-        }
-        for (int i = 0; i < numContacts; i++)
+        printf("\nActual Contacts\n");
+        for (int i = 0; i < m_collisionData.ContactsUsed; i++)
         {
-            // TODO pass collision info
-            GameObject* objectA = ((GameObject*)(m_collisionData.Contacts[i].ColliderA->GetGameObject()));
-            GameObject* objectB = ((GameObject*)(m_collisionData.Contacts[i].ColliderB->GetGameObject()));
-
-            // TODO check for duplicates
-            collisionPairs.push_back(CollisionPair(objectA, objectB));
-
-            if (m_debugLog)
-            {
-                printf("\t%s\n", m_collisionData.Contacts[i].ColliderA->GetGameObject()->GetName().c_str());
-                printf("\t%s\n", m_collisionData.Contacts[i].ColliderB->GetGameObject()->GetName().c_str());
-                printf("\t---\n");
-            }
+            printf("\t%s\n", m_collisionData.Contacts[i].ColliderA->GetBodyObject()->GetName().c_str());
+            printf("\t%s\n", m_collisionData.Contacts[i].ColliderB->GetBodyObject()->GetName().c_str());
+            printf("\t---\n");
         }
     }
 
-    // Determine which collision pairs are newly started, newly ended, or still holding from last frame
-    vector<CollisionPair> enterList, exitList, holdList;
-    std::sort(collisionPairs.begin(), collisionPairs.end(), CollisionPairComparator);
-    std::set_intersection(collisionPairs.begin(), collisionPairs.end(), m_prevCollisionPairs.begin(), m_prevCollisionPairs.end(), back_inserter(holdList), CollisionPairComparator);
-    std::set_difference(collisionPairs.begin(), collisionPairs.end(), m_prevCollisionPairs.begin(), m_prevCollisionPairs.end(), back_inserter(enterList), CollisionPairComparator);
-    std::set_difference(m_prevCollisionPairs.begin(), m_prevCollisionPairs.end(), collisionPairs.begin(), collisionPairs.end(), back_inserter(exitList), CollisionPairComparator);
+    UpdateCollisionPairs();
+    UpdateTriggerPairs();
+    profiler.AddPhaseTime(PHYSICS_PHASE_MANIFOLDS, phaseStart);
+}
 
-    // Notify game objects of enter/exit/hold events
-    for (vector<CollisionPair>::iterator iter = enterList.begin(); iter != enterList.end(); iter++)
-    {
-        iter->gameObjects[0]->OnCollisionEnter();
-        iter->gameObjects[1]->OnCollisionEnter();
-    }
-    for (vector<CollisionPair>::iterator iter = exitList.begin(); iter != exitList.end(); iter++)
+void CollisionEngine::DispatchCollisionEvents()
+{
+    PhysicsClock::time_point phaseStart = PhysicsClock::now();
+
+    // The solver has run by now, so total up the impulses it left on each pair's manifold points
+    for (int i = 0; i < m_collisionData.ContactsUsed; i++)
     {
-        iter->gameObjects[0]->OnCollisionExit();
-        iter->gameObjects[1]->OnCollisionExit();
+        int eventIndex = m_contactEventIndices[i];
+        ManifoldPoint* point = m_collisionData.Contacts[i].CachedPoint;
+        if (eventIndex != -1 && point != NULL)
+        {
+            m_collisionEvents[eventIndex].Impulse += point->NormalImpulse;
+        }
     }
-    for (vector<CollisionPair>::iterator iter = holdList.begin(); iter != holdList.end(); iter++)
+
+    for (unsigned int i = 0; i < m_collisionEvents.size(); i++)
     {
-        iter->gameObjects[0]->OnCollisionHold();
-        iter->gameObjects[1]->OnCollisionHold();
+        CollisionEvent& collisionEvent = m_collisionEvents[i];
+        for (int side = 0; side < 2; side++)
+        {
+            GameObject* gameObject = collisionEvent.Objects[side];
+            if (gameObject == NULL || !gameObject->ListensForCollisions(collisionEvent.Type))
+            {
+                continue;
+            }
+
+            // Contact data is stored from the first object's perspective
+            Collision collision;
+            collision.Other = collisionEvent.Objects[1 - side];
+            collision.ContactPoint = collisionEvent.ContactPoint;
+            collision.ContactNormal = side == 0 ? collisionEvent.ContactNormal : -1.0f * collisionEvent.ContactNormal;
+            collision.Impulse = collisionEvent.Impulse;
+            collision.Penetration = collisionEvent.Penetration;
+            gameObject->OnCollision(collisionEvent.Type, collision);
+        }
     }
 
-    m_prevCollisionPairs.clear();
-    m_prevCollisionPairs = collisionPairs;
+    PhysicsProfiler::Singleton().AddPhaseTime(PHYSICS_PHASE_EVENTS, phaseStart);
+}
 
+const vector<CollisionEvent>& CollisionEngine::GetCollisionEvents()
+{
+    return m_collisionEvents;
 }
 
 void CollisionEngine::DrawDebugInfo()
 {
     if (m_debugDraw)
     {
-        DrawBoundingSpheres(m_staticCollisionHierarchy, ColorRGB::White);
+        m_staticHierarchy.DrawDebugInfo(ColorRGB::White);
+        if (m_broadPhase != NULL)
+        {
+            m_broadPhase->DrawDebugInfo(ColorRGB::Gray);
+        }
 
         DrawColliders(m_staticColliders, ColorRGB(0.f, 1.f, 0.5f));
         DrawColliders(m_dynamicColliders, ColorRGB::Yellow);
@@ -157,6 +414,36 @@ const CollisionData* CollisionEngine::GetCollisionData()
     return &m_collisionData;
 }
 
+const ContactBufferStats& CollisionEngine::GetPotentialContactStats()
+{
+    return m_potentialContactStats;
+}
+
+const ContactBufferStats& CollisionEngine::GetContactStats()
+{
+    return m_contactStats;
+}
+
+unsigned int CollisionEngine::GetNarrowPhaseThreadCount()
+{
+    return m_narrowPhaseWorkers.GetThreadCount();
+}
+
+StaticBVH* CollisionEngine::GetStaticHierarchy()
+{
+    return &m_staticHierarchy;
+}
+
+BroadPhase* CollisionEngine::GetBroadPhase()
+{
+    return m_broadPhase;
+}
+
+CollisionFilter& CollisionEngine::GetCollisionFilter()
+{
+    return m_collisionFilter;
+}
+
 void CollisionEngine::DrawColliders(vector<Collider*>& colliders, ColorRGB color)
 {
     vector<Collider*>::iterator iter = colliders.begin();
@@ -166,61 +453,74 @@ void CollisionEngine::DrawColliders(vector<Collider*>& colliders, ColorRGB color
     }
 }
 
-void CollisionEngine::DrawBoundingSpheres(BVHNode<BoundingSphere>* bvhNode, ColorRGB color)
+void CollisionEngine::RegisterCollider(Collider* collider)
 {
-    if (bvhNode == NULL)
+    if (collider == NULL || collider->GetRegistryIndex() != -1)
         return;
 
-    if (bvhNode->GetCollider() != NULL)
+    // Static compounds are only refreshed here, as they stay out of the broad phase update
+    RefreshIfCompound(collider);
+    if (collider->IsStatic())
     {
-        Vector3 position = bvhNode->GetVolume().Center;
-        float radius = bvhNode->GetVolume().Radius;
-        Matrix4x4 sphereMatrix = Translation(position);
-        sphereMatrix = sphereMatrix * UniformScaling(radius);
-        DebugDraw::Singleton().DrawSphere(sphereMatrix, color);
+        AddToRegistry(m_staticColliders, collider);
+        AddColliderToHierarchy(collider);
     }
     else
     {
-        DrawBoundingSpheres(bvhNode->GetChild(0), color);
-        DrawBoundingSpheres(bvhNode->GetChild(1), color);
+        AddToRegistry(m_dynamicColliders, collider);
+        if (m_broadPhase != NULL)
+        {
+            m_broadPhase->AddCollider(collider);
+        }
     }
 }
 
-void CollisionEngine::RegisterCollider(Collider* collider)
+void CollisionEngine::UnregisterCollider(Collider* collider)
 {
-    if (collider == NULL)
+    if (collider == NULL || collider->GetRegistryIndex() == -1)
         return;
 
     if (collider->IsStatic())
     {
-        m_staticColliders.push_back(collider);
-        AddColliderToHierarchy(collider);
+        RemoveFromRegistry(m_staticColliders, collider);
+        RemoveColliderFromHierarchy(collider);
     }
     else
     {
-        m_dynamicColliders.push_back(collider);
+        RemoveFromRegistry(m_dynamicColliders, collider);
+        if (m_broadPhase != NULL)
+        {
+            m_broadPhase->RemoveCollider(collider);
+        }
     }
 }
 
-void CollisionEngine::UnregisterCollider(Collider* collider)
+void CollisionEngine::MigrateCollider(Collider* collider, bool isStatic)
 {
-    if (collider == NULL)
+    if (collider == NULL || collider->IsStatic() == isStatic)
         return;
 
-    if (collider->IsStatic())
-    {
-        m_staticColliders.erase(
-            std::remove(m_staticColliders.begin(), m_staticColliders.end(), collider),
-            m_staticColliders.end());
-
-        RemoveColliderFromHierarchy(collider);
-    }
-    else
+    // Colliders that aren't registered only need the flag changed
+    if (collider->GetRegistryIndex() == -1)
     {
-        m_dynamicColliders.erase(
-            std::remove(m_dynamicColliders.begin(), m_dynamicColliders.end(), collider),
-            m_dynamicColliders.end());
+        collider->SetStatic(isStatic);
+        return;
     }
+
+    UnregisterCollider(collider);
+    collider->SetStatic(isStatic);
+    RegisterCollider(collider);
+}
+
+void CollisionEngine::BuildStaticHierarchy()
+{
+    m_staticHierarchy.Build(m_staticColliders);
+    m_staticHierarchyBuilt = true;
+}
+
+void CollisionEngine::SetStaticRebuildFraction(float fraction)
+{
+    m_staticRebuildFraction = fraction;
 }
 
 void CollisionEngine::EnableDebugLog(bool enable)
@@ -235,98 +535,400 @@ void CollisionEngine::EnableDebugDraw(bool enable)
 
 void CollisionEngine::AddColliderToHierarchy(Collider* collider)
 {
-    if (collider == NULL)
+    if (collider == NULL || !m_staticHierarchyBuilt)
         return;
 
-    BoundingSphere boundingSphere(collider);
-    if (m_staticCollisionHierarchy == NULL)
+    m_staticHierarchy.Insert(collider);
+}
+
+void CollisionEngine::RemoveColliderFromHierarchy(Collider* collider)
+{
+    m_staticHierarchy.Remove(collider);
+
+    // Once the last static collider is gone (e.g. the scene was unloaded), wait for the next build again
+    if (m_staticColliders.empty())
     {
-        m_staticCollisionHierarchy = new BVHNode<BoundingSphere>(NULL, collider, boundingSphere);
+        m_staticHierarchyBuilt = false;
     }
-    else
+}
+
+void CollisionEngine::AddToRegistry(vector<Collider*>& colliders, Collider* collider)
+{
+    collider->SetRegistryIndex(colliders.size());
+    colliders.push_back(collider);
+}
+
+void CollisionEngine::RemoveFromRegistry(vector<Collider*>& colliders, Collider* collider)
+{
+    // Swap in the last collider, so that removing doesn't have to search or shift the list
+    int index = collider->GetRegistryIndex();
+    colliders[index] = colliders.back();
+    colliders[index]->SetRegistryIndex(index);
+    colliders.pop_back();
+    collider->SetRegistryIndex(-1);
+}
+
+void CollisionEngine::UpdateCollisionPairs()
+{
+    m_step++;
+    m_collisionEvents.clear();
+    m_contactEventIndices.assign(m_collisionData.ContactsUsed, -1);
+
+    // Mark every pair with a contact this step. A pair's first contact decides whether it's
+    // entering or holding, and its deepest contact is the one reported.
+    for (int i = 0; i < m_collisionData.ContactsUsed; i++)
     {
-        m_staticCollisionHierarchy->Insert(collider, boundingSphere);
+        CollisionContact& contact = m_collisionData.Contacts[i];
+        if (contact.Penetration < 0.0f)
+        {
+            continue;       // Speculative contacts aren't touching yet
+        }
+
+        GameObject* objectA = (GameObject*)contact.ColliderA->GetBodyObject();
+        GameObject* objectB = (GameObject*)contact.ColliderB->GetBodyObject();
+
+        CollisionPair* pair = m_collisionPairs.FindOrAdd(objectA, objectB);
+        if (pair->lastStep != m_step)
+        {
+            // Pairs that stopped touching were removed last step, so only a new pair can be entering
+            CollisionEventType type = pair->lastStep == 0 ? COLLISION_EVENT_ENTER : COLLISION_EVENT_HOLD;
+            pair->lastStep = m_step;
+            pair->eventIndex = -1;
+            if (IsListening(objectA, objectB, type))
+            {
+                pair->eventIndex = m_collisionEvents.size();
+                m_collisionEvents.push_back(CollisionEvent());
+
+                CollisionEvent& collisionEvent = m_collisionEvents.back();
+                collisionEvent.Type = type;
+                collisionEvent.Objects[0] = objectA;
+                collisionEvent.Objects[1] = objectB;
+                collisionEvent.Impulse = 0.0f;
+                collisionEvent.Penetration = -FLT_MAX;
+            }
+        }
+
+        if (pair->eventIndex == -1)
+        {
+            continue;
+        }
+
+        m_contactEventIndices[i] = pair->eventIndex;
+        CollisionEvent& collisionEvent = m_collisionEvents[pair->eventIndex];
+        if (contact.Penetration > collisionEvent.Penetration)
+        {
+            collisionEvent.ContactPoint = contact.ContactPoint;
+            collisionEvent.ContactNormal = collisionEvent.Objects[0] == objectA ? contact.ContactNormal : -1.0f * contact.ContactNormal;
+            collisionEvent.Penetration = contact.Penetration;
+        }
+    }
+
+    // Pairs that weren't touched this step have separated. Walk backwards, since removal moves the last pair.
+    for (int i = (int)m_collisionPairs.GetCount() - 1; i >= 0; i--)
+    {
+        CollisionPair& pair = m_collisionPairs.GetPair(i);
+        if (pair.lastStep == m_step)
+        {
+            continue;
+        }
+
+        if (IsListening(pair.gameObjects[0], pair.gameObjects[1], COLLISION_EVENT_EXIT))
+        {
+            m_collisionEvents.push_back(CollisionEvent());
+
+            CollisionEvent& collisionEvent = m_collisionEvents.back();
+            collisionEvent.Type = COLLISION_EVENT_EXIT;
+            collisionEvent.Objects[0] = pair.gameObjects[0];
+            collisionEvent.Objects[1] = pair.gameObjects[1];
+            collisionEvent.ContactPoint = Vector3::Zero;
+            collisionEvent.ContactNormal = Vector3::Zero;
+            collisionEvent.Impulse = 0.0f;
+            collisionEvent.Penetration = 0.0f;
+        }
+        m_collisionPairs.Remove(i);
     }
 }
 
-void CollisionEngine::RemoveColliderFromHierarchy(Collider* collider)
+void CollisionEngine::UpdateTriggerPairs()
 {
-    if (m_staticCollisionHierarchy == NULL)
-        return;
+    // Triggers only report entering and leaving. m_step was already advanced by UpdateCollisionPairs.
+    for (size_t i = 0; i < m_triggerContacts.size(); i++)
+    {
+        GameObject* objectA = (GameObject*)m_triggerContacts[i].colliders[0]->GetBodyObject();
+        GameObject* objectB = (GameObject*)m_triggerContacts[i].colliders[1]->GetBodyObject();
 
-    BVHNode<BoundingSphere>* node = m_staticCollisionHierarchy->Find(collider);
-    if (node != NULL)
+        CollisionPair* pair = m_triggerPairs.FindOrAdd(objectA, objectB);
+        if (pair->lastStep == 0)
+        {
+            AddTriggerEvent(TRIGGER_EVENT_ENTER, objectA, objectB);
+        }
+        pair->lastStep = m_step;
+    }
+
+    for (int i = (int)m_triggerPairs.GetCount() - 1; i >= 0; i--)
     {
-        delete node;    // deleting the node will take care of adjusting the hierarchy
+        CollisionPair& pair = m_triggerPairs.GetPair(i);
+        if (pair.lastStep == m_step)
+        {
+            continue;
+        }
+
+        AddTriggerEvent(TRIGGER_EVENT_EXIT, pair.gameObjects[0], pair.gameObjects[1]);
+        m_triggerPairs.Remove(i);
     }
 }
 
-int CollisionEngine::BroadPhaseCollision(PotentialContact* potentialContacts)
+void CollisionEngine::AddTriggerEvent(CollisionEventType type, GameObject* a, GameObject* b)
+{
+    if (!IsListening(a, b, type))
+        return;
+
+    m_collisionEvents.push_back(CollisionEvent());
+
+    CollisionEvent& collisionEvent = m_collisionEvents.back();
+    collisionEvent.Type = type;
+    collisionEvent.Objects[0] = a;
+    collisionEvent.Objects[1] = b;
+    collisionEvent.ContactPoint = Vector3::Zero;
+    collisionEvent.ContactNormal = Vector3::Zero;
+    collisionEvent.Impulse = 0.0f;
+    collisionEvent.Penetration = 0.0f;
+}
+
+bool CollisionEngine::IsListening(GameObject* a, GameObject* b, CollisionEventType type)
+{
+    return (a != NULL && a->ListensForCollisions(type)) || (b != NULL && b->ListensForCollisions(type));
+}
+
+void CollisionEngine::UpdateBroadPhase(float deltaTime)
 {
-    // Add the dynamic colliders to the collision hierarchy
+    // Give the broad phase the current bounds of each dynamic collider. This is the one place compounds are
+    // refreshed each step, so that children attached during the frame are only built into them once.
     vector<Collider*>::iterator iter = m_dynamicColliders.begin();
     for (; iter != m_dynamicColliders.end(); iter++)
     {
-        AddColliderToHierarchy(*iter);
+        Collider* collider = *iter;
+        RefreshIfCompound(collider);
+
+        // Speculative contacts need every pair that could touch during the step, so sweep the bounds
+        Vector3 displacement = GetPredictedDisplacement(collider, deltaTime);
+        BoundingBox box(collider);
+        if (m_speculativeContacts)
+        {
+            box.ExpandByDisplacement(displacement);
+        }
+
+        m_broadPhase->UpdateCollider(collider, box, displacement);
+    }
+}
+
+Vector3 CollisionEngine::GetPredictedDisplacement(Collider* collider, float deltaTime)
+{
+    // Use the rigid body's velocity (if any) to predict how far the collider will move
+    RigidBody* rigidBody = collider->GetGameObject()->GetRigidBody();
+    if (rigidBody == NULL || collider->IsStatic())
+    {
+        return Vector3::Zero;
     }
+    return rigidBody->GetVelocity() * deltaTime;
+}
 
-    // If there are no colliders at all, there can be no contact
-    if (m_staticCollisionHierarchy == NULL)
+int CollisionEngine::BroadPhaseCollision(vector<PotentialContact>& potentialContacts, float deltaTime)
+{
+    potentialContacts.clear();
+    if (m_broadPhase == NULL)
+    {
+        m_potentialContactStats.Record(0, 0);
         return 0;
+    }
 
-    // Generate the list of potential contacts
-    int numPotentialContacts = m_staticCollisionHierarchy->GetPotentialContacts(potentialContacts, MAX_POTENTIAL_CONTACTS);
+    UpdateBroadPhase(deltaTime);
 
-    // Remove the dynamic colliders from the hierarchy (because their positions may be different next frame)
-    iter = m_dynamicColliders.begin();
-    for (; iter != m_dynamicColliders.end(); iter++)
+    // Build the static hierarchy if the scene didn't, or rebuild it if enough has changed since the last build
+    unsigned int staticChanges = m_staticHierarchy.GetChangeCount();
+    if (!m_staticHierarchyBuilt || (m_staticRebuildFraction > 0.0f && staticChanges > m_staticRebuildFraction * m_staticHierarchy.GetColliderCount()))
     {
-        RemoveColliderFromHierarchy(*iter);
+        BuildStaticHierarchy();
     }
 
-    return numPotentialContacts;
+    // Dynamic vs. dynamic potential contacts
+    m_broadPhase->GetPotentialContacts(potentialContacts, &m_collisionFilter);
+
+    // Dynamic vs. static potential contacts
+    if (m_staticHierarchy.GetColliderCount() > 0)
+    {
+        vector<Collider*>::iterator iter = m_dynamicColliders.begin();
+        for (; iter != m_dynamicColliders.end(); iter++)
+        {
+            BoundingBox box(*iter);
+            if (m_speculativeContacts)
+            {
+                box.ExpandByDisplacement(GetPredictedDisplacement(*iter, deltaTime));
+            }
+            m_staticHierarchy.GetPotentialContacts(*iter, box, potentialContacts, &m_collisionFilter);
+        }
+    }
+
+    // Drop anything past the safety limit, so the narrow phase cost stays bounded
+    unsigned int truncated = 0;
+    if (potentialContacts.size() > MAX_POTENTIAL_CONTACTS)
+    {
+        truncated = potentialContacts.size() - MAX_POTENTIAL_CONTACTS;
+        potentialContacts.resize(MAX_POTENTIAL_CONTACTS);
+    }
+    m_potentialContactStats.Record(potentialContacts.size(), truncated);
+
+    SeparateTriggerPairs(potentialContacts);
+
+    // The gap a pair can close in one step is bounded by its relative displacement
+    if (m_speculativeContacts)
+    {
+        for (size_t i = 0; i < potentialContacts.size(); i++)
+        {
+            PotentialContact& potentialContact = potentialContacts[i];
+            Vector3 relativeDisplacement = GetPredictedDisplacement(potentialContact.colliders[0], deltaTime) -
+                                           GetPredictedDisplacement(potentialContact.colliders[1], deltaTime);
+            potentialContact.speculativeDistance = relativeDisplacement.Magnitude();
+        }
+    }
+
+    return potentialContacts.size();
 }
 
-int CollisionEngine::NarrowPhaseCollision(PotentialContact* potentialContacts, int count, CollisionData* collisionData)
+void CollisionEngine::SeparateTriggerPairs(vector<PotentialContact>& potentialContacts)
 {
-    int numContacts = 0;
-    for (int i = 0; i < count; i++)
+    // Pairs with a trigger skip the contact narrow phase. Triggers don't sense each other.
+    m_triggerContacts.clear();
+    size_t kept = 0;
+    for (size_t i = 0; i < potentialContacts.size(); i++)
+    {
+        PotentialContact& potentialContact = potentialContacts[i];
+        bool triggerA = potentialContact.colliders[0]->IsTrigger();
+        bool triggerB = potentialContact.colliders[1]->IsTrigger();
+        if (triggerA || triggerB)
+        {
+            if (!(triggerA && triggerB))
+            {
+                m_triggerContacts.push_back(potentialContact);
+            }
+            continue;
+        }
+
+        AddTriggerChildPairs(potentialContact.colliders[0], potentialContact.colliders[1]);
+        AddTriggerChildPairs(potentialContact.colliders[1], potentialContact.colliders[0]);
+        potentialContacts[kept++] = potentialContact;
+    }
+    potentialContacts.resize(kept);
+}
+
+void CollisionEngine::AddTriggerChildPairs(Collider* collider, Collider* other)
+{
+    // The trigger children of a solid compound are tested for overlaps with the other (solid) collider on their own
+    if (collider->GetType() != Collider::COMPOUND_COLLIDER || !((CompoundCollider*)collider)->HasTriggerChildren())
+        return;
+
+    CompoundCollider* compound = (CompoundCollider*)collider;
+    vector<int>& children = GetCompoundChildScratch();
+    unsigned int first = children.size();
+    compound->QueryChildren(BoundingBox(other), children);
+    for (unsigned int i = first; i < children.size(); i++)
     {
-        Collider* colliderA = potentialContacts[i].colliders[0];
-        Collider* colliderB = potentialContacts[i].colliders[1];
+        Collider* child = compound->GetChild(children[i]);
+        if (child->IsTrigger())
+        {
+            m_triggerContacts.push_back(PotentialContact(child, other));
+        }
+    }
+    children.resize(first);
+}
 
-        switch (colliderA->GetType())
+void CollisionEngine::TriggerOverlapTests()
+{
+    // Keep only the pairs that overlap
+    size_t kept = 0;
+    for (size_t i = 0; i < m_triggerContacts.size(); i++)
+    {
+        if (OverlapPotentialContact(m_triggerContacts[i]))
         {
-        case Collider::SPHERE_COLLIDER:
+            m_triggerContacts[kept++] = m_triggerContacts[i];
+        }
+    }
+    m_triggerContacts.resize(kept);
+}
+
+void CollisionEngine::CountNarrowPhaseTests(vector<PotentialContact>& potentialContacts)
+{
+    // Counted up front on this thread, so the narrow phase workers don't share counters
+    PhysicsStepStats& stats = PhysicsProfiler::Singleton().GetCurrentStep();
+    for (size_t i = 0; i < potentialContacts.size(); i++)
+    {
+        Collider::ColliderType typeA = potentialContacts[i].colliders[0]->GetType();
+        Collider::ColliderType typeB = potentialContacts[i].colliders[1]->GetType();
+        if (typeA <= typeB)
+            stats.NarrowPhaseTests[typeA][typeB]++;
+        else
+            stats.NarrowPhaseTests[typeB][typeA]++;
+    }
+}
+
+int CollisionEngine::NarrowPhaseCollision(vector<PotentialContact>& potentialContacts, CollisionData* collisionData)
+{
+    if (m_narrowPhaseWorkers.GetThreadCount() > 1 && potentialContacts.size() >= MIN_PARALLEL_NARROW_PHASE_PAIRS)
+    {
+        return ParallelNarrowPhaseCollision(potentialContacts, collisionData);
+    }
+
+    int numContacts = 0;
+    for (size_t i = 0; i < potentialContacts.size(); i++)
+    {
+        numContacts += CollidePotentialContact(potentialContacts[i], collisionData);
+    }
+    return numContacts;
+}
+
+int CollisionEngine::ParallelNarrowPhaseCollision(vector<PotentialContact>& potentialContacts, CollisionData* collisionData)
+{
+    // Transforms compute their matrices lazily on first read, so bring them up to date
+    // here to keep the worker threads from writing to shared colliders
+    for (size_t i = 0; i < potentialContacts.size(); i++)
+    {
+        for (int j = 0; j < 2; j++)
         {
-            switch (colliderB->GetType())
+            Collider* collider = potentialContacts[i].colliders[j];
+            collider->GetTransform().RecomputeIfDirty();
+            if (collider->GetType() == Collider::COMPOUND_COLLIDER)
             {
-            case Collider::SPHERE_COLLIDER:
-                numContacts += CollisionDetection::SphereAndSphere((SphereCollider*)colliderA, (SphereCollider*)colliderB, collisionData);
-                break;
-            case Collider::BOX_COLLIDER:
-                numContacts += CollisionDetection::SphereAndBox((SphereCollider*)colliderA, (BoxCollider*)colliderB, collisionData);
-                break;
+                ((CompoundCollider*)collider)->RecomputeChildTransforms();
             }
-            break;
         }
-        case Collider::BOX_COLLIDER:
+    }
+
+    for (size_t i = 0; i < m_threadCollisionData.size(); i++)
+    {
+        m_threadCollisionData[i].Reset();
+    }
+
+    NarrowPhaseJob job(potentialContacts, m_threadCollisionData);
+    m_narrowPhaseWorkers.Run(&job, potentialContacts.size());
+
+    // Each thread handled a contiguous range of pairs, so appending the buffers in thread
+    // order gives the same contacts, in the same order, as the single-threaded path
+    int numContacts = 0;
+    for (size_t t = 0; t < m_threadCollisionData.size(); t++)
+    {
+        CollisionData& threadData = m_threadCollisionData[t];
+        for (int i = 0; i < threadData.ContactsUsed; i++)
         {
-            switch (colliderB->GetType())
+            CollisionContact* contact = collisionData->ClaimNextContact();
+            if (contact == NULL)
             {
-            case Collider::SPHERE_COLLIDER:
-                numContacts += CollisionDetection::SphereAndBox((SphereCollider*)colliderB, (BoxCollider*)colliderA, collisionData);
+                collisionData->ContactsDropped += threadData.ContactsUsed - i - 1;
                 break;
-            case Collider::BOX_COLLIDER:
-                numContacts += CollisionDetection::BoxAndBox((BoxCollider*)colliderA, (BoxCollider*)colliderB, collisionData);
             }
-            break;
-        }
-        case Collider::CAPSULE_COLLIDER:
-        {
-            break;
-        }
+            *contact = threadData.Contacts[i];
+            numContacts++;
         }
+        collisionData->ContactsDropped += threadData.ContactsDropped;
     }
     return numContacts;
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "Physics/CollisionFilter.h"
+
+#include "GameObjectBase.h"
+
+namespace
+{
+    // The game object whose rigid body moves the collider, or the collider's own game object if nothing above it
+    // has a rigid body
+    GameObjectBase* GetOwningBody(Collider* collider)
+    {
+        GameObjectBase* gameObject = collider->GetGameObject();
+        for (GameObjectBase* ancestor = gameObject; ancestor != NULL; ancestor = ancestor->GetParent())
+        {
+            if (ancestor->GetRigidBody() != NULL)
+                return ancestor;
+        }
+        return gameObject;
+    }
+}
+
+CollisionFilter::CollisionFilter()
+{
+    for (int i = 0; i < MAX_COLLISION_LAYERS; i++)
+    {
+        m_layerMasks[i] = ALL_COLLISION_LAYERS;
+    }
+}
+
+void CollisionFilter::SetLayerMasks(const vector<unsigned int>& layerMasks)
+{
+    for (int i = 0; i < MAX_COLLISION_LAYERS; i++)
+    {
+        m_layerMasks[i] = i < (int)layerMasks.size() ? layerMasks[i] : ALL_COLLISION_LAYERS;
+    }
+
+    // Keep the matrix symmetric, so the order the broad phase reports a pair in doesn't matter
+    for (int a = 0; a < MAX_COLLISION_LAYERS; a++)
+    {
+        for (int b = a + 1; b < MAX_COLLISION_LAYERS; b++)
+        {
+            if (!LayersCollide(a, b) || !LayersCollide(b, a))
+            {
+                SetLayersCollide(a, b, false);
+            }
+        }
+    }
+}
+
+void CollisionFilter::SetLayersCollide(int layerA, int layerB, bool collide)
+{
+    if (layerA < 0 || layerA >= MAX_COLLISION_LAYERS || layerB < 0 || layerB >= MAX_COLLISION_LAYERS)
+        return;
+
+    if (collide)
+    {
+        m_layerMasks[layerA] |= 1u << layerB;
+        m_layerMasks[layerB] |= 1u << layerA;
+    }
+    else
+    {
+        m_layerMasks[layerA] &= ~(1u << layerB);
+        m_layerMasks[layerB] &= ~(1u << layerA);
+    }
+}
+
+bool CollisionFilter::LayersCollide(int layerA, int layerB)
+{
+    if (layerA < 0 || layerA >= MAX_COLLISION_LAYERS || layerB < 0 || layerB >= MAX_COLLISION_LAYERS)
+        return false;
+
+    return (m_layerMasks[layerA] & (1u << layerB)) != 0;
+}
+
+bool CollisionFilter::ShouldCollide(Collider* a, Collider* b)
+{
+    // The layer test is only a lookup, so it goes first
+    if ((m_layerMasks[a->GetLayer()] & b->GetLayerMask()) == 0)
+        return false;
+
+    return GetOwningBody(a) != GetOwningBody(b);
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "Physics/CollisionPairTable.h"
+
+#include "GameObject.h"
+#include "Util.h"
+
+namespace
+{
+    unsigned int GetObjectID(GameObject* gameObject)
+    {
+        return gameObject != NULL ? gameObject->GetID() : 0;
+    }
+}
+
+CollisionPair::CollisionPair()
+    : lastStep(0), eventIndex(-1)
+{
+    gameObjects[0] = NULL;
+    gameObjects[1] = NULL;
+}
+
+CollisionPair::CollisionPair(GameObject* a, GameObject* b)
+    : lastStep(0), eventIndex(-1)
+{
+    if (GetObjectID(b) < GetObjectID(a))
+    {
+        Swap(a, b);
+    }
+    gameObjects[0] = a;
+    gameObjects[1] = b;
+}
+
+CollisionPairTable::CollisionPairTable()
+{
+    m_slots.assign(COLLISION_PAIR_TABLE_INITIAL_SLOTS, -1);
+    m_pairs.reserve(COLLISION_PAIR_TABLE_INITIAL_SLOTS / 2);
+}
+
+CollisionPair* CollisionPairTable::FindOrAdd(GameObject* a, GameObject* b)
+{
+    CollisionPair pair(a, b);
+    unsigned int idA = GetObjectID(pair.gameObjects[0]);
+    unsigned int idB = GetObjectID(pair.gameObjects[1]);
+
+    unsigned int slot = FindSlot(idA, idB);
+    if (m_slots[slot] != -1)
+    {
+        return &m_pairs[m_slots[slot]];
+    }
+
+    // Keep the load factor at or below one half, so probe chains stay short
+    if ((m_pairs.size() + 1) * 2 > m_slots.size())
+    {
+        Grow();
+        slot = FindSlot(idA, idB);
+    }
+
+    m_slots[slot] = m_pairs.size();
+    m_pairs.push_back(pair);
+    return &m_pairs.back();
+}
+
+CollisionPair* CollisionPairTable::Find(GameObject* a, GameObject* b)
+{
+    CollisionPair pair(a, b);
+    unsigned int slot = FindSlot(GetObjectID(pair.gameObjects[0]), GetObjectID(pair.gameObjects[1]));
+    return m_slots[slot] != -1 ? &m_pairs[m_slots[slot]] : NULL;
+}
+
+void CollisionPairTable::Remove(unsigned int index)
+{
+    CollisionPair& pair = m_pairs[index];
+    unsigned int slot = FindSlot(GetObjectID(pair.gameObjects[0]), GetObjectID(pair.gameObjects[1]));
+
+    // Shift later entries of the probe chain back into the gap, as long as that doesn't
+    // move an entry before its home slot
+    unsigned int mask = m_slots.size() - 1;
+    unsigned int gap = slot;
+    unsigned int next = (gap + 1) & mask;
+    while (m_slots[next] != -1)
+    {
+        CollisionPair& nextPair = m_pairs[m_slots[next]];
+        unsigned int home = GetHomeSlot(GetObjectID(nextPair.gameObjects[0]), GetObjectID(nextPair.gameObjects[1]));
+        if (((next - home) & mask) >= ((next - gap) & mask))
+        {
+            m_slots[gap] = m_slots[next];
+            gap = next;
+        }
+        next = (next + 1) & mask;
+    }
+    m_slots[gap] = -1;
+
+    // Move the last pair into the removed pair's place, and point its slot at the new index
+    unsigned int last = m_pairs.size() - 1;
+    if (index != last)
+    {
+        CollisionPair& lastPair = m_pairs[last];
+        m_slots[FindSlot(GetObjectID(lastPair.gameObjects[0]), GetObjectID(lastPair.gameObjects[1]))] = index;
+        m_pairs[index] = lastPair;
+    }
+    m_pairs.pop_back();
+}
+
+void CollisionPairTable::Clear()
+{
+    m_pairs.clear();
+    m_slots.assign(m_slots.size(), -1);
+}
+
+unsigned int CollisionPairTable::GetCount()
+{
+    return m_pairs.size();
+}
+
+CollisionPair& CollisionPairTable::GetPair(unsigned int index)
+{
+    return m_pairs[index];
+}
+
+unsigned int CollisionPairTable::FindSlot(unsigned int idA, unsigned int idB)
+{
+    unsigned int mask = m_slots.size() - 1;
+    unsigned int slot = GetHomeSlot(idA, idB);
+    while (m_slots[slot] != -1)
+    {
+        CollisionPair& pair = m_pairs[m_slots[slot]];
+        if (GetObjectID(pair.gameObjects[0]) == idA && GetObjectID(pair.gameObjects[1]) == idB)
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+unsigned int CollisionPairTable::GetHomeSlot(unsigned int idA, unsigned int idB)
+{
+    unsigned int hash = idA * 73856093u ^ idB * 19349663u;
+    hash ^= hash >> 16;
+    return hash & (m_slots.size() - 1);
+}
+
+void CollisionPairTable::Grow()
+{
+    m_slots.assign(m_slots.size() * 2, -1);
+    for (unsigned int i = 0; i < m_pairs.size(); i++)
+    {
+        CollisionPair& pair = m_pairs[i];
+        m_slots[FindSlot(GetObjectID(pair.gameObjects[0]), GetObjectID(pair.gameObjects[1]))] = i;
+    }
+}
\ No newline at end of file
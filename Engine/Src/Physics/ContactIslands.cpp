@@ -0,0 +1,199 @@
+#include "Physics/ContactIslands.h"
+
+#include "Physics/RigidBody.h"
+#include "Physics/RigidBodyContact.h"
+
+ContactIslands::ContactIslands()
+    : m_inputBodies(NULL)
+{}
+
+void ContactIslands::Build(vector<RigidBody*>& bodies, RigidBodyContact* contacts, unsigned int numContacts)
+{
+    m_inputBodies = &bodies;
+
+    // Start with each body in its own set
+    unsigned int numBodies = bodies.size();
+    m_parent.resize(numBodies);
+    m_size.resize(numBodies);
+    for (unsigned int i = 0; i < numBodies; i++)
+    {
+        bodies[i]->SetIslandIndex(i);
+        m_parent[i] = i;
+        m_size[i] = 1;
+    }
+
+    // Merge the sets of any two bodies that are in contact
+    for (unsigned int i = 0; i < numContacts; i++)
+    {
+        int a = GetLinkIndex(contacts[i].Body[0]);
+        int b = GetLinkIndex(contacts[i].Body[1]);
+        if (a >= 0 && b >= 0)
+        {
+            Union(a, b);
+        }
+    }
+
+    // Number the islands, in body order so the result doesn't depend on how the sets were merged
+    m_islands.clear();
+    m_islandOfRoot.assign(numBodies, -1);
+    for (unsigned int i = 0; i < numBodies; i++)
+    {
+        int root = Find(i);
+        if (m_islandOfRoot[root] < 0)
+        {
+            Island island = { 0, 0, 0, 0 };
+            m_islandOfRoot[root] = m_islands.size();
+            m_islands.push_back(island);
+        }
+        m_islands[m_islandOfRoot[root]].BodyCount++;
+    }
+
+    // A contact belongs to the island of its (first) movable body
+    int unregisteredIsland = -1;
+    m_contactIsland.resize(numContacts);
+    for (unsigned int i = 0; i < numContacts; i++)
+    {
+        int body = GetLinkIndex(contacts[i].Body[0]);
+        if (body < 0)
+        {
+            body = GetLinkIndex(contacts[i].Body[1]);
+        }
+        if (body < 0)
+        {
+            body = GetBodyIndex(contacts[i].Body[0]);
+        }
+        if (body < 0)
+        {
+            body = GetBodyIndex(contacts[i].Body[1]);
+        }
+
+        int island = 0;
+        if (body >= 0)
+        {
+            island = m_islandOfRoot[Find(body)];
+        }
+        else
+        {
+            // None of the bodies are registered with the physics engine, so group these contacts on their own
+            if (unregisteredIsland < 0)
+            {
+                Island empty = { 0, 0, 0, 0 };
+                unregisteredIsland = m_islands.size();
+                m_islands.push_back(empty);
+            }
+            island = unregisteredIsland;
+        }
+        m_contactIsland[i] = island;
+        m_islands[island].ContactCount++;
+    }
+
+    // Lay out each island's contacts and bodies contiguously (a counting sort, which keeps their order)
+    unsigned int nextContact = 0;
+    unsigned int nextBody = 0;
+    for (size_t i = 0; i < m_islands.size(); i++)
+    {
+        m_islands[i].FirstContact = nextContact;
+        m_islands[i].FirstBody = nextBody;
+        nextContact += m_islands[i].ContactCount;
+        nextBody += m_islands[i].BodyCount;
+
+        // Reset the counts, they are used as fill cursors below
+        m_islands[i].ContactCount = 0;
+        m_islands[i].BodyCount = 0;
+    }
+
+    if (m_contacts.size() < numContacts)
+    {
+        m_contacts.resize(numContacts);
+    }
+    for (unsigned int i = 0; i < numContacts; i++)
+    {
+        Island& island = m_islands[m_contactIsland[i]];
+        m_contacts[island.FirstContact + island.ContactCount] = contacts[i];
+        island.ContactCount++;
+    }
+
+    m_bodies.resize(numBodies);
+    for (unsigned int i = 0; i < numBodies; i++)
+    {
+        Island& island = m_islands[m_islandOfRoot[Find(i)]];
+        m_bodies[island.FirstBody + island.BodyCount] = bodies[i];
+        island.BodyCount++;
+    }
+}
+
+unsigned int ContactIslands::GetIslandCount()
+{
+    return m_islands.size();
+}
+
+const ContactIslands::Island& ContactIslands::GetIsland(unsigned int index)
+{
+    return m_islands[index];
+}
+
+RigidBodyContact* ContactIslands::GetContacts(const Island& island)
+{
+    if (island.ContactCount == 0)
+        return NULL;
+
+    return &m_contacts[island.FirstContact];
+}
+
+RigidBody** ContactIslands::GetBodies(const Island& island)
+{
+    if (island.BodyCount == 0)
+        return NULL;
+
+    return &m_bodies[island.FirstBody];
+}
+
+int ContactIslands::Find(int body)
+{
+    // Path halving: point each visited node at its grandparent
+    while (m_parent[body] != body)
+    {
+        m_parent[body] = m_parent[m_parent[body]];
+        body = m_parent[body];
+    }
+    return body;
+}
+
+void ContactIslands::Union(int a, int b)
+{
+    a = Find(a);
+    b = Find(b);
+    if (a == b)
+        return;
+
+    // Attach the smaller set to the larger one, to keep the trees shallow
+    if (m_size[a] < m_size[b])
+    {
+        int temp = a;
+        a = b;
+        b = temp;
+    }
+    m_parent[b] = a;
+    m_size[a] += m_size[b];
+}
+
+int ContactIslands::GetBodyIndex(RigidBody* body)
+{
+    if (body == NULL)
+        return -1;
+
+    int index = body->GetIslandIndex();
+    if (index < 0 || index >= (int)m_inputBodies->size() || (*m_inputBodies)[index] != body)
+        return -1;
+
+    return index;
+}
+
+int ContactIslands::GetLinkIndex(RigidBody* body)
+{
+    // Immovable bodies act like static geometry and don't connect islands
+    if (body == NULL || !body->HasFiniteMass())
+        return -1;
+
+    return GetBodyIndex(body);
+}
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "Physics/ContactManifold.h"
+
+#include "Math/Transform.h"
+#include "Physics/Collider.h"
+#include "Physics/CollisionDetection.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+    // Orders the colliders of a pair, so that a pair has the same key whichever way round it is reported
+    void GetPairKey(Collider* a, Collider* b, Collider*& first, Collider*& second)
+    {
+        bool ordered = std::less<Collider*>()(a, b);
+        first = ordered ? a : b;
+        second = ordered ? b : a;
+    }
+
+    bool IsSamePair(const ContactManifold& manifold, const CollisionContact& contact)
+    {
+        return (manifold.ColliderA == contact.ColliderA && manifold.ColliderB == contact.ColliderB) ||
+               (manifold.ColliderA == contact.ColliderB && manifold.ColliderB == contact.ColliderA);
+    }
+}
+
+ContactManifold::ContactManifold()
+    : ColliderA(NULL), ColliderB(NULL), PointCount(0)
+{}
+
+ContactManifold::ContactManifold(Collider* a, Collider* b)
+    : ColliderA(a), ColliderB(b), PointCount(0)
+{}
+
+void ContactManifoldCache::Update(CollisionData* data)
+{
+    // Last step's manifolds are only needed for lookup, so sort them by pair
+    m_previousManifolds.swap(m_manifolds);
+    m_manifolds.clear();
+    std::sort(m_previousManifolds.begin(), m_previousManifolds.end(), ManifoldComparator);
+
+    m_contacts.assign(data->Contacts.begin(), data->Contacts.begin() + data->ContactsUsed);
+
+    // The narrow phase reports all of a pair's contacts together, so a new manifold starts whenever the pair changes
+    ContactManifold* manifold = NULL;
+    for (unsigned int i = 0; i < m_contacts.size(); i++)
+    {
+        const CollisionContact& contact = m_contacts[i];
+        if (manifold == NULL || !IsSamePair(*manifold, contact))
+        {
+            ContactManifold key(contact.ColliderA, contact.ColliderB);
+            vector<ContactManifold>::iterator iter = std::lower_bound(m_previousManifolds.begin(), m_previousManifolds.end(), key, ManifoldComparator);
+            if (iter != m_previousManifolds.end() && !ManifoldComparator(key, *iter))
+            {
+                m_manifolds.push_back(*iter);
+                RefreshPoints(m_manifolds.back());
+            }
+            else
+            {
+                m_manifolds.push_back(key);
+            }
+            manifold = &m_manifolds.back();
+        }
+
+        AddContact(*manifold, contact);
+    }
+
+    // Report every manifold point as a contact. Points keep a pointer to their manifold point, which
+    // stays valid until the next update, so the solver can read and store accumulated impulses.
+    data->Reset();
+    for (unsigned int i = 0; i < m_manifolds.size(); i++)
+    {
+        ContactManifold& current = m_manifolds[i];
+        for (int p = 0; p < current.PointCount; p++)
+        {
+            CollisionContact* contact = data->ClaimNextContact();
+            if (contact == NULL)
+                return;
+
+            ManifoldPoint& point = current.Points[p];
+            contact->ColliderA = current.ColliderA;
+            contact->ColliderB = current.ColliderB;
+            contact->ContactPoint = point.ContactPoint;
+            contact->ContactNormal = point.ContactNormal;
+            contact->Penetration = point.Penetration;
+            contact->FeatureId = point.FeatureId;
+            contact->CachedPoint = &point;
+        }
+    }
+}
+
+void ContactManifoldCache::Clear()
+{
+    m_manifolds.clear();
+    m_previousManifolds.clear();
+}
+
+unsigned int ContactManifoldCache::GetManifoldCount()
+{
+    return m_manifolds.size();
+}
+
+void ContactManifoldCache::RefreshPoints(ContactManifold& manifold)
+{
+    Transform& transformA = manifold.ColliderA->GetTransform();
+    Transform& transformB = manifold.ColliderB->GetTransform();
+
+    int count = 0;
+    for (int i = 0; i < manifold.PointCount; i++)
+    {
+        ManifoldPoint& point = manifold.Points[i];
+        point.Age++;
+
+        // Move the point along with both colliders, and check that they are still touching there
+        Vector3 pointA = transformA.TransformPoint(point.LocalPointA);
+        Vector3 pointB = transformB.TransformPoint(point.LocalPointB);
+        Vector3 offset = pointB - pointA;
+        float penetration = offset.Dot(point.ContactNormal);
+        Vector3 slide = offset - point.ContactNormal * penetration;
+
+        if (point.Age > MANIFOLD_MAX_AGE ||
+            penetration < -MANIFOLD_BREAKING_DISTANCE ||
+            slide.MagnitudeSqrd() > MANIFOLD_BREAKING_DISTANCE * MANIFOLD_BREAKING_DISTANCE)
+        {
+            continue;
+        }
+
+        point.ContactPoint = (pointA + pointB) * 0.5f;
+        point.Penetration = penetration;
+        manifold.Points[count++] = point;
+    }
+    manifold.PointCount = count;
+}
+
+void ContactManifoldCache::AddContact(ContactManifold& manifold, const CollisionContact& contact)
+{
+    // Contacts may report the pair the other way round, so flip them to match the manifold
+    bool flipped = (contact.ColliderA != manifold.ColliderA);
+    Vector3 normal = flipped ? contact.ContactNormal * -1.0f : contact.ContactNormal;
+
+    // The contact point lies between the two surfaces, and collider A is pushed along the normal
+    ManifoldPoint point;
+    point.ContactPoint = contact.ContactPoint;
+    point.ContactNormal = normal;
+    point.Penetration = contact.Penetration;
+    point.LocalPointA = manifold.ColliderA->GetTransform().InverseTransformPoint(contact.ContactPoint - normal * (contact.Penetration * 0.5f));
+    point.LocalPointB = manifold.ColliderB->GetTransform().InverseTransformPoint(contact.ContactPoint + normal * (contact.Penetration * 0.5f));
+    point.FeatureId = contact.FeatureId;
+    point.Age = 0;
+    point.NormalImpulse = 0.0f;
+    point.TangentImpulse = Vector3::Zero;
+
+    // Feature IDs describe the pair in the order it was reported, so flipped contacts are matched by distance
+    int index = FindMatchingPoint(manifold, point, !flipped);
+    if (index >= 0)
+    {
+        // Keep the accumulated impulses of the point being replaced
+        point.NormalImpulse = manifold.Points[index].NormalImpulse;
+        point.TangentImpulse = manifold.Points[index].TangentImpulse;
+        manifold.Points[index] = point;
+    }
+    else if (manifold.PointCount < MAX_MANIFOLD_POINTS)
+    {
+        manifold.Points[manifold.PointCount++] = point;
+    }
+    else
+    {
+        index = ChoosePointToReplace(manifold, point);
+        if (index >= 0)
+        {
+            manifold.Points[index] = point;
+        }
+    }
+}
+
+int ContactManifoldCache::FindMatchingPoint(ContactManifold& manifold, const ManifoldPoint& point, bool matchFeature)
+{
+    if (matchFeature && point.FeatureId != 0)
+    {
+        for (int i = 0; i < manifold.PointCount; i++)
+        {
+            if (manifold.Points[i].FeatureId == point.FeatureId)
+                return i;
+        }
+    }
+
+    int nearest = -1;
+    float nearestDistanceSqrd = MANIFOLD_MATCH_DISTANCE * MANIFOLD_MATCH_DISTANCE;
+    for (int i = 0; i < manifold.PointCount; i++)
+    {
+        float distanceSqrd = (manifold.Points[i].ContactPoint - point.ContactPoint).MagnitudeSqrd();
+        if (distanceSqrd < nearestDistanceSqrd)
+        {
+            nearestDistanceSqrd = distanceSqrd;
+            nearest = i;
+        }
+    }
+    return nearest;
+}
+
+int ContactManifoldCache::ChoosePointToReplace(ContactManifold& manifold, const ManifoldPoint& point)
+{
+    // Never replace the deepest point
+    int deepest = -1;
+    float maxPenetration = point.Penetration;
+    for (int i = 0; i < MAX_MANIFOLD_POINTS; i++)
+    {
+        if (manifold.Points[i].Penetration > maxPenetration)
+        {
+            maxPenetration = manifold.Points[i].Penetration;
+            deepest = i;
+        }
+    }
+
+    // Replace whichever point leaves the remaining four spread over the largest area
+    int best = -1;
+    float bestArea = -1.0f;
+    for (int i = 0; i < MAX_MANIFOLD_POINTS; i++)
+    {
+        if (i == deepest)
+            continue;
+
+        Vector3 corners[MAX_MANIFOLD_POINTS];
+        for (int j = 0; j < MAX_MANIFOLD_POINTS; j++)
+        {
+            corners[j] = (j == i) ? point.ContactPoint : manifold.Points[j].ContactPoint;
+        }
+
+        // Compare the (squared) areas of the quads, taking whichever ordering of the corners is widest
+        float area = (corners[0] - corners[1]).Cross(corners[2] - corners[3]).MagnitudeSqrd();
+        float area02 = (corners[0] - corners[2]).Cross(corners[1] - corners[3]).MagnitudeSqrd();
+        float area03 = (corners[0] - corners[3]).Cross(corners[1] - corners[2]).MagnitudeSqrd();
+        area = area > area02 ? area : area02;
+        area = area > area03 ? area : area03;
+
+        if (area > bestArea)
+        {
+            bestArea = area;
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool ContactManifoldCache::ManifoldComparator(const ContactManifold& lhs, const ContactManifold& rhs)
+{
+    Collider* l0;
+    Collider* l1;
+    Collider* r0;
+    Collider* r1;
+    GetPairKey(lhs.ColliderA, lhs.ColliderB, l0, l1);
+    GetPairKey(rhs.ColliderA, rhs.ColliderB, r0, r1);
+
+    std::less<Collider*> less;
+    if (l0 != r0)
+    {
+        return less(l0, r0);
+    }
+    return less(l1, r1);
+}
\ No newline at end of file
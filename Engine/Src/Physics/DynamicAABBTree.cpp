@@ -0,0 +1,519 @@
+#include "Physics/DynamicAABBTree.h"
+
+#include "Debugging/DebugDraw.h"
+#include "Math/Transformations.h"
+#include "Physics/Collider.h"
+#include "Physics/CollisionEngine.h"
+#include "Physics/CollisionFilter.h"
+
+#include <assert.h>
+
+const float DynamicAABBTree::FAT_BOX_MARGIN = 0.1f;
+const float DynamicAABBTree::DISPLACEMENT_MULTIPLIER = 2.0f;
+
+DynamicAABBTree::DynamicAABBTree()
+    : m_root(NULL_NODE), m_freeList(NULL_NODE)
+{}
+
+void DynamicAABBTree::AddCollider(Collider* collider)
+{
+    if (collider == NULL || collider->GetBroadPhaseProxy() != -1)
+        return;
+
+    int proxy = CreateProxy(collider, BoundingBox(collider));
+    collider->SetBroadPhaseProxy(proxy);
+}
+
+void DynamicAABBTree::RemoveCollider(Collider* collider)
+{
+    if (collider == NULL || collider->GetBroadPhaseProxy() == -1)
+        return;
+
+    DestroyProxy(collider->GetBroadPhaseProxy());
+    collider->SetBroadPhaseProxy(-1);
+}
+
+void DynamicAABBTree::UpdateCollider(Collider* collider, const BoundingBox& box, const Vector3& displacement)
+{
+    MoveProxy(collider->GetBroadPhaseProxy(), box, displacement);
+}
+
+int DynamicAABBTree::CreateProxy(Collider* collider, const BoundingBox& box)
+{
+    int proxy = AllocateNode();
+
+    m_nodes[proxy].Box = box;
+    m_nodes[proxy].Box.Expand(FAT_BOX_MARGIN);
+    m_nodes[proxy].Object = collider;
+    m_nodes[proxy].Height = 0;
+    m_nodes[proxy].LeafIndex = (int)m_leaves.size();
+    m_leaves.push_back(proxy);
+
+    InsertLeaf(proxy);
+    return proxy;
+}
+
+void DynamicAABBTree::DestroyProxy(int proxy)
+{
+    assert(proxy >= 0 && proxy < (int)m_nodes.size() && m_nodes[proxy].IsLeaf());
+
+    RemoveLeaf(proxy);
+
+    // Swap-remove from the leaf list so that removal is O(1)
+    int leafIndex = m_nodes[proxy].LeafIndex;
+    int lastLeaf = m_leaves.back();
+    m_leaves[leafIndex] = lastLeaf;
+    m_nodes[lastLeaf].LeafIndex = leafIndex;
+    m_leaves.pop_back();
+
+    FreeNode(proxy);
+}
+
+bool DynamicAABBTree::MoveProxy(int proxy, const BoundingBox& box, const Vector3& displacement)
+{
+    assert(proxy >= 0 && proxy < (int)m_nodes.size() && m_nodes[proxy].IsLeaf());
+
+    // If the collider is still inside its fat box, the tree doesn't need to change
+    if (m_nodes[proxy].Box.Contains(&box))
+        return false;
+
+    RemoveLeaf(proxy);
+
+    // Enlarge the box by a fixed margin, and by the predicted displacement so that fast
+    // moving colliders don't have to be reinserted every frame
+    BoundingBox fatBox = box;
+    fatBox.Expand(FAT_BOX_MARGIN);
+    fatBox.ExpandByDisplacement(displacement * DISPLACEMENT_MULTIPLIER);
+    m_nodes[proxy].Box = fatBox;
+
+    InsertLeaf(proxy);
+    return true;
+}
+
+Collider* DynamicAABBTree::GetCollider(int proxy)
+{
+    return m_nodes[proxy].Object;
+}
+
+const BoundingBox& DynamicAABBTree::GetFatBox(int proxy)
+{
+    return m_nodes[proxy].Box;
+}
+
+int DynamicAABBTree::GetHeight()
+{
+    if (m_root == NULL_NODE)
+        return 0;
+    return m_nodes[m_root].Height;
+}
+
+void DynamicAABBTree::Query(const BoundingBox& box, vector<int>& results)
+{
+    if (m_root == NULL_NODE)
+        return;
+
+    // Iterative traversal with an explicit stack (reused between queries to avoid allocation)
+    m_queryStack.clear();
+    m_queryStack.push_back(m_root);
+    while (!m_queryStack.empty())
+    {
+        int nodeIndex = m_queryStack.back();
+        m_queryStack.pop_back();
+
+        Node& node = m_nodes[nodeIndex];
+        if (!node.Box.Overlaps(&box))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            results.push_back(nodeIndex);
+        }
+        else
+        {
+            m_queryStack.push_back(node.Children[0]);
+            m_queryStack.push_back(node.Children[1]);
+        }
+    }
+}
+
+unsigned int DynamicAABBTree::GetPotentialContacts(vector<PotentialContact>& contacts, CollisionFilter* filter)
+{
+    unsigned int count = 0;
+    for (size_t i = 0; i < m_leaves.size(); i++)
+    {
+        int proxy = m_leaves[i];
+
+        m_queryResults.clear();
+        Query(m_nodes[proxy].Box, m_queryResults);
+
+        for (size_t j = 0; j < m_queryResults.size(); j++)
+        {
+            // Each pair is found twice (once from each side), so only keep one of them
+            int other = m_queryResults[j];
+            if (other <= proxy)
+                continue;
+
+            if (filter != NULL && !filter->ShouldCollide(m_nodes[proxy].Object, m_nodes[other].Object))
+                continue;
+
+            contacts.push_back(PotentialContact(m_nodes[proxy].Object, m_nodes[other].Object));
+            count++;
+        }
+    }
+    return count;
+}
+
+void DynamicAABBTree::QueryBox(const BoundingBox& box, vector<Collider*>& results)
+{
+    m_queryResults.clear();
+    Query(box, m_queryResults);
+    for (size_t i = 0; i < m_queryResults.size(); i++)
+    {
+        results.push_back(m_nodes[m_queryResults[i]].Object);
+    }
+}
+
+void DynamicAABBTree::QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, BroadPhaseRayCallback* callback)
+{
+    if (m_root == NULL_NODE)
+        return;
+
+    Vector3 inverseDirection(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+    float entryDistance;
+    if (!m_nodes[m_root].Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, entryDistance))
+        return;
+
+    // Visit the nearer child first, so that the callback can shorten the ray before the farther one is tested
+    m_queryStack.clear();
+    m_queryStack.push_back(m_root);
+    while (!m_queryStack.empty())
+    {
+        int nodeIndex = m_queryStack.back();
+        m_queryStack.pop_back();
+
+        Node& node = m_nodes[nodeIndex];
+        if (!node.Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, entryDistance))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            maxDistance = callback->RayTest(node.Object, maxDistance);
+            continue;
+        }
+
+        float entry0, entry1;
+        bool hit0 = m_nodes[node.Children[0]].Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, entry0);
+        bool hit1 = m_nodes[node.Children[1]].Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, entry1);
+        if (hit0 && hit1)
+        {
+            bool firstIsNearer = entry0 <= entry1;
+            m_queryStack.push_back(firstIsNearer ? node.Children[1] : node.Children[0]);
+            m_queryStack.push_back(firstIsNearer ? node.Children[0] : node.Children[1]);
+        }
+        else if (hit0)
+        {
+            m_queryStack.push_back(node.Children[0]);
+        }
+        else if (hit1)
+        {
+            m_queryStack.push_back(node.Children[1]);
+        }
+    }
+}
+
+void DynamicAABBTree::DrawDebugInfo(ColorRGB color)
+{
+    for (size_t i = 0; i < m_leaves.size(); i++)
+    {
+        BoundingBox& box = m_nodes[m_leaves[i]].Box;
+        Matrix4x4 boxMatrix = Translation(box.GetCenter());
+        boxMatrix = boxMatrix * Scaling(box.GetHalfsize());
+        DebugDraw::Singleton().DrawCube(boxMatrix, color);
+    }
+}
+
+int DynamicAABBTree::AllocateNode()
+{
+    // Grow the node pool if the free list is empty
+    if (m_freeList == NULL_NODE)
+    {
+        Node node;
+        node.Parent = NULL_NODE;
+        m_nodes.push_back(node);
+        m_freeList = (int)m_nodes.size() - 1;
+    }
+
+    int nodeIndex = m_freeList;
+    Node& node = m_nodes[nodeIndex];
+    m_freeList = node.Parent;
+
+    node.Object = NULL;
+    node.Parent = NULL_NODE;
+    node.Children[0] = NULL_NODE;
+    node.Children[1] = NULL_NODE;
+    node.Height = 0;
+    node.LeafIndex = -1;
+    return nodeIndex;
+}
+
+void DynamicAABBTree::FreeNode(int node)
+{
+    m_nodes[node].Object = NULL;
+    m_nodes[node].Height = -1;
+    m_nodes[node].Parent = m_freeList;
+    m_freeList = node;
+}
+
+void DynamicAABBTree::InsertLeaf(int leaf)
+{
+    if (m_root == NULL_NODE)
+    {
+        m_root = leaf;
+        m_nodes[m_root].Parent = NULL_NODE;
+        return;
+    }
+
+    // Find the best sibling for the new leaf by descending the tree, using the change in surface
+    // area as the cost of placing the leaf under each node
+    BoundingBox leafBox = m_nodes[leaf].Box;
+    int index = m_root;
+    while (!m_nodes[index].IsLeaf())
+    {
+        int child0 = m_nodes[index].Children[0];
+        int child1 = m_nodes[index].Children[1];
+
+        float area = m_nodes[index].Box.GetSurfaceArea();
+        float combinedArea = BoundingBox(m_nodes[index].Box, leafBox).GetSurfaceArea();
+
+        // Cost of creating a new parent for this node and the new leaf
+        float cost = 2.0f * combinedArea;
+
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float childCost[2];
+        int children[2] = { child0, child1 };
+        for (int i = 0; i < 2; i++)
+        {
+            BoundingBox combined(leafBox, m_nodes[children[i]].Box);
+            if (m_nodes[children[i]].IsLeaf())
+            {
+                childCost[i] = combined.GetSurfaceArea() + inheritanceCost;
+            }
+            else
+            {
+                childCost[i] = combined.GetSurfaceArea() - m_nodes[children[i]].Box.GetSurfaceArea() + inheritanceCost;
+            }
+        }
+
+        // Stop descending if creating a new parent here is cheapest
+        if (cost < childCost[0] && cost < childCost[1])
+            break;
+
+        index = (childCost[0] < childCost[1]) ? child0 : child1;
+    }
+
+    int sibling = index;
+
+    // Create a new parent for the sibling and the new leaf
+    int oldParent = m_nodes[sibling].Parent;
+    int newParent = AllocateNode();
+    m_nodes[newParent].Parent = oldParent;
+    m_nodes[newParent].Box = BoundingBox(leafBox, m_nodes[sibling].Box);
+    m_nodes[newParent].Height = m_nodes[sibling].Height + 1;
+    m_nodes[newParent].Children[0] = sibling;
+    m_nodes[newParent].Children[1] = leaf;
+    m_nodes[sibling].Parent = newParent;
+    m_nodes[leaf].Parent = newParent;
+
+    if (oldParent != NULL_NODE)
+    {
+        if (m_nodes[oldParent].Children[0] == sibling)
+        {
+            m_nodes[oldParent].Children[0] = newParent;
+        }
+        else
+        {
+            m_nodes[oldParent].Children[1] = newParent;
+        }
+    }
+    else
+    {
+        // The sibling was the root
+        m_root = newParent;
+    }
+
+    RefitAncestors(m_nodes[leaf].Parent);
+}
+
+void DynamicAABBTree::RemoveLeaf(int leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NULL_NODE;
+        return;
+    }
+
+    int parent = m_nodes[leaf].Parent;
+    int grandParent = m_nodes[parent].Parent;
+    int sibling = (m_nodes[parent].Children[0] == leaf) ? m_nodes[parent].Children[1] : m_nodes[parent].Children[0];
+
+    // Replace the parent with the sibling, and free the parent
+    if (grandParent != NULL_NODE)
+    {
+        if (m_nodes[grandParent].Children[0] == parent)
+        {
+            m_nodes[grandParent].Children[0] = sibling;
+        }
+        else
+        {
+            m_nodes[grandParent].Children[1] = sibling;
+        }
+        m_nodes[sibling].Parent = grandParent;
+        FreeNode(parent);
+
+        RefitAncestors(grandParent);
+    }
+    else
+    {
+        m_root = sibling;
+        m_nodes[sibling].Parent = NULL_NODE;
+        FreeNode(parent);
+    }
+
+    m_nodes[leaf].Parent = NULL_NODE;
+}
+
+void DynamicAABBTree::RefitAncestors(int node)
+{
+    // Walk back up the tree, rebalancing and fixing heights and bounding boxes
+    int index = node;
+    while (index != NULL_NODE)
+    {
+        index = Balance(index);
+
+        int child0 = m_nodes[index].Children[0];
+        int child1 = m_nodes[index].Children[1];
+
+        m_nodes[index].Height = 1 + (m_nodes[child0].Height > m_nodes[child1].Height ? m_nodes[child0].Height : m_nodes[child1].Height);
+        m_nodes[index].Box = BoundingBox(m_nodes[child0].Box, m_nodes[child1].Box);
+
+        index = m_nodes[index].Parent;
+    }
+}
+
+int DynamicAABBTree::Balance(int a)
+{
+    // Performs a left or right rotation if node A is imbalanced, and returns the new subtree root.
+    // If A's child C is too tall, C takes A's place and A becomes C's child. A keeps its other
+    // child B, and C keeps its taller child while its shorter child moves under A.
+    // The mirrored case rotates A's child B up in the same way.
+    if (m_nodes[a].IsLeaf() || m_nodes[a].Height < 2)
+        return a;
+
+    int b = m_nodes[a].Children[0];
+    int c = m_nodes[a].Children[1];
+    int balance = m_nodes[c].Height - m_nodes[b].Height;
+
+    // Rotate C up
+    if (balance > 1)
+    {
+        int f = m_nodes[c].Children[0];
+        int g = m_nodes[c].Children[1];
+
+        // Swap A and C
+        m_nodes[c].Children[0] = a;
+        m_nodes[c].Parent = m_nodes[a].Parent;
+        m_nodes[a].Parent = c;
+
+        // A's old parent should point to C
+        if (m_nodes[c].Parent != NULL_NODE)
+        {
+            if (m_nodes[m_nodes[c].Parent].Children[0] == a)
+            {
+                m_nodes[m_nodes[c].Parent].Children[0] = c;
+            }
+            else
+            {
+                m_nodes[m_nodes[c].Parent].Children[1] = c;
+            }
+        }
+        else
+        {
+            m_root = c;
+        }
+
+        // Keep the taller grandchild under C, and move the other one under A
+        int keep = f;
+        int move = g;
+        if (m_nodes[f].Height <= m_nodes[g].Height)
+        {
+            keep = g;
+            move = f;
+        }
+
+        m_nodes[c].Children[1] = keep;
+        m_nodes[a].Children[1] = move;
+        m_nodes[move].Parent = a;
+
+        m_nodes[a].Box = BoundingBox(m_nodes[b].Box, m_nodes[move].Box);
+        m_nodes[c].Box = BoundingBox(m_nodes[a].Box, m_nodes[keep].Box);
+
+        m_nodes[a].Height = 1 + (m_nodes[b].Height > m_nodes[move].Height ? m_nodes[b].Height : m_nodes[move].Height);
+        m_nodes[c].Height = 1 + (m_nodes[a].Height > m_nodes[keep].Height ? m_nodes[a].Height : m_nodes[keep].Height);
+
+        return c;
+    }
+
+    // Rotate B up
+    if (balance < -1)
+    {
+        int d = m_nodes[b].Children[0];
+        int e = m_nodes[b].Children[1];
+
+        // Swap A and B
+        m_nodes[b].Children[0] = a;
+        m_nodes[b].Parent = m_nodes[a].Parent;
+        m_nodes[a].Parent = b;
+
+        // A's old parent should point to B
+        if (m_nodes[b].Parent != NULL_NODE)
+        {
+            if (m_nodes[m_nodes[b].Parent].Children[0] == a)
+            {
+                m_nodes[m_nodes[b].Parent].Children[0] = b;
+            }
+            else
+            {
+                m_nodes[m_nodes[b].Parent].Children[1] = b;
+            }
+        }
+        else
+        {
+            m_root = b;
+        }
+
+        // Keep the taller grandchild under B, and move the other one under A
+        int keep = d;
+        int move = e;
+        if (m_nodes[d].Height <= m_nodes[e].Height)
+        {
+            keep = e;
+            move = d;
+        }
+
+        m_nodes[b].Children[1] = keep;
+        m_nodes[a].Children[0] = move;
+        m_nodes[move].Parent = a;
+
+        m_nodes[a].Box = BoundingBox(m_nodes[c].Box, m_nodes[move].Box);
+        m_nodes[b].Box = BoundingBox(m_nodes[a].Box, m_nodes[keep].Box);
+
+        m_nodes[a].Height = 1 + (m_nodes[c].Height > m_nodes[move].Height ? m_nodes[c].Height : m_nodes[move].Height);
+        m_nodes[b].Height = 1 + (m_nodes[a].Height > m_nodes[keep].Height ? m_nodes[a].Height : m_nodes[keep].Height);
+
+        return b;
+    }
+
+    return a;
+}
\ No newline at end of file
@@ -1,10 +1,21 @@
 #include "Physics/ForceGenerator.h"
 #include "Physics/RigidBody.h"
-#include <algorithm>
+
+ForceGenerator::ForceGeneratorType ForceGenerator::GetType()
+{
+    return CUSTOM_FORCE_GENERATOR;
+}
+
+//-----------------------------------------------------------------------------------------------
 
 GravityGenerator::GravityGenerator(Vector3& gravity) : m_gravity(gravity)
 { }
 
+ForceGenerator::ForceGeneratorType GravityGenerator::GetType()
+{
+    return GRAVITY_GENERATOR;
+}
+
 void GravityGenerator::UpdateForce(RigidBody* body, float deltaTime)
 {
     if (!body->HasFiniteMass())
@@ -19,6 +30,11 @@ void GravityGenerator::UpdateForce(RigidBody* body, float deltaTime)
 DragGenerator::DragGenerator(float k1, float k2) : m_k1(k1), m_k2(k2)
 { }
 
+ForceGenerator::ForceGeneratorType DragGenerator::GetType()
+{
+    return DRAG_GENERATOR;
+}
+
 void DragGenerator::UpdateForce(RigidBody* body, float deltaTime)
 {
     Vector3 force = body->GetVelocity();
@@ -44,6 +60,11 @@ SpringGenerator::SpringGenerator(RigidBody* other,
       m_connectionPoint(connectionPoint), m_otherConnectionPoint(otherConnectionPoint)
 { }
 
+ForceGenerator::ForceGeneratorType SpringGenerator::GetType()
+{
+    return SPRING_GENERATOR;
+}
+
 void SpringGenerator::UpdateForce(RigidBody* body, float deltaTime)
 {
     // Convert connection point positions to world space
@@ -70,6 +91,11 @@ AnchoredSpringGenerator::AnchoredSpringGenerator(Vector3& anchor, float springCo
     : m_anchor(anchor), m_sprintConstant(springConstant), m_restLength(restLength)
 { }
 
+ForceGenerator::ForceGeneratorType AnchoredSpringGenerator::GetType()
+{
+    return ANCHORED_SPRING_GENERATOR;
+}
+
 void AnchoredSpringGenerator::UpdateForce(RigidBody* body, float deltaTime)
 {
     // Calculate the vector of the spring
@@ -91,6 +117,11 @@ BungeeGenerator::BungeeGenerator(RigidBody* other, float springConstant, float r
     : m_other(other), m_springConstant(springConstant), m_restLength(restLength)
 { }
 
+ForceGenerator::ForceGeneratorType BungeeGenerator::GetType()
+{
+    return BUNGEE_GENERATOR;
+}
+
 void BungeeGenerator::UpdateForce(RigidBody* body, float deltaTime)
 {
     // Calculate the vector of the spring
@@ -116,6 +147,11 @@ BuoyancyGenerator::BuoyancyGenerator(float maxDepth, float volume, float waterHe
     : m_maxDepth(maxDepth), m_volume(volume), m_waterHeight(waterHeight), m_liquidDensity(liquidDensity)
 { }
 
+ForceGenerator::ForceGeneratorType BuoyancyGenerator::GetType()
+{
+    return BUOYANCY_GENERATOR;
+}
+
 void BuoyancyGenerator::UpdateForce(RigidBody* body, float deltaTime)
 {
     // Calculate the submersion depth
@@ -143,41 +179,86 @@ void BuoyancyGenerator::UpdateForce(RigidBody* body, float deltaTime)
 
 //-----------------------------------------------------------------------------------------------
 
-void ForceRegistry::Register(RigidBody* body, ForceGenerator* generator)
+ForceRegistry::ForceRegistry() : m_firstFreeHandle(-1)
+{ }
+
+int ForceRegistry::Register(RigidBody* body, ForceGenerator* generator)
 {
-    RegistrationInfo info(body, generator);
-    m_registry.push_back(info);
+    int handle = m_firstFreeHandle;
+    if (handle >= 0)
+    {
+        m_firstFreeHandle = m_handles[handle].Index;
+    }
+    else
+    {
+        handle = m_handles.size();
+        m_handles.push_back(HandleInfo());
+    }
+
+    int type = generator->GetType();
+    m_handles[handle].Type = type;
+    m_handles[handle].Index = m_registry[type].size();
+    m_registry[type].push_back(RegistrationInfo(body, generator, handle));
+    return handle;
 }
 
-void ForceRegistry::Unregister(RigidBody* body, ForceGenerator* generator)
+void ForceRegistry::Unregister(int handle)
 {
-    RegistrationInfo info(body, generator);
-    m_registry.erase(
-        std::remove(m_registry.begin(), m_registry.end(), info),
-        m_registry.end());
+    if (handle < 0 || handle >= (int)m_handles.size() || m_handles[handle].Type < 0)
+        return;
+
+    // Move the last registration of the same type into the gap, so the array stays packed
+    vector<RegistrationInfo>& batch = m_registry[m_handles[handle].Type];
+    int index = m_handles[handle].Index;
+    batch[index] = batch.back();
+    m_handles[batch[index].Handle].Index = index;
+    batch.pop_back();
+
+    m_handles[handle].Type = -1;
+    m_handles[handle].Index = m_firstFreeHandle;
+    m_firstFreeHandle = handle;
 }
 
 void ForceRegistry::Clear()
 {
-    m_registry.clear();
+    for (int type = 0; type < ForceGenerator::NUM_FORCE_GENERATOR_TYPES; type++)
+    {
+        m_registry[type].clear();
+    }
+    m_handles.clear();
+    m_firstFreeHandle = -1;
 }
 
 void ForceRegistry::UpdateForces(float deltaTime)
 {
-    vector<RegistrationInfo>::iterator iter;
-    for (iter = m_registry.begin(); iter != m_registry.end(); iter++)
+    UpdateBatch<GravityGenerator>(m_registry[ForceGenerator::GRAVITY_GENERATOR], deltaTime);
+    UpdateBatch<DragGenerator>(m_registry[ForceGenerator::DRAG_GENERATOR], deltaTime);
+    UpdateBatch<SpringGenerator>(m_registry[ForceGenerator::SPRING_GENERATOR], deltaTime);
+    UpdateBatch<AnchoredSpringGenerator>(m_registry[ForceGenerator::ANCHORED_SPRING_GENERATOR], deltaTime);
+    UpdateBatch<BungeeGenerator>(m_registry[ForceGenerator::BUNGEE_GENERATOR], deltaTime);
+    UpdateBatch<BuoyancyGenerator>(m_registry[ForceGenerator::BUOYANCY_GENERATOR], deltaTime);
+
+    // Generator types the engine doesn't know about can only be updated through the virtual call
+    vector<RegistrationInfo>& custom = m_registry[ForceGenerator::CUSTOM_FORCE_GENERATOR];
+    for (unsigned int i = 0; i < custom.size(); i++)
     {
-        iter->Generator->UpdateForce(iter->Body, deltaTime);
+        custom[i].Generator->UpdateForce(custom[i].Body, deltaTime);
     }
 }
 
-ForceRegistry::RegistrationInfo::RegistrationInfo(RigidBody* body, ForceGenerator* generator)
+template <class GeneratorType>
+void ForceRegistry::UpdateBatch(vector<RegistrationInfo>& batch, float deltaTime)
 {
-    Body = body;
-    Generator = generator;
+    // The generator's type is known here, so the call is bound statically and can be inlined
+    for (unsigned int i = 0; i < batch.size(); i++)
+    {
+        ((GeneratorType*)batch[i].Generator)->GeneratorType::UpdateForce(batch[i].Body, deltaTime);
+    }
 }
 
-bool ForceRegistry::RegistrationInfo::operator==(const RegistrationInfo &other) const
+ForceRegistry::RegistrationInfo::RegistrationInfo(RigidBody* body, ForceGenerator* generator, int handle)
 {
-    return Body == other.Body && Generator == other.Generator;
+    Body = body;
+    Generator = generator;
+    Handle = handle;
 }
\ No newline at end of file
@@ -5,54 +5,64 @@
 #include "Physics/Collider.h"
 #include "Physics/CollisionDetection.h"
 #include "Physics/CollisionEngine.h"
+#include "Physics/ContactManifold.h"
+#include "Physics/PhysicsProfiler.h"
 #include "Physics/RigidBody.h"
 #include "Physics/RigidBodyContact.h"
 
 #include <algorithm>
 
-PhysicsEngine::PhysicsEngine() : m_contactResolver(MAX_RESOLUTION_ITERATIONS)
+PhysicsEngine::PhysicsEngine() : m_contactResolver(MAX_RESOLUTION_ITERATIONS), m_sequentialImpulseSolver(SEQUENTIAL_IMPULSE_ITERATIONS), m_useSequentialImpulse(false)
 {
+    m_rigiBodyContacts.reserve(INITIAL_CONTACT_CAPACITY);
 }
 
 void PhysicsEngine::Startup()
 {
-    float gravityAmt = GameProject::Singleton().GetPhysicsSettings().Gravity;
-    m_gravityGenerator = new GravityGenerator(Vector3(0.0f, gravityAmt, 0.0f));
+    GameProject::PhysicsSettings& settings = GameProject::Singleton().GetPhysicsSettings();
+    m_gravity = Vector3(0.0f, settings.Gravity, 0.0f);
+
+    m_useSequentialImpulse = (settings.ContactSolver == GameProject::CONTACT_SOLVER_SEQUENTIAL_IMPULSE);
+    m_sequentialImpulseSolver.SetIterations(settings.SolverIterations > 0 ? settings.SolverIterations : SEQUENTIAL_IMPULSE_ITERATIONS);
 }
 
 void PhysicsEngine::Shutdown()
 {
-    delete m_gravityGenerator;
+    m_forceRegistry.Clear();
 }
 
 void PhysicsEngine::UpdateBodies(float deltaTime)
 {
+    PhysicsProfiler& profiler = PhysicsProfiler::Singleton();
+
     // First, apply force generators
+    PhysicsClock::time_point phaseStart = PhysicsClock::now();
     m_forceRegistry.UpdateForces(deltaTime);
+    profiler.AddPhaseTime(PHYSICS_PHASE_FORCES, phaseStart);
 
-    // Second, integrate all rigid bodies
-    vector<RigidBody*>::iterator iter;
-    for (iter = m_rigidBodies.begin(); iter != m_rigidBodies.end(); iter++)
-    {
-        (*iter)->Integrate(deltaTime);
-    }
+    // Second, integrate all registered rigid bodies, adding gravity to those that use it
+    phaseStart = PhysicsClock::now();
+    m_rigidBodyPool.Integrate(deltaTime, m_gravity);
+    profiler.AddPhaseTime(PHYSICS_PHASE_INTEGRATE, phaseStart);
 }
 
 void PhysicsEngine::ResolveCollisions(float deltaTime)
 {
+    PhysicsProfiler& profiler = PhysicsProfiler::Singleton();
+    PhysicsStepStats& stats = profiler.GetCurrentStep();
+    PhysicsClock::time_point phaseStart = PhysicsClock::now();
+
     // Get all collision data from collision engine
     const CollisionData* collisionData = CollisionEngine::Singleton().GetCollisionData();
 
     // Determine which collisions involve objects with rigid bodies
-    int contactCount = 0;
+    unsigned int contactCount = 0;
+    unsigned int truncated = 0;
     for (int i = 0; i < collisionData->ContactsUsed; i++)
     {
-        if (contactCount >= MAX_RIGID_BODY_CONTACTS)
-            break;
-
-        CollisionContact collisionContact = collisionData->Contacts[i];
-        GameObjectBase* objectA = collisionContact.ColliderA->GetGameObject();
-        GameObjectBase* objectB = collisionContact.ColliderB->GetGameObject();
+        const CollisionContact& collisionContact = collisionData->Contacts[i];
+        GameObjectBase* objectA = collisionContact.ColliderA->GetBodyObject();
+        GameObjectBase* objectB = collisionContact.ColliderB->GetBodyObject();
         RigidBody* rigidBodyA = objectA->GetRigidBody();
         RigidBody* rigidBodyB = objectB->GetRigidBody();
 
@@ -62,32 +72,132 @@ void PhysicsEngine::ResolveCollisions(float deltaTime)
             continue;
         }
 
+        if (contactCount >= MAX_RIGID_BODY_CONTACTS)
+        {
+            truncated++;
+            continue;
+        }
+
+        // The buffer is never shrunk, so it only allocates when a frame has more contacts than any before it
+        if (contactCount == m_rigiBodyContacts.size())
+        {
+            m_rigiBodyContacts.push_back(RigidBodyContact());
+        }
+
         // Create a rigid body contact, since there is at least one rigid body involved
         // One of the bodies might be NULL, but RigidBodyContact will handle this case
-        m_rigiBodyContacts[contactCount].Body[0] = rigidBodyA;
-        m_rigiBodyContacts[contactCount].Body[1] = rigidBodyB;
-        m_rigiBodyContacts[contactCount].ContactPoint = collisionContact.ContactPoint;
-        m_rigiBodyContacts[contactCount].ContactNormal = collisionContact.ContactNormal;
-        m_rigiBodyContacts[contactCount].Penetration = collisionContact.Penetration;
-        m_rigiBodyContacts[contactCount].Friction = 0.9f;       // TODO custom friction values
-        m_rigiBodyContacts[contactCount].Restitution = 0.1f;    // TODO custom restitution values
+        RigidBodyContact& contact = m_rigiBodyContacts[contactCount];
+        contact.Body[0] = rigidBodyA;
+        contact.Body[1] = rigidBodyB;
+        contact.ContactPoint = collisionContact.ContactPoint;
+        contact.ContactNormal = collisionContact.ContactNormal;
+        contact.Penetration = collisionContact.Penetration;
+        contact.Friction = 0.9f;       // TODO custom friction values
+        contact.Restitution = 0.1f;    // TODO custom restitution values
+        contact.CachedPoint = collisionContact.CachedPoint;
+
+        // The worst-first resolver doesn't warm start, so its points only total up this step's impulses
+        if (!m_useSequentialImpulse && contact.CachedPoint != NULL)
+        {
+            contact.CachedPoint->NormalImpulse = 0.0f;
+            contact.CachedPoint->TangentImpulse = Vector3::Zero;
+        }
         contactCount++;
     }
+    m_rigidBodyContactStats.Record(contactCount, truncated);
+
+    // Group the bodies into islands of touching bodies. Contacts in one island can't affect another island,
+    // so each island is resolved on its own, with an iteration budget that depends on its size.
+    RigidBodyContact* contacts = contactCount > 0 ? &m_rigiBodyContacts[0] : NULL;
+    m_contactIslands.Build(m_rigidBodies, contacts, contactCount);
+    stats.RigidBodyContacts += contactCount;
+    stats.Islands += m_contactIslands.GetIslandCount();
+    profiler.AddPhaseTime(PHYSICS_PHASE_ISLANDS, phaseStart);
 
-    //printf("Contact count: %d\n", contactCount);
-    // Resolve the collisions involving rigid bodies
-    if (contactCount > 0)
+    phaseStart = PhysicsClock::now();
+    for (unsigned int i = 0; i < m_contactIslands.GetIslandCount(); i++)
     {
-        //printf("Contact count: %d\n", contactCount);
-        m_contactResolver.ResolveContacts(m_rigiBodyContacts, contactCount, deltaTime);
+        const ContactIslands::Island& island = m_contactIslands.GetIsland(i);
+        if (island.ContactCount > 0 && !IsIslandAsleep(island))
+        {
+            if (m_useSequentialImpulse)
+            {
+                m_sequentialImpulseSolver.ResolveContacts(m_contactIslands.GetContacts(island), island.ContactCount, deltaTime);
+                stats.PositionIterations += m_sequentialImpulseSolver.GetPositionIterationsUsed();
+                stats.VelocityIterations += m_sequentialImpulseSolver.GetVelocityIterationsUsed();
+            }
+            else
+            {
+                unsigned int iterations = island.ContactCount * RESOLUTION_ITERATIONS_PER_CONTACT;
+                m_contactResolver.SetMaxIterations(iterations < MAX_RESOLUTION_ITERATIONS ? iterations : MAX_RESOLUTION_ITERATIONS);
+                m_contactResolver.ResolveContacts(m_contactIslands.GetContacts(island), island.ContactCount, deltaTime);
+                stats.PositionIterations += m_contactResolver.GetPositionIterationsUsed();
+                stats.VelocityIterations += m_contactResolver.GetVelocityIterationsUsed();
+                if (m_contactResolver.HitIterationLimit())
+                {
+                    stats.IterationLimitHits++;
+                }
+            }
+            stats.SolvedIslands++;
+        }
+
+        UpdateIslandSleepState(island);
     }
+    profiler.AddPhaseTime(PHYSICS_PHASE_SOLVER, phaseStart);
 
     // TODO this shouldn't go here
-    // Update gameobject transforms to match rigidbody positions/rotations
+    // Update gameobject transforms to match rigidbody positions/rotations, since colliders read them
+    phaseStart = PhysicsClock::now();
+    for (unsigned int i = 0; i < m_rigidBodies.size(); i++)
+    {
+        m_rigidBodies[i]->UpdateGameObject();
+        if (m_rigidBodies[i]->IsAwake())
+            stats.AwakeBodies++;
+        else
+            stats.AsleepBodies++;
+    }
+    profiler.AddPhaseTime(PHYSICS_PHASE_SYNC, phaseStart);
+}
+
+void PhysicsEngine::UpdateGameObjects(float interpolation)
+{
     vector<RigidBody*>::iterator iter;
     for (iter = m_rigidBodies.begin(); iter != m_rigidBodies.end(); iter++)
     {
-        (*iter)->UpdateGameObject();
+        (*iter)->UpdateGameObject(interpolation);
+    }
+}
+
+bool PhysicsEngine::IsIslandAsleep(const ContactIslands::Island& island)
+{
+    // Contacts between sleeping bodies don't need resolving. An island with no bodies holds contacts whose
+    // bodies aren't registered, which are always resolved.
+    if (island.BodyCount == 0)
+        return false;
+
+    RigidBody** bodies = m_contactIslands.GetBodies(island);
+    for (unsigned int i = 0; i < island.BodyCount; i++)
+    {
+        if (bodies[i]->IsAwake() && bodies[i]->HasFiniteMass())
+            return false;
+    }
+    return true;
+}
+
+void PhysicsEngine::UpdateIslandSleepState(const ContactIslands::Island& island)
+{
+    // An island only goes to sleep once all of its bodies have settled, otherwise a body could fall
+    // asleep while something is still pushing on it
+    RigidBody** bodies = m_contactIslands.GetBodies(island);
+    for (unsigned int i = 0; i < island.BodyCount; i++)
+    {
+        if (bodies[i]->IsAwake() && !bodies[i]->IsBelowSleepThreshold())
+            return;
+    }
+
+    for (unsigned int i = 0; i < island.BodyCount; i++)
+    {
+        bodies[i]->SetAwake(false);
     }
 }
 
@@ -106,26 +216,48 @@ void PhysicsEngine::RegisterRigidBody(RigidBody* rigidBody)
     }
 
     m_rigidBodies.push_back(rigidBody);
+    m_rigidBodyPool.SetScalar(rigidBody->GetPoolIndex(), RigidBodyPool::SIMULATED, 1.0f);
 }
 
 void PhysicsEngine::UnregisterRigidBody(RigidBody* rigidBody)
 {
+    vector<RigidBody*>::iterator iter;
+    iter = std::find(m_rigidBodies.begin(), m_rigidBodies.end(), rigidBody);
+    if (iter == m_rigidBodies.end())
+        return;
+
+    m_rigidBodyPool.SetScalar(rigidBody->GetPoolIndex(), RigidBodyPool::SIMULATED, 0.0f);
     m_rigidBodies.erase(
         std::remove(m_rigidBodies.begin(), m_rigidBodies.end(), rigidBody),
         m_rigidBodies.end());
 }
 
-void PhysicsEngine::RegisterForce(RigidBody* rigidBody, ForceGenerator* forceGenerator)
+int PhysicsEngine::RegisterForce(RigidBody* rigidBody, ForceGenerator* forceGenerator)
+{
+    return m_forceRegistry.Register(rigidBody, forceGenerator);
+}
+
+void PhysicsEngine::UnregisterForce(int handle)
+{
+    m_forceRegistry.Unregister(handle);
+}
+
+Vector3 PhysicsEngine::GetGravity()
+{
+    return m_gravity;
+}
+
+void PhysicsEngine::SetGravity(Vector3& gravity)
 {
-    m_forceRegistry.Register(rigidBody, forceGenerator);
+    m_gravity = gravity;
 }
 
-void PhysicsEngine::UnregisterForce(RigidBody* rigidBody, ForceGenerator* forceGenerator)
+RigidBodyPool& PhysicsEngine::GetRigidBodyPool()
 {
-    m_forceRegistry.Unregister(rigidBody, forceGenerator);
+    return m_rigidBodyPool;
 }
 
-GravityGenerator* PhysicsEngine::GetGravityGenerator()
+const ContactBufferStats& PhysicsEngine::GetRigidBodyContactStats()
 {
-    return m_gravityGenerator;
+    return m_rigidBodyContactStats;
 }
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "Physics/PhysicsProfiler.h"
+
+#include <string.h>
+
+namespace
+{
+    const char* PHASE_NAMES[NUM_PHYSICS_PHASES] =
+    {
+        "forces", "integrate", "broad-phase", "narrow-phase", "manifolds", "islands", "solver", "sync", "events"
+    };
+
+    const char* COLLIDER_TYPE_NAMES[Collider::NUM_COLLIDER_TYPES] = { "sphere", "box", "capsule", "mesh", "compound" };
+}
+
+PhysicsStepStats::PhysicsStepStats()
+{
+    Reset();
+}
+
+void PhysicsStepStats::Reset()
+{
+    Step = 0;
+    BroadPhasePairs = 0;
+    memset(NarrowPhaseTests, 0, sizeof(NarrowPhaseTests));
+    Contacts = 0;
+    TriggerOverlaps = 0;
+    RigidBodyContacts = 0;
+    Islands = 0;
+    SolvedIslands = 0;
+    PositionIterations = 0;
+    VelocityIterations = 0;
+    IterationLimitHits = 0;
+    AwakeBodies = 0;
+    AsleepBodies = 0;
+    for (int i = 0; i < NUM_PHYSICS_PHASES; i++)
+    {
+        PhaseSeconds[i] = 0;
+    }
+}
+
+void PhysicsStepStats::Add(const PhysicsStepStats& other)
+{
+    BroadPhasePairs += other.BroadPhasePairs;
+    for (int a = 0; a < Collider::NUM_COLLIDER_TYPES; a++)
+    {
+        for (int b = 0; b < Collider::NUM_COLLIDER_TYPES; b++)
+        {
+            NarrowPhaseTests[a][b] += other.NarrowPhaseTests[a][b];
+        }
+    }
+    Contacts += other.Contacts;
+    TriggerOverlaps += other.TriggerOverlaps;
+    RigidBodyContacts += other.RigidBodyContacts;
+    Islands += other.Islands;
+    SolvedIslands += other.SolvedIslands;
+    PositionIterations += other.PositionIterations;
+    VelocityIterations += other.VelocityIterations;
+    IterationLimitHits += other.IterationLimitHits;
+    AwakeBodies += other.AwakeBodies;
+    AsleepBodies += other.AsleepBodies;
+    for (int i = 0; i < NUM_PHYSICS_PHASES; i++)
+    {
+        PhaseSeconds[i] += other.PhaseSeconds[i];
+    }
+}
+
+unsigned int PhysicsStepStats::GetNarrowPhaseTests() const
+{
+    unsigned int tests = 0;
+    for (int a = 0; a < Collider::NUM_COLLIDER_TYPES; a++)
+    {
+        for (int b = 0; b < Collider::NUM_COLLIDER_TYPES; b++)
+        {
+            tests += NarrowPhaseTests[a][b];
+        }
+    }
+    return tests;
+}
+
+unsigned int PhysicsStepStats::GetNarrowPhaseTests(Collider::ColliderType a, Collider::ColliderType b) const
+{
+    return a <= b ? NarrowPhaseTests[a][b] : NarrowPhaseTests[b][a];
+}
+
+double PhysicsStepStats::GetTotalSeconds() const
+{
+    double seconds = 0;
+    for (int i = 0; i < NUM_PHYSICS_PHASES; i++)
+    {
+        seconds += PhaseSeconds[i];
+    }
+    return seconds;
+}
+
+PhysicsProfiler::PhysicsProfiler()
+    : m_historyNext(0), m_step(0), m_dumpFile(NULL), m_dumpFormat(DUMP_CSV), m_dumpInterval(1)
+{
+    m_history.reserve(PHYSICS_PROFILER_HISTORY);
+}
+
+const char* PhysicsProfiler::GetPhaseName(PhysicsPhase phase)
+{
+    return phase < NUM_PHYSICS_PHASES ? PHASE_NAMES[phase] : "unknown";
+}
+
+void PhysicsProfiler::BeginStep()
+{
+    m_current.Reset();
+    m_current.Step = m_step;
+}
+
+void PhysicsProfiler::EndStep()
+{
+    if (m_history.size() < PHYSICS_PROFILER_HISTORY)
+    {
+        m_history.push_back(m_current);
+    }
+    else
+    {
+        m_history[m_historyNext] = m_current;
+    }
+    m_historyNext = (m_historyNext + 1) % PHYSICS_PROFILER_HISTORY;
+
+    if (m_dumpFile != NULL && m_step % m_dumpInterval == 0)
+    {
+        WriteDumpRow(m_current);
+    }
+    m_step++;
+}
+
+PhysicsStepStats& PhysicsProfiler::GetCurrentStep()
+{
+    return m_current;
+}
+
+void PhysicsProfiler::AddPhaseTime(PhysicsPhase phase, PhysicsClock::time_point start)
+{
+    m_current.PhaseSeconds[phase] += std::chrono::duration<double>(PhysicsClock::now() - start).count();
+}
+
+const PhysicsStepStats& PhysicsProfiler::GetLastStep()
+{
+    if (m_history.empty())
+        return m_current;
+
+    return m_history[(m_historyNext + PHYSICS_PROFILER_HISTORY - 1) % PHYSICS_PROFILER_HISTORY];
+}
+
+unsigned int PhysicsProfiler::GetHistorySize()
+{
+    return m_history.size();
+}
+
+const PhysicsStepStats& PhysicsProfiler::GetHistory(unsigned int index)
+{
+    // Until the ring buffer fills up, the oldest step is at the start
+    if (m_history.size() < PHYSICS_PROFILER_HISTORY)
+        return m_history[index];
+
+    return m_history[(m_historyNext + index) % PHYSICS_PROFILER_HISTORY];
+}
+
+unsigned int PhysicsProfiler::GetHistoryTotals(PhysicsStepStats& totals)
+{
+    totals.Reset();
+    for (unsigned int i = 0; i < m_history.size(); i++)
+    {
+        totals.Add(m_history[i]);
+    }
+    return m_history.size();
+}
+
+bool PhysicsProfiler::StartDump(string path, DumpFormat format, unsigned int stepInterval)
+{
+    StopDump();
+
+    m_dumpFile = fopen(path.c_str(), "w");
+    if (m_dumpFile == NULL)
+    {
+        printf("Error: could not open %s for writing physics stats.\n", path.c_str());
+        return false;
+    }
+
+    m_dumpFormat = format;
+    m_dumpInterval = stepInterval > 0 ? stepInterval : 1;
+    WriteDumpHeader();
+    return true;
+}
+
+void PhysicsProfiler::StopDump()
+{
+    if (m_dumpFile != NULL)
+    {
+        fclose(m_dumpFile);
+        m_dumpFile = NULL;
+    }
+}
+
+void PhysicsProfiler::WriteDumpHeader()
+{
+    // JSON lines name every field in every row, so only CSV needs a header
+    if (m_dumpFormat != DUMP_CSV)
+        return;
+
+    fprintf(m_dumpFile, "step,broad-phase-pairs,narrow-phase-tests");
+    for (int a = 0; a < Collider::NUM_COLLIDER_TYPES; a++)
+    {
+        for (int b = a; b < Collider::NUM_COLLIDER_TYPES; b++)
+        {
+            fprintf(m_dumpFile, ",tests-%s-%s", COLLIDER_TYPE_NAMES[a], COLLIDER_TYPE_NAMES[b]);
+        }
+    }
+    fprintf(m_dumpFile, ",contacts,trigger-overlaps,rigid-body-contacts,islands,solved-islands,position-iterations,velocity-iterations,iteration-limit-hits,awake-bodies,asleep-bodies");
+    for (int i = 0; i < NUM_PHYSICS_PHASES; i++)
+    {
+        fprintf(m_dumpFile, ",%s-ms", PHASE_NAMES[i]);
+    }
+    fprintf(m_dumpFile, ",total-ms\n");
+    fflush(m_dumpFile);
+}
+
+void PhysicsProfiler::WriteDumpRow(const PhysicsStepStats& stats)
+{
+    if (m_dumpFormat == DUMP_CSV)
+    {
+        fprintf(m_dumpFile, "%u,%u,%u", stats.Step, stats.BroadPhasePairs, stats.GetNarrowPhaseTests());
+        for (int a = 0; a < Collider::NUM_COLLIDER_TYPES; a++)
+        {
+            for (int b = a; b < Collider::NUM_COLLIDER_TYPES; b++)
+            {
+                fprintf(m_dumpFile, ",%u", stats.NarrowPhaseTests[a][b]);
+            }
+        }
+        fprintf(m_dumpFile, ",%u,%u,%u,%u,%u,%u,%u,%u,%u,%u", stats.Contacts, stats.TriggerOverlaps, stats.RigidBodyContacts, stats.Islands, stats.SolvedIslands,
+            stats.PositionIterations, stats.VelocityIterations, stats.IterationLimitHits, stats.AwakeBodies, stats.AsleepBodies);
+        for (int i = 0; i < NUM_PHYSICS_PHASES; i++)
+        {
+            fprintf(m_dumpFile, ",%f", 1000.0 * stats.PhaseSeconds[i]);
+        }
+        fprintf(m_dumpFile, ",%f\n", 1000.0 * stats.GetTotalSeconds());
+    }
+    else
+    {
+        fprintf(m_dumpFile, "{\"step\": %u, \"broad-phase-pairs\": %u, \"narrow-phase-tests\": {", stats.Step, stats.BroadPhasePairs);
+        bool first = true;
+        for (int a = 0; a < Collider::NUM_COLLIDER_TYPES; a++)
+        {
+            for (int b = a; b < Collider::NUM_COLLIDER_TYPES; b++)
+            {
+                fprintf(m_dumpFile, "%s\"%s-%s\": %u", first ? "" : ", ", COLLIDER_TYPE_NAMES[a], COLLIDER_TYPE_NAMES[b], stats.NarrowPhaseTests[a][b]);
+                first = false;
+            }
+        }
+        fprintf(m_dumpFile, "}, \"contacts\": %u, \"trigger-overlaps\": %u, \"rigid-body-contacts\": %u, \"islands\": %u, \"solved-islands\": %u",
+            stats.Contacts, stats.TriggerOverlaps, stats.RigidBodyContacts, stats.Islands, stats.SolvedIslands);
+        fprintf(m_dumpFile, ", \"position-iterations\": %u, \"velocity-iterations\": %u, \"iteration-limit-hits\": %u", stats.PositionIterations,
+            stats.VelocityIterations, stats.IterationLimitHits);
+        fprintf(m_dumpFile, ", \"awake-bodies\": %u, \"asleep-bodies\": %u, \"ms\": {", stats.AwakeBodies, stats.AsleepBodies);
+        for (int i = 0; i < NUM_PHYSICS_PHASES; i++)
+        {
+            fprintf(m_dumpFile, "\"%s\": %f, ", PHASE_NAMES[i], 1000.0 * stats.PhaseSeconds[i]);
+        }
+        fprintf(m_dumpFile, "\"total\": %f}}\n", 1000.0 * stats.GetTotalSeconds());
+    }
+    fflush(m_dumpFile);
+}
\ No newline at end of file
@@ -0,0 +1,417 @@
+#include "Physics/PhysicsQuery.h"
+
+#include "Physics/BoundingBox.h"
+#include "Physics/BroadPhase.h"
+#include "Physics/CollisionDetection.h"
+#include "Physics/CollisionEngine.h"
+#include "Physics/StaticBVH.h"
+#include "Physics/TriangleBVH.h"
+
+#include <algorithm>
+#include <float.h>
+
+namespace
+{
+    // Ray against a sphere, for rays that start outside of it
+    bool RayAndSphere(const Vector3& origin, const Vector3& direction, const Vector3& center, float radius, float maxDistance, float& distance)
+    {
+        Vector3 offset = origin - center;
+        float b = offset.Dot(direction);
+        float c = offset.MagnitudeSqrd() - radius * radius;
+        if (c <= 0.0f || b > 0.0f)
+            return false;
+
+        float discriminant = b * b - c;
+        if (discriminant < 0.0f)
+            return false;
+
+        distance = -b - sqrtf(discriminant);
+        return distance <= maxDistance;
+    }
+
+    // Ray against the side of a cylinder around the segment from start to end, for rays that start outside of it
+    bool RayAndCylinder(const Vector3& origin, const Vector3& direction, const Vector3& start, const Vector3& end, float radius, float maxDistance, float& distance)
+    {
+        Vector3 axis = end - start;
+        float axisLengthSqrd = axis.MagnitudeSqrd();
+        if (axisLengthSqrd <= 0.0f)
+            return false;
+
+        // Solve for where the ray's distance from the axis reaches the radius, ignoring movement along the axis
+        Vector3 offset = origin - start;
+        float axisDotDirection = axis.Dot(direction);
+        float axisDotOffset = axis.Dot(offset);
+        Vector3 perpendicularDirection = direction - axis * (axisDotDirection / axisLengthSqrd);
+        Vector3 perpendicularOffset = offset - axis * (axisDotOffset / axisLengthSqrd);
+
+        float a = perpendicularDirection.MagnitudeSqrd();
+        float b = perpendicularOffset.Dot(perpendicularDirection);
+        float c = perpendicularOffset.MagnitudeSqrd() - radius * radius;
+        if (c <= 0.0f || b > 0.0f || a < 1e-12f)
+            return false;
+
+        float discriminant = b * b - a * c;
+        if (discriminant < 0.0f)
+            return false;
+
+        float t = (-b - sqrtf(discriminant)) / a;
+        if (t > maxDistance)
+            return false;
+
+        // Past the ends of the segment, the sphere around the end vertex is hit instead
+        float s = (axisDotOffset + t * axisDotDirection) / axisLengthSqrd;
+        if (s < 0.0f || s > 1.0f)
+            return false;
+
+        distance = t;
+        return true;
+    }
+
+    bool PointInTriangle(const Vector3& point, const Vector3* triangle)
+    {
+        Vector3 normal = (triangle[1] - triangle[0]).Cross(triangle[2] - triangle[0]);
+        return (triangle[1] - triangle[0]).Cross(point - triangle[0]).Dot(normal) >= 0.0f
+            && (triangle[2] - triangle[1]).Cross(point - triangle[1]).Dot(normal) >= 0.0f
+            && (triangle[0] - triangle[2]).Cross(point - triangle[2]).Dot(normal) >= 0.0f;
+    }
+
+    // Sweeps a sphere against a world space triangle, finding the distance and point of first contact
+    bool SphereCastTriangle(const Vector3& origin, const Vector3& direction, float radius, const Vector3* triangle, float maxDistance, float& distance, Vector3& point)
+    {
+        Vector3 normal = (triangle[1] - triangle[0]).Cross(triangle[2] - triangle[0]);
+        if (normal.MagnitudeSqrd() <= 0.0f)
+            return false;
+        normal.Normalize();
+
+        float height = normal.Dot(origin - triangle[0]);
+        if (height < 0.0f)
+        {
+            normal = normal * -1.0f;
+            height = -height;
+        }
+
+        // If the sphere first touches the plane inside the triangle, nothing else on the triangle can be touched earlier
+        float approachSpeed = -normal.Dot(direction);
+        if (height > radius && approachSpeed > 0.0f)
+        {
+            float t = (height - radius) / approachSpeed;
+            Vector3 touch = origin + direction * t - normal * radius;
+            if (t <= maxDistance && PointInTriangle(touch, triangle))
+            {
+                distance = t;
+                point = touch;
+                return true;
+            }
+        }
+
+        // Otherwise the sphere touches an edge or a vertex first
+        bool hit = false;
+        for (int i = 0; i < 3; i++)
+        {
+            const Vector3& start = triangle[i];
+            const Vector3& end = triangle[(i + 1) % 3];
+            float t;
+            if (RayAndCylinder(origin, direction, start, end, radius, maxDistance, t))
+            {
+                Vector3 edge = end - start;
+                Vector3 center = origin + direction * t;
+                maxDistance = t;
+                distance = t;
+                point = start + edge * ((center - start).Dot(edge) / edge.MagnitudeSqrd());
+                hit = true;
+            }
+            if (RayAndSphere(origin, direction, start, radius, maxDistance, t))
+            {
+                maxDistance = t;
+                distance = t;
+                point = start;
+                hit = true;
+            }
+        }
+        return hit;
+    }
+
+    bool CastAgainstSphere(SphereCollider* sphere, const Vector3& origin, const Vector3& direction, float radius, float maxDistance, RaycastHit& hit)
+    {
+        Vector3 center = sphere->GetWorldPosition();
+        float sphereRadius = sphere->GetWorldspaceBoundingRadius();
+        float distance;
+        if (!RayAndSphere(origin, direction, center, sphereRadius + radius, maxDistance, distance))
+            return false;
+
+        hit.Distance = distance;
+        hit.Normal = (origin + direction * distance - center).Normalized();
+        hit.Point = center + hit.Normal * sphereRadius;
+        return true;
+    }
+
+    bool CastAgainstBox(BoxCollider* box, const Vector3& origin, const Vector3& direction, float radius, float maxDistance, RaycastHit& hit)
+    {
+        // Slab test in the box's frame, with the box grown by the cast radius (so its corners are treated as sharp)
+        Vector3 halfSize = box->GetWorldScaleHalfsize();
+        Vector3 offset = origin - box->GetWorldPosition();
+        float entry = -FLT_MAX;
+        float exit = maxDistance;
+        Vector3 entryNormal;
+
+        for (int i = 0; i < 3; i++)
+        {
+            Vector3& axis = box->GetTransform().GetAxis(i);
+            float position = axis.Dot(offset);
+            float speed = axis.Dot(direction);
+            float extent = halfSize[i] + radius;
+
+            if (fabsf(speed) < 1e-8f)
+            {
+                if (fabsf(position) > extent)
+                    return false;
+                continue;
+            }
+
+            float slabEntry = (-extent - position) / speed;
+            float slabExit = (extent - position) / speed;
+            if (slabEntry > slabExit)
+                std::swap(slabEntry, slabExit);
+            if (slabEntry > entry)
+            {
+                entry = slabEntry;
+                entryNormal = speed > 0.0f ? axis * -1.0f : axis;
+            }
+            if (slabExit < exit)
+                exit = slabExit;
+            if (entry > exit)
+                return false;
+        }
+
+        // A negative entry means the ray starts inside the box, or the box is behind it
+        if (entry < 0.0f)
+            return false;
+
+        hit.Distance = entry;
+        hit.Normal = entryNormal;
+        hit.Point = origin + direction * entry - entryNormal * radius;
+        return true;
+    }
+
+    bool CastAgainstMesh(MeshCollider* mesh, const Vector3& origin, const Vector3& direction, float radius, float maxDistance, vector<int>& candidates, RaycastHit& hit)
+    {
+        TriangleBVH* bvh = mesh->GetTriangleBVH();
+        if (bvh == NULL)
+            return false;
+
+        // Distances along the ray are the same in model space, since the direction is transformed without normalizing
+        Transform& transform = mesh->GetTransform();
+        Vector3 localOrigin = transform.InverseTransformPoint(origin);
+        Vector3 localDirection = transform.InverseTransformVector(direction);
+        Vector3 triangle[3];
+
+        if (radius <= 0.0f)
+        {
+            float distance;
+            int triangleIndex;
+            if (!bvh->Raycast(localOrigin, localDirection, maxDistance, distance, triangleIndex))
+                return false;
+
+            bvh->GetTriangle(triangleIndex, triangle);
+            for (int i = 0; i < 3; i++)
+            {
+                triangle[i] = transform.TransformPoint(triangle[i]);
+            }
+            Vector3 normal = (triangle[1] - triangle[0]).Cross(triangle[2] - triangle[0]).Normalized();
+
+            hit.Distance = distance;
+            hit.Normal = normal.Dot(direction) > 0.0f ? normal * -1.0f : normal;
+            hit.Point = origin + direction * distance;
+            return true;
+        }
+
+        // The radius shrinks by the smallest scale at most when it's taken into model space
+        Vector3& scale = transform.GetWorldScale();
+        float minScale = fminf(fabsf(scale.x()), fminf(fabsf(scale.y()), fabsf(scale.z())));
+        if (minScale <= 0.0f)
+            return false;
+
+        candidates.clear();
+        bvh->QueryRay(localOrigin, localDirection, maxDistance, radius / minScale, candidates);
+
+        bool hasHit = false;
+        for (unsigned int i = 0; i < candidates.size(); i++)
+        {
+            bvh->GetTriangle(candidates[i], triangle);
+            for (int j = 0; j < 3; j++)
+            {
+                triangle[j] = transform.TransformPoint(triangle[j]);
+            }
+
+            float distance;
+            Vector3 point;
+            if (SphereCastTriangle(origin, direction, radius, triangle, maxDistance, distance, point))
+            {
+                maxDistance = distance;
+                hit.Distance = distance;
+                hit.Point = point;
+                hit.Normal = (origin + direction * distance - point).Normalized();
+                hasHit = true;
+            }
+        }
+        return hasHit;
+    }
+
+    // Holds the state of a ray or sphere cast, and tests the colliders the acceleration structures find
+    class CastQuery : public BroadPhaseRayCallback
+    {
+    public:
+        CastQuery(const Vector3& origin, const Vector3& direction, float radius, unsigned int layerMask)
+            : Origin(origin), Direction(direction), Radius(radius), LayerMask(layerMask), HasHit(false)
+        {}
+
+        virtual float RayTest(Collider* collider, float maxDistance)
+        {
+            if ((collider->GetLayerMask() & LayerMask) == 0)
+                return maxDistance;
+
+            RaycastHit result;
+            if (!CastAgainstCollider(collider, maxDistance, result) || result.Distance > maxDistance)
+                return maxDistance;
+
+            result.HitCollider = collider;
+            Hit = result;
+            HasHit = true;
+            return result.Distance;
+        }
+
+        bool CastAgainstCollider(Collider* collider, float maxDistance, RaycastHit& result)
+        {
+            switch (collider->GetType())
+            {
+            case Collider::SPHERE_COLLIDER:
+                return CastAgainstSphere((SphereCollider*)collider, Origin, Direction, Radius, maxDistance, result);
+            case Collider::BOX_COLLIDER:
+                return CastAgainstBox((BoxCollider*)collider, Origin, Direction, Radius, maxDistance, result);
+            case Collider::MESH_COLLIDER:
+                return CastAgainstMesh((MeshCollider*)collider, Origin, Direction, Radius, maxDistance, Triangles, result);
+            case Collider::COMPOUND_COLLIDER:
+            {
+                // Hits on the children count as hits on the compound. Compounds don't nest, so the list isn't shared.
+                CompoundCollider* compound = (CompoundCollider*)collider;
+                Children.clear();
+                compound->QueryChildrenRay(Origin, Direction, maxDistance, Radius, Children);
+
+                bool hasHit = false;
+                for (unsigned int i = 0; i < Children.size(); i++)
+                {
+                    RaycastHit childResult;
+                    if (CastAgainstCollider(compound->GetChild(Children[i]), maxDistance, childResult) && childResult.Distance <= maxDistance)
+                    {
+                        maxDistance = childResult.Distance;
+                        result = childResult;
+                        hasHit = true;
+                    }
+                }
+                return hasHit;
+            }
+            default:
+                // The narrow phase has no capsule tests yet, so casts skip them as well
+                return false;
+            }
+        }
+
+        Vector3         Origin;
+        Vector3         Direction;
+        float           Radius;
+        unsigned int    LayerMask;
+
+        RaycastHit      Hit;
+        bool            HasHit;
+        vector<int>     Triangles;
+        vector<int>     Children;
+    };
+
+    bool Cast(const Vector3& origin, float radius, Vector3 direction, float maxDistance, RaycastHit& hit, unsigned int layerMask)
+    {
+        if (direction.MagnitudeSqrd() <= 0.0f || maxDistance <= 0.0f)
+            return false;
+        direction.Normalize();
+
+        CastQuery query(origin, direction, radius, layerMask);
+
+        maxDistance = CollisionEngine::Singleton().GetStaticHierarchy()->QueryRay(origin, direction, maxDistance, radius, &query);
+
+        CollisionEngine::Singleton().GetBroadPhase()->QueryRay(origin, direction, maxDistance, radius, &query);
+
+        if (query.HasHit)
+            hit = query.Hit;
+        return query.HasHit;
+    }
+}
+
+RaycastHit::RaycastHit()
+    : HitCollider(NULL), Point(Vector3::Zero), Normal(Vector3::Zero), Distance(FLT_MAX)
+{
+}
+
+PhysicsQuery::PhysicsQuery()
+    : m_querySphere(NULL)
+{
+}
+
+bool PhysicsQuery::Raycast(Vector3 origin, Vector3 direction, float maxDistance, RaycastHit& hit, unsigned int layerMask)
+{
+    return Cast(origin, 0.0f, direction, maxDistance, hit, layerMask);
+}
+
+bool PhysicsQuery::SphereCast(Vector3 origin, float radius, Vector3 direction, float maxDistance, RaycastHit& hit, unsigned int layerMask)
+{
+    return Cast(origin, radius, direction, maxDistance, hit, layerMask);
+}
+
+unsigned int PhysicsQuery::OverlapSphere(Vector3 center, float radius, vector<Collider*>& results, unsigned int layerMask)
+{
+    m_querySphere.GetTransform().SetWorldPosition(center);
+    m_querySphere.SetLocalRadius(radius);
+    m_candidates.clear();
+
+    Vector3 extents(radius, radius, radius);
+    BoundingBox box(center - extents, center + extents);
+    CollisionEngine::Singleton().GetStaticHierarchy()->QueryBox(box, m_candidates);
+    CollisionEngine::Singleton().GetBroadPhase()->QueryBox(box, m_candidates);
+
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < m_candidates.size(); i++)
+    {
+        Collider* collider = m_candidates[i];
+        if ((collider->GetLayerMask() & layerMask) != 0 && OverlapsCollider(collider))
+        {
+            results.push_back(collider);
+            count++;
+        }
+    }
+    return count;
+}
+
+bool PhysicsQuery::OverlapsCollider(Collider* collider)
+{
+    switch (collider->GetType())
+    {
+    case Collider::SPHERE_COLLIDER:
+        return CollisionDetection::SphereOverlapsSphere(&m_querySphere, (SphereCollider*)collider);
+    case Collider::BOX_COLLIDER:
+        return CollisionDetection::SphereOverlapsBox(&m_querySphere, (BoxCollider*)collider);
+    case Collider::MESH_COLLIDER:
+        return CollisionDetection::SphereOverlapsMesh(&m_querySphere, (MeshCollider*)collider);
+    case Collider::COMPOUND_COLLIDER:
+    {
+        CompoundCollider* compound = (CompoundCollider*)collider;
+        m_children.clear();
+        compound->QueryChildren(BoundingBox(&m_querySphere), m_children);
+        for (unsigned int i = 0; i < m_children.size(); i++)
+        {
+            if (OverlapsCollider(compound->GetChild(m_children[i])))
+                return true;
+        }
+        return false;
+    }
+    default:
+        return false;
+    }
+}
\ No newline at end of file
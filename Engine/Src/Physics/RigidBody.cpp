@@ -4,78 +4,87 @@
 #include "GameProject.h"
 #include "Math/Transformations.h"
 #include "Physics/Collider.h"
-#include "Physics/ForceGenerator.h"
 #include "Physics/PhysicsEngine.h"
+#include "Physics/RigidBodyPool.h"
 #include "Serialization/HierarchicalSerializer.h"
 #include <math.h>
 
 RigidBody::RigidBody(GameObjectBase* gameObject)
-    : m_gameObject(gameObject), m_isEnabled(true), m_mass(1.0f), m_motion(0)
-{ }
+    : m_gameObject(gameObject), m_isEnabled(true), m_usesGravity(true), m_mass(1.0f), m_islandIndex(-1),
+      m_inverseRotation(0.0f, 0.0f, 0.0f, 0.0f)     // Not a valid rotation, so the first lookup builds the inverse
+{
+    m_pool = &PhysicsEngine::Singleton().GetRigidBodyPool();
+    m_poolIndex = m_pool->Allocate();
+}
+
+RigidBody::~RigidBody()
+{
+    m_pool->Release(m_poolIndex);
+}
 
 Vector3 RigidBody::GetPosition()
 {
-    return m_position;
+    return m_pool->GetVector(m_poolIndex, RigidBodyPool::POSITION);
 }
 
 void RigidBody::SetPosition(Vector3& position)
 {
-    m_position = position;
+    m_pool->SetVector(m_poolIndex, RigidBodyPool::POSITION, position);
 }
 
-Quaternion& RigidBody::GetRotation()
+Quaternion RigidBody::GetRotation()
 {
-    return m_rotation;
+    return m_pool->GetQuaternion(m_poolIndex, RigidBodyPool::ROTATION);
 }
 
 void RigidBody::SetRotation(Quaternion& rotation)
 {
-    m_rotation = rotation;
+    m_pool->SetQuaternion(m_poolIndex, RigidBodyPool::ROTATION, rotation);
 }
 
 Vector3 RigidBody::GetVelocity()
 {
-    return m_velocity;
+    return m_pool->GetVector(m_poolIndex, RigidBodyPool::VELOCITY);
 }
 
 void RigidBody::SetVelocity(Vector3& velocity)
 {
-    m_velocity = velocity;
+    m_pool->SetVector(m_poolIndex, RigidBodyPool::VELOCITY, velocity);
 }
 
 void RigidBody::AddVelocity(Vector3& deltaVelocity)
 {
-    m_velocity += deltaVelocity;
+    m_pool->AddVector(m_poolIndex, RigidBodyPool::VELOCITY, deltaVelocity);
 }
 
 Vector3 RigidBody::GetAngularVelocity()
 {
-    return m_angularVelocity;
+    return m_pool->GetVector(m_poolIndex, RigidBodyPool::ANGULAR_VELOCITY);
 }
 
 void RigidBody::SetAngularVelocity(Vector3& angularVelocity)
 {
-    m_angularVelocity = angularVelocity;
+    m_pool->SetVector(m_poolIndex, RigidBodyPool::ANGULAR_VELOCITY, angularVelocity);
 }
 
 void RigidBody::AddAngularVelocity(Vector3& deltaAngularVelocity)
 {
-    m_angularVelocity += deltaAngularVelocity;
+    m_pool->AddVector(m_poolIndex, RigidBodyPool::ANGULAR_VELOCITY, deltaAngularVelocity);
 }
 
 Vector3 RigidBody::GetAcceleration()
 {
-    return m_acceleration;
+    return m_pool->GetVector(m_poolIndex, RigidBodyPool::ACCELERATION);
 }
 
 void RigidBody::SetAcceleration(Vector3& acceleration)
 {
-    m_acceleration = acceleration;
+    m_pool->SetVector(m_poolIndex, RigidBodyPool::ACCELERATION, acceleration);
 }
 
 Vector3 RigidBody::GetPreviousAcceleration()
 {
-    return m_previousAcceleration;
+    return m_pool->GetVector(m_poolIndex, RigidBodyPool::PREVIOUS_ACCELERATION);
 }
 
 float RigidBody::GetMass()
@@ -83,7 +92,7 @@ float RigidBody::GetMass()
     if (!HasFiniteMass())
         return 0;
 
-    return 1 / m_inverseMass;
+    return 1 / GetInverseMass();
 }
 
 void RigidBody::SetMass(float mass)
@@ -91,119 +100,94 @@ void RigidBody::SetMass(float mass)
     if (mass < 0 || Approximately(mass, 0.f))
     {
         // Treat 0 mass as infinite mass
-        m_inverseMass = 0.0f;
+        m_pool->SetScalar(m_poolIndex, RigidBodyPool::INVERSE_MASS, 0.0f);
         m_mass = 0.0f;
     }
     else
     {
-        m_inverseMass = 1.0f / mass;
+        m_pool->SetScalar(m_poolIndex, RigidBodyPool::INVERSE_MASS, 1.0f / mass);
         m_mass = mass;
     }
 }
 
 float RigidBody::GetInverseMass()
 {
-    return m_inverseMass;
+    return m_pool->GetScalar(m_poolIndex, RigidBodyPool::INVERSE_MASS);
 }
 
 void RigidBody::SetInverseMass(float inverseMass)
 {
     if (inverseMass < 0)
         return;
-    m_inverseMass = inverseMass;
+    m_pool->SetScalar(m_poolIndex, RigidBodyPool::INVERSE_MASS, inverseMass);
     m_mass = Approximately(inverseMass, 0.f) ? 0.f : 1 / inverseMass;
 }
 
 bool RigidBody::HasFiniteMass()
 {
-    return m_inverseMass > 0;
+    return GetInverseMass() > 0;
 }
 
 void RigidBody::SetInertiaTensor(Matrix3x3& inertiaTensor)
 {
-    m_inverseInertiaTensor = inertiaTensor.Inverse();
+    m_pool->SetMatrix(m_poolIndex, RigidBodyPool::INVERSE_INERTIA_LOCAL, inertiaTensor.Inverse());
+}
+
+void RigidBody::UpdateInertiaTensor()
+{
+    // A compound collider holds all of the body's shapes, so prefer it. Otherwise use the first collider.
+    Matrix3x3 inertiaTensor = Matrix3x3::Identity;
+    std::vector<Collider*>& colliders = m_gameObject->GetColliders();
+    Collider* shape = NULL;
+    for (unsigned int i = 0; i < colliders.size(); i++)
+    {
+        if (shape == NULL || colliders[i]->GetType() == Collider::COMPOUND_COLLIDER)
+        {
+            shape = colliders[i];
+        }
+    }
+    if (shape != NULL)
+    {
+        inertiaTensor = shape->GetInertiaTensor(m_mass);
+    }
+    SetInertiaTensor(inertiaTensor);
+    m_pool->CalculateCachedData(m_poolIndex);
 }
 
-Matrix3x3& RigidBody::GetInverseIntertiaTensorWorld()
+Matrix3x3 RigidBody::GetInverseIntertiaTensorWorld()
 {
-    return m_inverseInertiaTensorWorld;
+    return m_pool->GetMatrix(m_poolIndex, RigidBodyPool::INVERSE_INERTIA_WORLD);
 }
 
 Vector3 RigidBody::GetPointInLocalSpace(const Vector3 &point)
 {
-    return m_transform.InverseTransformPoint(point);
+    return (GetInverseWorldMatrix() * Vector4(point.x(), point.y(), point.z(), 1)).xyz();
 }
 
 Vector3 RigidBody::GetPointInWorldSpace(const Vector3 &point)
 {
-    return m_transform.TransformPoint(point);
+    return (CalculateWorldMatrix() * Vector4(point.x(), point.y(), point.z(), 1)).xyz();
 }
 
 Vector3 RigidBody::GetDirectionInLocalSpace(const Vector3 &direction)
 {
-    return m_transform.InverseTransformVector(direction);
+    return (GetInverseWorldMatrix() * Vector4(direction.x(), direction.y(), direction.z(), 0)).xyz();
 }
 
 Vector3 RigidBody::GetDirectionInWorldSpace(const Vector3 &direction)
 {
-    return m_transform.TransformVector(direction);
+    return (CalculateWorldMatrix() * Vector4(direction.x(), direction.y(), direction.z(), 0)).xyz();
 }
 
-void RigidBody::Integrate(float deltaTime)
+void RigidBody::SavePreviousState()
 {
-    if (!m_isAwake)
-        return;
-
-    // Calculate linear acceleration from force inputs
-    m_previousAcceleration = m_acceleration;
-    m_previousAcceleration += m_accumulatedForce * m_inverseMass;
-
-    // Calculate angular acceleration from torque inputs
-    Vector3 angularAcceleration = m_inverseInertiaTensorWorld * m_accumulatedTorque;
-
-    // Update linear velocity from both acceleration and impulse
-    m_velocity += m_previousAcceleration * deltaTime;
-
-    // Update angular velocity from both acceleration and impulse
-    m_angularVelocity += angularAcceleration * deltaTime;
-
-    // Impose drag
-    m_velocity *= pow(LINEAR_DAMPING, deltaTime);
-    m_angularVelocity *= pow(ANGULAR_DAMPING, deltaTime);
-
-    // Update linear position
-    m_position += m_velocity * deltaTime;
-
-    // Update angular position
-    m_rotation.AddScaledVector(m_angularVelocity, deltaTime);
-
-    // Normalize rotation and update cached data
-    CalculateCachedData();
-
-    // Reset for next frame
-    ClearAccumulators();
-
-    // Determine whether this object should be put to sleep
-    if (m_canSleep)
-    {
-        float currentMotion = m_velocity.MagnitudeSqrd() + m_angularVelocity.MagnitudeSqrd();
-        float bias = pow(MOTION_RWA_BIAS, deltaTime);
-        m_motion = bias * m_motion + (1 - bias)*currentMotion;
-        if (m_motion < SLEEP_EPSILON)
-        {
-            SetAwake(false);
-        }
-        else if (m_motion > 10 * SLEEP_EPSILON)
-        {
-            m_motion = 10 * SLEEP_EPSILON;
-        }
-    }
+    m_pool->SetVector(m_poolIndex, RigidBodyPool::PREVIOUS_POSITION, GetPosition());
+    m_pool->SetQuaternion(m_poolIndex, RigidBodyPool::PREVIOUS_ROTATION, GetRotation());
 }
 
 void RigidBody::AddForce(Vector3& force)
 {
-    m_accumulatedForce += force;
-    printf("Add force\n");
+    m_pool->AddVector(m_poolIndex, RigidBodyPool::ACCUMULATED_FORCE, force);
     SetAwake(true);
 }
 
@@ -211,11 +195,10 @@ void RigidBody::AddForceAtPoint(Vector3& force, Vector3& point)
 {
     // Convert to coordinates relative to center of mass
     Vector3 pt = point;
-    pt -= m_position;
+    pt -= GetPosition();
 
-    m_accumulatedForce += force;
-    m_accumulatedTorque += pt.Cross(force);
-    printf("Add force at point\n");
+    m_pool->AddVector(m_poolIndex, RigidBodyPool::ACCUMULATED_FORCE, force);
+    m_pool->AddVector(m_poolIndex, RigidBodyPool::ACCUMULATED_TORQUE, pt.Cross(force));
     SetAwake(true);
 }
 
@@ -257,7 +240,7 @@ void RigidBody::Save(HierarchicalSerializer* serializer)
 {
     serializer->PushScope("RigidBody");
     serializer->SetAttribute("IsEnabled", m_isEnabled);
-    serializer->SetAttribute("CanSleep", m_canSleep);
+    serializer->SetAttribute("CanSleep", CanSleep());
     serializer->SetAttribute("UsesGravity", m_usesGravity);
     serializer->SetAttribute("Mass", m_mass);
     serializer->PopScope();
@@ -291,44 +274,65 @@ bool RigidBody::IsEnabled()
 
 void RigidBody::SetAwake(bool isAwake)
 {
-    if (isAwake == m_isAwake)
+    if (isAwake == IsAwake())
         return;
     
     if (isAwake)
     {
         printf("AWAKE: %s\n", m_gameObject->GetName().c_str());
-        m_isAwake = true;
+        m_pool->SetScalar(m_poolIndex, RigidBodyPool::AWAKE, 1.0f);
 
         // Add a bit of motion to avoid falling asleep again immediately
-        m_motion = 2.0f * SLEEP_EPSILON;
+        m_pool->SetScalar(m_poolIndex, RigidBodyPool::MOTION, 2.0f * RIGID_BODY_SLEEP_EPSILON);
     }
     else
     {
         printf("SLEEP: %s\n", m_gameObject->GetName().c_str());
-        m_isAwake = false;
-        m_velocity = Vector3::Zero;
-        m_angularVelocity = Vector3::Zero;
+        m_pool->SetScalar(m_poolIndex, RigidBodyPool::AWAKE, 0.0f);
+        m_pool->SetVector(m_poolIndex, RigidBodyPool::VELOCITY, Vector3::Zero);
+        m_pool->SetVector(m_poolIndex, RigidBodyPool::ANGULAR_VELOCITY, Vector3::Zero);
     }
 }
 
 bool RigidBody::IsAwake()
 {
-    return m_isAwake;
+    return m_pool->GetScalar(m_poolIndex, RigidBodyPool::AWAKE) != 0;
 }
 
 void RigidBody::SetCanSleep(bool canSleep)
 {
-    m_canSleep = canSleep;
+    m_pool->SetScalar(m_poolIndex, RigidBodyPool::CAN_SLEEP, canSleep ? 1.0f : 0.0f);
 }
 
 bool RigidBody::CanSleep()
 {
-    return m_canSleep;
+    return m_pool->GetScalar(m_poolIndex, RigidBodyPool::CAN_SLEEP) != 0;
+}
+
+bool RigidBody::IsBelowSleepThreshold()
+{
+    return CanSleep() && m_pool->GetScalar(m_poolIndex, RigidBodyPool::MOTION) < RIGID_BODY_SLEEP_EPSILON;
+}
+
+void RigidBody::SetIslandIndex(int index)
+{
+    m_islandIndex = index;
+}
+
+int RigidBody::GetIslandIndex()
+{
+    return m_islandIndex;
+}
+
+unsigned int RigidBody::GetPoolIndex()
+{
+    return m_poolIndex;
 }
 
 void RigidBody::SetUsesGravity(bool usesGravity)
 {
     m_usesGravity = usesGravity;
+    m_pool->SetScalar(m_poolIndex, RigidBodyPool::USES_GRAVITY, usesGravity ? 1.0f : 0.0f);
 }
 
 bool RigidBody::UsesGravity()
@@ -340,104 +344,63 @@ void RigidBody::OnCreate()
 {
     PhysicsEngine::Singleton().RegisterRigidBody(this);
 
-    if (UsesGravity())
-    {
-        GravityGenerator* gravity = PhysicsEngine::Singleton().GetGravityGenerator();
-        PhysicsEngine::Singleton().RegisterForce(this, gravity);
-    }
-
-    // Calculate the inertia tensor     // TODO this should happen any time the colliders on the game object change
-    Matrix3x3 inertiaTensor = Matrix3x3::Identity;
-    std::vector<Collider*> colliders = m_gameObject->GetColliders();
-    if (colliders.size() > 0)
-    {
-        // Use the first collider       // TODO handle objects with multiple colliders
-        Collider* collider = colliders[0];
-        inertiaTensor = collider->GetInertiaTensor(m_mass);
-    }
-    SetInertiaTensor(inertiaTensor);
+    UpdateInertiaTensor();
 
     // Get position/rotation from gameobject transform
-    m_position = m_gameObject->GetTransform().GetWorldPosition();
-    m_rotation = EulerToQuaternion(m_gameObject->GetTransform().GetWorldRotation());
+    Quaternion rotation = EulerToQuaternion(m_gameObject->GetTransform().GetWorldRotation());
+    SetPosition(m_gameObject->GetTransform().GetWorldPosition());
+    SetRotation(rotation);
+    m_pool->CalculateCachedData(m_poolIndex);
+    SavePreviousState();
 }
 
-void RigidBody::UpdateGameObject()
+void RigidBody::UpdateGameObject(float interpolation)
 {
-    m_gameObject->GetTransform().SetWorldPosition(m_position);
-    m_gameObject->GetTransform().SetWorldRotation(QuaternionToEuler(m_rotation));
-}
-
-void RigidBody::ClearAccumulators()
-{
-    m_accumulatedForce = Vector3::Zero;
-    m_accumulatedTorque = Vector3::Zero;
+    Vector3 position = GetPosition();
+    Quaternion rotation = GetRotation();
+    if (interpolation < 1.0f)
+    {
+        Vector3 previousPosition = m_pool->GetVector(m_poolIndex, RigidBodyPool::PREVIOUS_POSITION);
+        Quaternion previousRotation = m_pool->GetQuaternion(m_poolIndex, RigidBodyPool::PREVIOUS_ROTATION);
+        position = previousPosition + (position - previousPosition) * interpolation;
+        rotation = Nlerp(previousRotation, rotation, interpolation);
+    }
 
-    CalculateCachedData();
+    m_gameObject->GetTransform().SetWorldPosition(position);
+    m_gameObject->GetTransform().SetWorldRotation(QuaternionToEuler(rotation));
 }
 
-void RigidBody::CalculateCachedData()
+Matrix4x4 RigidBody::CalculateWorldMatrix()
 {
-    m_rotation.Normalize();
-
-    // Calculate the world transform
-    CalculateTRMatrix(m_position, m_rotation, m_transform.GetWorldMatrix());
-
-    // Convert the inertia tensor from local space to world space
-    TransformInertiaTensor(m_rotation,
-                           m_inverseInertiaTensor,
-                           m_transform.GetWorldMatrix(),
-                           m_inverseInertiaTensorWorld);
+    Matrix4x4 transform;
+    CalculateTRMatrix(GetPosition(), GetRotation(), transform);
+    return transform;
 }
 
-// Apply change of basis to convert (inverse) inertia tensor from local space to world space.
-// We only need the rotational component of the transform, so we ignore the position as an optimization.
-// Formulas taken from Game Physics Engine Development pg. 218
-void RigidBody::TransformInertiaTensor(const Quaternion& q, const Matrix3x3& iitLocal, const Matrix4x4 transformWorld, Matrix3x3& iitWorld)
+const Matrix4x4& RigidBody::GetInverseWorldMatrix()
 {
-    float t4 = transformWorld[0][0]*iitLocal[0][0] +
-               transformWorld[0][1]*iitLocal[1][0] +
-               transformWorld[0][2]*iitLocal[2][0];
-
-    float t9 = transformWorld[0][0] * iitLocal[0][1] +
-               transformWorld[0][1] * iitLocal[1][1] +
-               transformWorld[0][2] * iitLocal[2][1];
-
-    float t14 = transformWorld[0][0] * iitLocal[0][2] +
-                transformWorld[0][1] * iitLocal[1][2] +
-                transformWorld[0][2] * iitLocal[2][2];
-
-    float t28 = transformWorld[1][0] * iitLocal[0][0] +
-                transformWorld[1][1] * iitLocal[1][0] +
-                transformWorld[1][2] * iitLocal[2][0];
-
-    float t33 = transformWorld[1][0] * iitLocal[0][1] +
-                transformWorld[1][1] * iitLocal[1][1] +
-                transformWorld[1][2] * iitLocal[2][1];
-
-    float t38 = transformWorld[1][0] * iitLocal[0][2] +
-                transformWorld[1][1] * iitLocal[1][2] +
-                transformWorld[1][2] * iitLocal[2][2];
-
-    float t52 = transformWorld[2][0] * iitLocal[0][0] +
-                transformWorld[2][1] * iitLocal[1][0] +
-                transformWorld[2][2] * iitLocal[2][0];
-
-    float t57 = transformWorld[2][0] * iitLocal[0][1] +
-                transformWorld[2][1] * iitLocal[1][1] +
-                transformWorld[2][2] * iitLocal[2][1];
+    // The body's state lives in the pool and is written by the integrator and the solver directly, so the
+    // cache is checked against the state it was built from rather than invalidated
+    Vector3 position = GetPosition();
+    Quaternion rotation = GetRotation();
+    if (position == m_inversePosition && rotation.r() == m_inverseRotation.r() && rotation.i() == m_inverseRotation.i() &&
+        rotation.j() == m_inverseRotation.j() && rotation.k() == m_inverseRotation.k())
+    {
+        return m_inverseWorldMatrix;
+    }
 
-    float t62 = transformWorld[2][0] * iitLocal[0][2] +
-                transformWorld[2][1] * iitLocal[1][2] +
-                transformWorld[2][2] * iitLocal[2][2];
+    // The transform is a rotation and a translation, so the inverse is the transposed rotation, and the
+    // translation rotated back and negated
+    Matrix4x4 transform;
+    CalculateTRMatrix(Vector3::Zero, rotation, transform);
+    m_inverseWorldMatrix = transform.Transpose();
+    for (int row = 0; row < 3; row++)
+    {
+        m_inverseWorldMatrix[row][3] = -(m_inverseWorldMatrix[row][0] * position.x() + m_inverseWorldMatrix[row][1] * position.y() +
+                                         m_inverseWorldMatrix[row][2] * position.z());
+    }
 
-    iitWorld[0][0] = t4*transformWorld[0][0] + t9*transformWorld[0][1] + t14*transformWorld[0][2];
-    iitWorld[0][1] = t4*transformWorld[1][0] + t9*transformWorld[1][1] + t14*transformWorld[1][2];
-    iitWorld[0][2] = t4*transformWorld[2][0] + t9*transformWorld[2][1] + t14*transformWorld[2][2];
-    iitWorld[1][0] = t28*transformWorld[0][0] + t33*transformWorld[0][1] + t38*transformWorld[0][2];
-    iitWorld[1][1] = t28*transformWorld[1][0] + t33*transformWorld[1][1] + t38*transformWorld[1][2];
-    iitWorld[1][2] = t28*transformWorld[2][0] + t33*transformWorld[2][1] + t38*transformWorld[2][2];
-    iitWorld[2][0] = t52*transformWorld[0][0] + t57*transformWorld[0][1] + t62*transformWorld[0][2];
-    iitWorld[2][1] = t52*transformWorld[1][0] + t57*transformWorld[1][1] + t62*transformWorld[1][2];
-    iitWorld[2][2] = t52*transformWorld[2][0] + t57*transformWorld[2][1] + t62*transformWorld[2][2];
+    m_inversePosition = position;
+    m_inverseRotation = rotation;
+    return m_inverseWorldMatrix;
 }
\ No newline at end of file
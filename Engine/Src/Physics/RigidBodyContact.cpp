@@ -1,4 +1,5 @@
 #include "Physics/RigidBodyContact.h"
+#include "Physics/ContactManifold.h"
 #include "Physics/RigidBody.h"
 #include <assert.h>
 
@@ -67,7 +68,7 @@ void RigidBodyContact::CalculateContactBasis()
         contactTangents[0].SetZ(-ContactNormal.x()*s);
 
         // The new y-axis is at right angles to the new x and z-axes
-        contactTangents[1].SetX(ContactNormal.y()*contactTangents[0].x());
+        contactTangents[1].SetX(ContactNormal.y()*contactTangents[0].z());
         contactTangents[1].SetY(ContactNormal.z()*contactTangents[0].x() -
             ContactNormal.x()*contactTangents[0].z());
         contactTangents[1].SetZ(-ContactNormal.y()*contactTangents[0].x());
@@ -140,6 +141,13 @@ void RigidBodyContact::CalculateDesiredDeltaVelocity(float deltaTime)
     // Combine the bounce velocity with the removed acceleration velocity
     m_desiredDeltaVelocity = -m_contactVelocity.x() -
         actualRestituion*(m_contactVelocity.x() - velocityFromAcceleration);
+
+    // A speculative contact (negative penetration) only has to keep the bodies from closing the gap
+    // between them this step. If they're slow enough already, the desired change is negative and is skipped.
+    if (Penetration < 0)
+    {
+        m_desiredDeltaVelocity = -m_contactVelocity.x() + Penetration / deltaTime;
+    }
 }
 
 // Separating velocity (v_s) = (relative velocity) dot (contact normal) = (v_a - v_b) dot (norm(p_a - p_b))
@@ -367,6 +375,12 @@ void RigidBodyContact::ApplyVelocityChange(Vector3* velocityChange, Vector3* ang
     // Convert impulse to world coords
     Vector3 impulseWorldCoords = m_contactToWorld * impulseContactCoords;
 
+    // Keep a running total for collision events
+    if (CachedPoint != NULL)
+    {
+        CachedPoint->NormalImpulse += impulseContactCoords.x();
+    }
+
     // Split the impulse into linear and angular components
     Vector3 impulsiveTorque = m_relativeContactPosition[0].Cross(impulseWorldCoords);
     angularVelocityChange[0] = inverseInertiaTensor[0] * impulsiveTorque;
@@ -401,6 +415,7 @@ void RigidBodyContact::MatchAwakeState()
 }
 
 ContactResolver::ContactResolver(unsigned int maxIterations)
+    : m_positionIterationsUsed(0), m_velocityIterationsUsed(0)
 {
     SetMaxIterations(maxIterations);
 }
@@ -412,6 +427,8 @@ void ContactResolver::SetMaxIterations(unsigned int maxIterations)
 
 void ContactResolver::ResolveContacts(RigidBodyContact* contacts, unsigned int numContacts, float deltaTime)
 {
+    m_positionIterationsUsed = 0;
+    m_velocityIterationsUsed = 0;
     if (numContacts == 0)
         return;
 
@@ -420,6 +437,21 @@ void ContactResolver::ResolveContacts(RigidBodyContact* contacts, unsigned int n
     AdjustVelocities(contacts, numContacts, deltaTime);
 }
 
+unsigned int ContactResolver::GetPositionIterationsUsed()
+{
+    return m_positionIterationsUsed;
+}
+
+unsigned int ContactResolver::GetVelocityIterationsUsed()
+{
+    return m_velocityIterationsUsed;
+}
+
+bool ContactResolver::HitIterationLimit()
+{
+    return m_positionIterationsUsed >= m_maxIterations || m_velocityIterationsUsed >= m_maxIterations;
+}
+
 void ContactResolver::PrepareContacts(RigidBodyContact* contacts, unsigned int numContacts, float deltaTime)
 {
     // Set up contacts to be ready for processing. This ensures that their internal data is configured
@@ -495,10 +527,7 @@ void ContactResolver::AdjustPositions(RigidBodyContact* contacts, unsigned int n
 
         iterationsUsed++;
     }
-    if (iterationsUsed >= m_maxIterations)
-    {
-        printf("\tHit max iterations!!!\n");
-    }
+    m_positionIterationsUsed = iterationsUsed;
 }
 
 void ContactResolver::AdjustVelocities(RigidBodyContact* contacts, unsigned int numContacts, float deltaTime)
@@ -558,8 +587,5 @@ void ContactResolver::AdjustVelocities(RigidBodyContact* contacts, unsigned int
 
         iterationsUsed++;
     }
-    if (iterationsUsed >= m_maxIterations)
-    {
-        printf("\tHit max iterations!!!\n");
-    }
+    m_velocityIterationsUsed = iterationsUsed;
 }
\ No newline at end of file
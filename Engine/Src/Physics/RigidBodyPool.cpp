@@ -0,0 +1,380 @@
+#include "Physics/RigidBodyPool.h"
+
+#include "Math/PackedFloat.h"
+
+namespace
+{
+    struct StepConstants
+    {
+        float   DeltaTime;
+        float   LinearDamping;      // Damping factors are raised to the step length once, rather than per body
+        float   AngularDamping;
+        float   MotionBias;
+        float   MaxMotion;
+        float   Gravity[3];
+    };
+
+    template <typename Real>
+    void NormalizeQuaternion(Real q[4])
+    {
+        Real zero(0.0f);
+        Real d = q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3];
+        Real valid = GreaterThan(d, zero);
+        Real scale = Real(1.0f) / Sqrt(Select(valid, d, Real(1.0f)));
+
+        // A zero-length rotation falls back to the identity, like Quaternion::Normalize
+        q[0] = Select(valid, q[0]*scale, Real(1.0f));
+        q[1] = Select(valid, q[1]*scale, zero);
+        q[2] = Select(valid, q[2]*scale, zero);
+        q[3] = Select(valid, q[3]*scale, zero);
+    }
+
+    // Converts the inverse inertia tensor from local space to world space: R * I * R^T
+    template <typename Real>
+    void TransformInertiaTensor(const Real q[4], const Real local[9], Real world[9])
+    {
+        Real one(1.0f);
+        Real two(2.0f);
+        Real r = q[0], i = q[1], j = q[2], k = q[3];
+
+        Real rotation[9];
+        rotation[0] = one - two*j*j - two*k*k;
+        rotation[1] = two*i*j - two*r*k;
+        rotation[2] = two*i*k + two*r*j;
+        rotation[3] = two*i*j + two*r*k;
+        rotation[4] = one - two*i*i - two*k*k;
+        rotation[5] = two*j*k - two*r*i;
+        rotation[6] = two*i*k - two*r*j;
+        rotation[7] = two*j*k + two*r*i;
+        rotation[8] = one - two*i*i - two*j*j;
+
+        Real temp[9];
+        for (int row = 0; row < 3; row++)
+        {
+            for (int col = 0; col < 3; col++)
+            {
+                temp[row*3 + col] = rotation[row*3 + 0] * local[0*3 + col] +
+                                    rotation[row*3 + 1] * local[1*3 + col] +
+                                    rotation[row*3 + 2] * local[2*3 + col];
+            }
+        }
+
+        for (int row = 0; row < 3; row++)
+        {
+            for (int col = 0; col < 3; col++)
+            {
+                world[row*3 + col] = temp[row*3 + 0] * rotation[col*3 + 0] +
+                                     temp[row*3 + 1] * rotation[col*3 + 1] +
+                                     temp[row*3 + 2] * rotation[col*3 + 2];
+            }
+        }
+    }
+
+    template <typename Real>
+    void StoreSelected(float* p, Real mask, Real value)
+    {
+        Select(mask, value, Real::Load(p)).Store(p);
+    }
+
+    template <typename Real>
+    void IntegrateBodies(float** s, unsigned int begin, unsigned int end, const StepConstants& constants)
+    {
+        typedef RigidBodyPool P;
+
+        Real zero(0.0f);
+        Real half(0.5f);
+        Real deltaTime(constants.DeltaTime);
+        Real linearDamping(constants.LinearDamping);
+        Real angularDamping(constants.AngularDamping);
+        Real motionBias(constants.MotionBias);
+        Real motionWeight(1.0f - constants.MotionBias);
+        Real maxMotion(constants.MaxMotion);
+        Real gravity[3] = { Real(constants.Gravity[0]), Real(constants.Gravity[1]), Real(constants.Gravity[2]) };
+
+        for (unsigned int b = begin; b < end; b += Real::Width)
+        {
+            // Remember the state at the start of the step, so rendering can interpolate from it
+            for (int c = 0; c < 3; c++)
+            {
+                Real::Load(s[P::POSITION + c] + b).Store(s[P::PREVIOUS_POSITION + c] + b);
+            }
+            for (int c = 0; c < 4; c++)
+            {
+                Real::Load(s[P::ROTATION + c] + b).Store(s[P::PREVIOUS_ROTATION + c] + b);
+            }
+
+            Real active = MaskAnd(GreaterThan(Real::Load(s[P::AWAKE] + b), zero),
+                                  GreaterThan(Real::Load(s[P::SIMULATED] + b), zero));
+
+            // Calculate linear acceleration from force inputs and gravity
+            Real inverseMass = Real::Load(s[P::INVERSE_MASS] + b);
+            Real usesGravity = MaskAnd(GreaterThan(Real::Load(s[P::USES_GRAVITY] + b), zero), GreaterThan(inverseMass, zero));
+            Real acceleration[3];
+            for (int c = 0; c < 3; c++)
+            {
+                acceleration[c] = Real::Load(s[P::ACCELERATION + c] + b) + Real::Load(s[P::ACCUMULATED_FORCE + c] + b) * inverseMass;
+                acceleration[c] = acceleration[c] + Select(usesGravity, gravity[c], zero);
+            }
+
+            // Calculate angular acceleration from torque inputs
+            Real torque[3];
+            Real inverseInertiaWorld[9];
+            for (int c = 0; c < 3; c++)
+            {
+                torque[c] = Real::Load(s[P::ACCUMULATED_TORQUE + c] + b);
+            }
+            for (int c = 0; c < 9; c++)
+            {
+                inverseInertiaWorld[c] = Real::Load(s[P::INVERSE_INERTIA_WORLD + c] + b);
+            }
+
+            // Update velocities, impose drag, then update the position
+            Real velocity[3];
+            Real angularVelocity[3];
+            Real position[3];
+            for (int c = 0; c < 3; c++)
+            {
+                Real angularAcceleration = inverseInertiaWorld[c*3 + 0] * torque[0] +
+                                           inverseInertiaWorld[c*3 + 1] * torque[1] +
+                                           inverseInertiaWorld[c*3 + 2] * torque[2];
+
+                velocity[c] = (Real::Load(s[P::VELOCITY + c] + b) + acceleration[c] * deltaTime) * linearDamping;
+                angularVelocity[c] = (Real::Load(s[P::ANGULAR_VELOCITY + c] + b) + angularAcceleration * deltaTime) * angularDamping;
+                position[c] = Real::Load(s[P::POSITION + c] + b) + velocity[c] * deltaTime;
+            }
+
+            // Update the rotation: q += 0.5 * (0, w * dt) * q
+            Real q[4];
+            for (int c = 0; c < 4; c++)
+            {
+                q[c] = Real::Load(s[P::ROTATION + c] + b);
+            }
+            Real wx = angularVelocity[0] * deltaTime;
+            Real wy = angularVelocity[1] * deltaTime;
+            Real wz = angularVelocity[2] * deltaTime;
+            Real dr = zero - wx*q[1] - wy*q[2] - wz*q[3];
+            Real di = wx*q[0] + wy*q[3] - wz*q[2];
+            Real dj = wy*q[0] + wz*q[1] - wx*q[3];
+            Real dk = wz*q[0] + wx*q[2] - wy*q[1];
+            q[0] = q[0] + half*dr;
+            q[1] = q[1] + half*di;
+            q[2] = q[2] + half*dj;
+            q[3] = q[3] + half*dk;
+
+            // Normalize rotation and update cached data
+            NormalizeQuaternion(q);
+            Real inverseInertiaLocal[9];
+            for (int c = 0; c < 9; c++)
+            {
+                inverseInertiaLocal[c] = Real::Load(s[P::INVERSE_INERTIA_LOCAL + c] + b);
+            }
+            TransformInertiaTensor(q, inverseInertiaLocal, inverseInertiaWorld);
+
+            // Track recent motion, so the physics engine can tell whether this body's island should be put to sleep
+            Real currentMotion = velocity[0]*velocity[0] + velocity[1]*velocity[1] + velocity[2]*velocity[2] +
+                                 angularVelocity[0]*angularVelocity[0] + angularVelocity[1]*angularVelocity[1] + angularVelocity[2]*angularVelocity[2];
+            Real motion = Min(motionBias * Real::Load(s[P::MOTION] + b) + motionWeight * currentMotion, maxMotion);
+            Real tracksMotion = MaskAnd(active, GreaterThan(Real::Load(s[P::CAN_SLEEP] + b), zero));
+            StoreSelected(s[P::MOTION] + b, tracksMotion, motion);
+
+            // Write back the bodies that were integrated, and reset their accumulators for the next step
+            for (int c = 0; c < 3; c++)
+            {
+                StoreSelected(s[P::PREVIOUS_ACCELERATION + c] + b, active, acceleration[c]);
+                StoreSelected(s[P::VELOCITY + c] + b, active, velocity[c]);
+                StoreSelected(s[P::ANGULAR_VELOCITY + c] + b, active, angularVelocity[c]);
+                StoreSelected(s[P::POSITION + c] + b, active, position[c]);
+                StoreSelected(s[P::ACCUMULATED_FORCE + c] + b, active, zero);
+                StoreSelected(s[P::ACCUMULATED_TORQUE + c] + b, active, zero);
+            }
+            for (int c = 0; c < 4; c++)
+            {
+                StoreSelected(s[P::ROTATION + c] + b, active, q[c]);
+            }
+            for (int c = 0; c < 9; c++)
+            {
+                StoreSelected(s[P::INVERSE_INERTIA_WORLD + c] + b, active, inverseInertiaWorld[c]);
+            }
+        }
+    }
+}
+
+RigidBodyPool::RigidBodyPool()
+{}
+
+unsigned int RigidBodyPool::Allocate()
+{
+    if (m_freeSlots.empty())
+    {
+        // Grow by a whole SIMD block, and hand out its slots lowest index first
+        unsigned int first = GetCapacity();
+        for (int s = 0; s < NUM_STREAMS; s++)
+        {
+            m_streams[s].resize(first + RIGID_BODY_POOL_SIMD_WIDTH, 0.0f);
+        }
+        for (unsigned int i = RIGID_BODY_POOL_SIMD_WIDTH; i > 0; i--)
+        {
+            ResetSlot(first + i - 1);
+            m_freeSlots.push_back(first + i - 1);
+        }
+    }
+
+    unsigned int index = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    ResetSlot(index);
+    SetScalar(index, AWAKE, 1.0f);
+    SetScalar(index, CAN_SLEEP, 1.0f);
+    SetScalar(index, USES_GRAVITY, 1.0f);
+    return index;
+}
+
+void RigidBodyPool::Release(unsigned int index)
+{
+    if (index >= GetCapacity())
+        return;
+
+    ResetSlot(index);
+    m_freeSlots.push_back(index);
+}
+
+unsigned int RigidBodyPool::GetCapacity()
+{
+    return m_streams[0].size();
+}
+
+float RigidBodyPool::GetScalar(unsigned int index, Stream stream)
+{
+    return m_streams[stream][index];
+}
+
+void RigidBodyPool::SetScalar(unsigned int index, Stream stream, float value)
+{
+    m_streams[stream][index] = value;
+}
+
+Vector3 RigidBodyPool::GetVector(unsigned int index, Stream stream)
+{
+    return Vector3(m_streams[stream][index], m_streams[stream + 1][index], m_streams[stream + 2][index]);
+}
+
+void RigidBodyPool::SetVector(unsigned int index, Stream stream, const Vector3& v)
+{
+    m_streams[stream][index] = v.x();
+    m_streams[stream + 1][index] = v.y();
+    m_streams[stream + 2][index] = v.z();
+}
+
+void RigidBodyPool::AddVector(unsigned int index, Stream stream, const Vector3& v)
+{
+    m_streams[stream][index] += v.x();
+    m_streams[stream + 1][index] += v.y();
+    m_streams[stream + 2][index] += v.z();
+}
+
+Quaternion RigidBodyPool::GetQuaternion(unsigned int index, Stream stream)
+{
+    return Quaternion(m_streams[stream][index], m_streams[stream + 1][index], m_streams[stream + 2][index], m_streams[stream + 3][index]);
+}
+
+void RigidBodyPool::SetQuaternion(unsigned int index, Stream stream, const Quaternion& q)
+{
+    m_streams[stream][index] = q.r();
+    m_streams[stream + 1][index] = q.i();
+    m_streams[stream + 2][index] = q.j();
+    m_streams[stream + 3][index] = q.k();
+}
+
+Matrix3x3 RigidBodyPool::GetMatrix(unsigned int index, Stream stream)
+{
+    Matrix3x3 m;
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            m[row][col] = m_streams[stream + row*3 + col][index];
+        }
+    }
+    return m;
+}
+
+void RigidBodyPool::SetMatrix(unsigned int index, Stream stream, const Matrix3x3& m)
+{
+    for (int row = 0; row < 3; row++)
+    {
+        Vector3 values = m[row];
+        for (int col = 0; col < 3; col++)
+        {
+            m_streams[stream + row*3 + col][index] = values[col];
+        }
+    }
+}
+
+void RigidBodyPool::Integrate(float deltaTime, const Vector3& gravity)
+{
+    unsigned int capacity = GetCapacity();
+    if (capacity == 0)
+        return;
+
+    StepConstants constants;
+    constants.DeltaTime = deltaTime;
+    constants.LinearDamping = powf(RIGID_BODY_LINEAR_DAMPING, deltaTime);
+    constants.AngularDamping = powf(RIGID_BODY_ANGULAR_DAMPING, deltaTime);
+    constants.MotionBias = powf(RIGID_BODY_MOTION_RWA_BIAS, deltaTime);
+    constants.MaxMotion = 10 * RIGID_BODY_SLEEP_EPSILON;
+    constants.Gravity[0] = gravity.x();
+    constants.Gravity[1] = gravity.y();
+    constants.Gravity[2] = gravity.z();
+
+    float* streams[NUM_STREAMS];
+    for (int s = 0; s < NUM_STREAMS; s++)
+    {
+        streams[s] = &m_streams[s][0];
+    }
+
+#if defined(PACKED_FLOAT_SSE) || defined(PACKED_FLOAT_AVX)
+    IntegrateBodies<PackedFloat>(streams, 0, capacity, constants);
+#else
+    IntegrateBodies<Float1>(streams, 0, capacity, constants);
+#endif
+}
+
+void RigidBodyPool::CalculateCachedData(unsigned int index)
+{
+    Float1 q[4];
+    Float1 inverseInertiaLocal[9];
+    Float1 inverseInertiaWorld[9];
+    for (int c = 0; c < 4; c++)
+    {
+        q[c] = Float1(m_streams[ROTATION + c][index]);
+    }
+    for (int c = 0; c < 9; c++)
+    {
+        inverseInertiaLocal[c] = Float1(m_streams[INVERSE_INERTIA_LOCAL + c][index]);
+    }
+
+    NormalizeQuaternion(q);
+    TransformInertiaTensor(q, inverseInertiaLocal, inverseInertiaWorld);
+
+    for (int c = 0; c < 4; c++)
+    {
+        m_streams[ROTATION + c][index] = q[c].v;
+    }
+    for (int c = 0; c < 9; c++)
+    {
+        m_streams[INVERSE_INERTIA_WORLD + c][index] = inverseInertiaWorld[c].v;
+    }
+}
+
+void RigidBodyPool::ResetSlot(unsigned int index)
+{
+    for (int s = 0; s < NUM_STREAMS; s++)
+    {
+        m_streams[s][index] = 0.0f;
+    }
+
+    SetQuaternion(index, ROTATION, Quaternion::Identity);
+    SetQuaternion(index, PREVIOUS_ROTATION, Quaternion::Identity);
+    SetMatrix(index, INVERSE_INERTIA_LOCAL, Matrix3x3::Identity);
+    SetMatrix(index, INVERSE_INERTIA_WORLD, Matrix3x3::Identity);
+    SetScalar(index, INVERSE_MASS, 1.0f);
+}
\ No newline at end of file
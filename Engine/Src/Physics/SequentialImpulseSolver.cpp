@@ -0,0 +1,305 @@
+#include "Physics/SequentialImpulseSolver.h"
+
+#include "Physics/ContactManifold.h"
+#include "Physics/RigidBody.h"
+#include "Physics/RigidBodyContact.h"
+
+#include <algorithm>
+#include <functional>
+
+SequentialImpulseSolver::SequentialImpulseSolver(unsigned int iterations)
+    : m_positionIterationsUsed(0), m_velocityIterationsUsed(0)
+{
+    SetIterations(iterations);
+}
+
+void SequentialImpulseSolver::SetIterations(unsigned int iterations)
+{
+    m_iterations = iterations;
+}
+
+unsigned int SequentialImpulseSolver::GetPositionIterationsUsed()
+{
+    return m_positionIterationsUsed;
+}
+
+unsigned int SequentialImpulseSolver::GetVelocityIterationsUsed()
+{
+    return m_velocityIterationsUsed;
+}
+
+void SequentialImpulseSolver::ResolveContacts(RigidBodyContact* contacts, unsigned int numContacts, float deltaTime)
+{
+    m_positionIterationsUsed = 0;
+    m_velocityIterationsUsed = 0;
+    if (numContacts == 0 || deltaTime <= 0)
+        return;
+
+    // Gather the bodies that can move, so each one gets a pseudo velocity
+    m_bodies.clear();
+    for (unsigned int i = 0; i < numContacts; i++)
+    {
+        for (int b = 0; b < 2; b++)
+        {
+            RigidBody* body = contacts[i].Body[b];
+            if (body != NULL && body->HasFiniteMass())
+            {
+                m_bodies.push_back(body);
+            }
+        }
+    }
+    std::sort(m_bodies.begin(), m_bodies.end(), std::less<RigidBody*>());
+    m_bodies.erase(std::unique(m_bodies.begin(), m_bodies.end()), m_bodies.end());
+    m_pseudoVelocities.assign(m_bodies.size(), Vector3::Zero);
+    m_pseudoAngularVelocities.assign(m_bodies.size(), Vector3::Zero);
+
+    m_constraints.resize(numContacts);
+    for (unsigned int i = 0; i < numContacts; i++)
+    {
+        PrepareConstraint(contacts[i], m_constraints[i], deltaTime);
+        WarmStart(m_constraints[i]);
+    }
+
+    while (m_velocityIterationsUsed < m_iterations)
+    {
+        float largestChange = 0.0f;
+        for (unsigned int i = 0; i < numContacts; i++)
+        {
+            largestChange = fmaxf(largestChange, SolveConstraint(m_constraints[i]));
+        }
+        m_velocityIterationsUsed++;
+
+        if (largestChange <= SEQUENTIAL_IMPULSE_CONVERGENCE_THRESHOLD)
+            break;
+    }
+
+    // Penetration is solved separately, and only ever moves the bodies
+    while (m_positionIterationsUsed < m_iterations)
+    {
+        float largestChange = 0.0f;
+        for (unsigned int i = 0; i < numContacts; i++)
+        {
+            largestChange = fmaxf(largestChange, SolvePositionConstraint(m_constraints[i]));
+        }
+        m_positionIterationsUsed++;
+
+        if (largestChange <= SEQUENTIAL_IMPULSE_CONVERGENCE_THRESHOLD)
+            break;
+    }
+    ApplyPseudoVelocities(deltaTime);
+
+    for (unsigned int i = 0; i < numContacts; i++)
+    {
+        StoreImpulse(m_constraints[i]);
+    }
+}
+
+void SequentialImpulseSolver::PrepareConstraint(RigidBodyContact& contact, Constraint& constraint, float deltaTime)
+{
+    // Contacts may only have a body in the second slot, so make sure the first one is filled
+    if (contact.Body[0] == NULL)
+    {
+        contact.SwapBodies();
+    }
+    contact.MatchAwakeState();
+    contact.CalculateContactBasis();
+
+    constraint.Normal = contact.ContactNormal;
+    constraint.Tangent[0] = contact.m_contactToWorld.Column(1);
+    constraint.Tangent[1] = contact.m_contactToWorld.Column(2);
+    constraint.Friction = contact.Friction;
+    constraint.CachedPoint = contact.CachedPoint;
+
+    for (int i = 0; i < 2; i++)
+    {
+        RigidBody* body = contact.Body[i];
+        constraint.Body[i] = body;
+
+        // Bodies with infinite mass take part in the contact, but are never moved by it
+        if (body != NULL && body->HasFiniteMass())
+        {
+            constraint.BodyIndex[i] = (int)(std::lower_bound(m_bodies.begin(), m_bodies.end(), body, std::less<RigidBody*>()) - m_bodies.begin());
+            constraint.InverseMass[i] = body->GetInverseMass();
+            constraint.InverseInertia[i] = body->GetInverseIntertiaTensorWorld();
+        }
+        else
+        {
+            constraint.BodyIndex[i] = -1;
+            constraint.InverseMass[i] = 0.0f;
+            constraint.InverseInertia[i] = Matrix3x3();
+        }
+        constraint.RelativePosition[i] = body != NULL ? contact.ContactPoint - body->GetPosition() : Vector3::Zero;
+    }
+
+    float normalMass = GetEffectiveMass(constraint, constraint.Normal);
+    constraint.NormalMass = normalMass > 0 ? 1.0f / normalMass : 0.0f;
+    for (int t = 0; t < 2; t++)
+    {
+        float tangentMass = GetEffectiveMass(constraint, constraint.Tangent[t]);
+        constraint.TangentMass[t] = tangentMass > 0 ? 1.0f / tangentMass : 0.0f;
+    }
+
+    // Only bounce if the bodies are closing quickly enough, so resting contacts settle
+    float closingVelocity = GetRelativeVelocity(constraint).Dot(constraint.Normal);
+    constraint.Bias = closingVelocity < -SEQUENTIAL_IMPULSE_RESTITUTION_THRESHOLD ? -contact.Restitution * closingVelocity : 0.0f;
+
+    // A speculative contact (negative penetration) lets the bodies close the gap between them this step, but no more
+    if (contact.Penetration < 0)
+    {
+        constraint.Bias = contact.Penetration / deltaTime;
+    }
+
+    // Remove part of the penetration each step, leaving a little so resting contacts stay touching
+    float penetration = contact.Penetration - SEQUENTIAL_IMPULSE_PENETRATION_SLOP;
+    constraint.PositionBias = penetration > 0 ? SEQUENTIAL_IMPULSE_POSITION_CORRECTION * penetration / deltaTime : 0.0f;
+
+    constraint.NormalImpulse = 0.0f;
+    constraint.TangentImpulse[0] = 0.0f;
+    constraint.TangentImpulse[1] = 0.0f;
+    constraint.PositionImpulse = 0.0f;
+}
+
+void SequentialImpulseSolver::WarmStart(Constraint& constraint)
+{
+    ManifoldPoint* cached = constraint.CachedPoint;
+    if (cached == NULL)
+        return;
+
+    // The tangent basis is rebuilt every step, so friction is cached in world space and projected onto the new basis
+    constraint.NormalImpulse = cached->NormalImpulse;
+    constraint.TangentImpulse[0] = cached->TangentImpulse.Dot(constraint.Tangent[0]);
+    constraint.TangentImpulse[1] = cached->TangentImpulse.Dot(constraint.Tangent[1]);
+
+    Vector3 impulse = constraint.Normal * constraint.NormalImpulse +
+                      constraint.Tangent[0] * constraint.TangentImpulse[0] +
+                      constraint.Tangent[1] * constraint.TangentImpulse[1];
+    ApplyImpulse(constraint, impulse);
+}
+
+float SequentialImpulseSolver::SolveConstraint(Constraint& constraint)
+{
+    // Friction first, so that the normal impulse (which matters more for stability) is solved last
+    float largestChange = 0.0f;
+    float maxFriction = constraint.Friction * constraint.NormalImpulse;
+    for (int t = 0; t < 2; t++)
+    {
+        float lambda = -GetRelativeVelocity(constraint).Dot(constraint.Tangent[t]) * constraint.TangentMass[t];
+        float previousImpulse = constraint.TangentImpulse[t];
+        constraint.TangentImpulse[t] = Clamp(previousImpulse + lambda, -maxFriction, maxFriction);
+        ApplyImpulse(constraint, constraint.Tangent[t] * (constraint.TangentImpulse[t] - previousImpulse));
+        largestChange = fmaxf(largestChange, fabsf(constraint.TangentImpulse[t] - previousImpulse));
+    }
+
+    // The accumulated normal impulse may shrink, but never pull the bodies together
+    float lambda = (constraint.Bias - GetRelativeVelocity(constraint).Dot(constraint.Normal)) * constraint.NormalMass;
+    float previousImpulse = constraint.NormalImpulse;
+    constraint.NormalImpulse = previousImpulse + lambda > 0 ? previousImpulse + lambda : 0.0f;
+    ApplyImpulse(constraint, constraint.Normal * (constraint.NormalImpulse - previousImpulse));
+    return fmaxf(largestChange, fabsf(constraint.NormalImpulse - previousImpulse));
+}
+
+float SequentialImpulseSolver::SolvePositionConstraint(Constraint& constraint)
+{
+    if (constraint.PositionBias <= 0)
+        return 0.0f;
+
+    Vector3 pseudoVelocity = Vector3::Zero;
+    for (int i = 0; i < 2; i++)
+    {
+        int index = constraint.BodyIndex[i];
+        if (index < 0)
+            continue;
+
+        Vector3 pointVelocity = m_pseudoVelocities[index] + m_pseudoAngularVelocities[index].Cross(constraint.RelativePosition[i]);
+        pseudoVelocity = i == 0 ? pseudoVelocity + pointVelocity : pseudoVelocity - pointVelocity;
+    }
+
+    float lambda = (constraint.PositionBias - pseudoVelocity.Dot(constraint.Normal)) * constraint.NormalMass;
+    float previousImpulse = constraint.PositionImpulse;
+    constraint.PositionImpulse = previousImpulse + lambda > 0 ? previousImpulse + lambda : 0.0f;
+    ApplyPositionImpulse(constraint, constraint.Normal * (constraint.PositionImpulse - previousImpulse));
+    return fabsf(constraint.PositionImpulse - previousImpulse);
+}
+
+void SequentialImpulseSolver::StoreImpulse(Constraint& constraint)
+{
+    ManifoldPoint* cached = constraint.CachedPoint;
+    if (cached == NULL)
+        return;
+
+    cached->NormalImpulse = constraint.NormalImpulse;
+    cached->TangentImpulse = constraint.Tangent[0] * constraint.TangentImpulse[0] +
+                             constraint.Tangent[1] * constraint.TangentImpulse[1];
+}
+
+Vector3 SequentialImpulseSolver::GetRelativeVelocity(Constraint& constraint)
+{
+    // Velocity of the contact point on body 0, relative to the same point on body 1
+    Vector3 velocity = Vector3::Zero;
+    for (int i = 0; i < 2; i++)
+    {
+        RigidBody* body = constraint.Body[i];
+        if (body == NULL)
+            continue;
+
+        Vector3 pointVelocity = body->GetVelocity() + body->GetAngularVelocity().Cross(constraint.RelativePosition[i]);
+        velocity = i == 0 ? velocity + pointVelocity : velocity - pointVelocity;
+    }
+    return velocity;
+}
+
+float SequentialImpulseSolver::GetEffectiveMass(Constraint& constraint, const Vector3& axis)
+{
+    // Change in relative velocity along the axis for a unit impulse along it
+    float deltaVelocity = 0.0f;
+    for (int i = 0; i < 2; i++)
+    {
+        Vector3 angular = (constraint.InverseInertia[i] * constraint.RelativePosition[i].Cross(axis)).Cross(constraint.RelativePosition[i]);
+        deltaVelocity += constraint.InverseMass[i] + angular.Dot(axis);
+    }
+    return deltaVelocity;
+}
+
+void SequentialImpulseSolver::ApplyImpulse(Constraint& constraint, const Vector3& impulse)
+{
+    // The impulse pushes body 0 along it, and body 1 the opposite way
+    for (int i = 0; i < 2; i++)
+    {
+        if (constraint.InverseMass[i] == 0)
+            continue;
+
+        float sign = (i == 0) ? 1.0f : -1.0f;
+        Vector3 deltaVelocity = impulse * (sign * constraint.InverseMass[i]);
+        Vector3 deltaAngularVelocity = constraint.InverseInertia[i] * constraint.RelativePosition[i].Cross(impulse * sign);
+        constraint.Body[i]->AddVelocity(deltaVelocity);
+        constraint.Body[i]->AddAngularVelocity(deltaAngularVelocity);
+    }
+}
+
+void SequentialImpulseSolver::ApplyPositionImpulse(Constraint& constraint, const Vector3& impulse)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        int index = constraint.BodyIndex[i];
+        if (index < 0)
+            continue;
+
+        float sign = (i == 0) ? 1.0f : -1.0f;
+        m_pseudoVelocities[index] += impulse * (sign * constraint.InverseMass[i]);
+        m_pseudoAngularVelocities[index] += constraint.InverseInertia[i] * constraint.RelativePosition[i].Cross(impulse * sign);
+    }
+}
+
+void SequentialImpulseSolver::ApplyPseudoVelocities(float deltaTime)
+{
+    for (unsigned int i = 0; i < m_bodies.size(); i++)
+    {
+        Vector3 position = m_bodies[i]->GetPosition() + m_pseudoVelocities[i] * deltaTime;
+        m_bodies[i]->SetPosition(position);
+
+        Quaternion rotation = m_bodies[i]->GetRotation();
+        rotation.AddScaledVector(m_pseudoAngularVelocities[i], deltaTime);
+        rotation.Normalize();
+        m_bodies[i]->SetRotation(rotation);
+    }
+}
\ No newline at end of file
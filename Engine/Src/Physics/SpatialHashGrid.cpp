@@ -0,0 +1,396 @@
+#include "Physics/SpatialHashGrid.h"
+
+#include "Debugging/DebugDraw.h"
+#include "Math/Transformations.h"
+#include "Physics/Collider.h"
+#include "Physics/CollisionEngine.h"
+#include "Physics/CollisionFilter.h"
+
+#include <algorithm>
+#include <climits>
+
+// Ratio of the automatic cell size to the median collider radius. Each cell is two median
+// diameters wide, so colliders up to twice the median size still fit in a single cell.
+const float SpatialHashGrid::AUTO_CELL_SIZE_SCALE = 4.0f;
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+    : m_cellSize(cellSize), m_autoCellSize(cellSize <= 0.0f), m_cellSizeDirty(true)
+{
+    if (m_autoCellSize)
+    {
+        m_cellSize = 1.0f;
+    }
+}
+
+void SpatialHashGrid::AddCollider(Collider* collider)
+{
+    if (collider == NULL || collider->GetBroadPhaseProxy() != -1)
+        return;
+
+    // Reuse a free proxy slot if possible
+    int proxy;
+    if (!m_freeProxies.empty())
+    {
+        proxy = m_freeProxies.back();
+        m_freeProxies.pop_back();
+    }
+    else
+    {
+        proxy = (int)m_proxies.size();
+        m_proxies.push_back(Proxy());
+    }
+
+    m_proxies[proxy].Box = BoundingBox(collider);
+    m_proxies[proxy].Object = collider;
+    m_proxies[proxy].LiveIndex = (int)m_liveProxies.size();
+    collider->SetBroadPhaseProxy(proxy);
+    m_liveProxies.push_back(proxy);
+
+    m_cellSizeDirty = true;
+}
+
+void SpatialHashGrid::RemoveCollider(Collider* collider)
+{
+    if (collider == NULL || collider->GetBroadPhaseProxy() == -1)
+        return;
+
+    int proxy = collider->GetBroadPhaseProxy();
+    int liveIndex = m_proxies[proxy].LiveIndex;
+    int lastProxy = m_liveProxies.back();
+    m_liveProxies[liveIndex] = lastProxy;
+    m_proxies[lastProxy].LiveIndex = liveIndex;
+    m_liveProxies.pop_back();
+
+    m_proxies[proxy].Object = NULL;
+    m_freeProxies.push_back(proxy);
+    collider->SetBroadPhaseProxy(-1);
+
+    m_cellSizeDirty = true;
+}
+
+void SpatialHashGrid::UpdateCollider(Collider* collider, const BoundingBox& box, const Vector3&)
+{
+    // Cells are rebuilt from the current bounds every frame, so the displacement isn't needed to keep them valid
+    m_proxies[collider->GetBroadPhaseProxy()].Box = box;
+}
+
+unsigned int SpatialHashGrid::GetPotentialContacts(vector<PotentialContact>& contacts, CollisionFilter* filter)
+{
+    if (m_autoCellSize && m_cellSizeDirty)
+    {
+        CalculateAutoCellSize();
+    }
+    m_cellSizeDirty = false;
+
+    BuildCells();
+
+    unsigned int count = 0;
+
+    // Test the colliders in each occupied cell against each other, and against the colliders in
+    // neighboring cells. Only half of the neighbors are visited, so each pair of cells is seen once.
+    static const int NEIGHBOR_OFFSETS[13][3] = {
+        { 1, 0, 0 }, { 1, 1, 0 }, { 1, -1, 0 }, { 0, 1, 0 }, { 1, 0, 1 },
+        { 1, 1, 1 }, { 1, -1, 1 }, { 0, 1, 1 }, { 0, 0, 1 }, { 1, 0, -1 },
+        { 1, 1, -1 }, { 1, -1, -1 }, { 0, 1, -1 }
+    };
+
+    for (size_t c = 0; c < m_occupiedCells.size(); c++)
+    {
+        Cell& cell = m_cells[m_occupiedCells[c]];
+        int* cellProxies = &m_cellProxies[cell.First];
+
+        // Pairs within the cell
+        for (int i = 0; i < cell.Count; i++)
+        {
+            Proxy& a = m_proxies[cellProxies[i]];
+            for (int j = i + 1; j < cell.Count; j++)
+            {
+                Proxy& b = m_proxies[cellProxies[j]];
+                if (a.Box.Overlaps(&b.Box) && (filter == NULL || filter->ShouldCollide(a.Object, b.Object)))
+                {
+                    contacts.push_back(PotentialContact(a.Object, b.Object));
+                    count++;
+                }
+            }
+        }
+
+        // Pairs with neighboring cells
+        for (int n = 0; n < 13; n++)
+        {
+            int neighborIndex = FindCell(cell.Coords[0] + NEIGHBOR_OFFSETS[n][0],
+                                         cell.Coords[1] + NEIGHBOR_OFFSETS[n][1],
+                                         cell.Coords[2] + NEIGHBOR_OFFSETS[n][2]);
+            if (neighborIndex == -1)
+                continue;
+
+            Cell& neighbor = m_cells[neighborIndex];
+            int* neighborProxies = &m_cellProxies[neighbor.First];
+            for (int i = 0; i < cell.Count; i++)
+            {
+                Proxy& a = m_proxies[cellProxies[i]];
+                for (int j = 0; j < neighbor.Count; j++)
+                {
+                    Proxy& b = m_proxies[neighborProxies[j]];
+                    if (a.Box.Overlaps(&b.Box) && (filter == NULL || filter->ShouldCollide(a.Object, b.Object)))
+                    {
+                        contacts.push_back(PotentialContact(a.Object, b.Object));
+                        count++;
+                    }
+                }
+            }
+        }
+    }
+
+    // Colliders that didn't fit in a cell are tested against all other colliders
+    for (size_t i = 0; i < m_fallbackProxies.size(); i++)
+    {
+        int proxyA = m_fallbackProxies[i];
+        Proxy& a = m_proxies[proxyA];
+        for (size_t j = 0; j < m_liveProxies.size(); j++)
+        {
+            int proxyB = m_liveProxies[j];
+            if (proxyB == proxyA)
+                continue;
+
+            // When both colliders are in the fallback list, only report the pair once
+            Proxy& b = m_proxies[proxyB];
+            if (b.Cell[0] == INT_MAX && proxyB < proxyA)
+                continue;
+
+            if (a.Box.Overlaps(&b.Box) && (filter == NULL || filter->ShouldCollide(a.Object, b.Object)))
+            {
+                contacts.push_back(PotentialContact(a.Object, b.Object));
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+void SpatialHashGrid::QueryBox(const BoundingBox& box, vector<Collider*>& results)
+{
+    // Colliders in a cell are no bigger than the cell, so their centers are at most half a cell outside of the box
+    float minCell[3];
+    float maxCell[3];
+    float cellCount = 1.0f;
+    float inverseCellSize = 1.0f / m_cellSize;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        minCell[axis] = floorf((box.Min[axis] - m_cellSize * 0.5f) * inverseCellSize);
+        maxCell[axis] = floorf((box.Max[axis] + m_cellSize * 0.5f) * inverseCellSize);
+        cellCount *= maxCell[axis] - minCell[axis] + 1.0f;
+    }
+
+    // Test every collider instead if that's cheaper than looking up the cells, or if the cells are out of
+    // date (colliders have been added or removed since they were built)
+    if (m_cells.empty() || m_cellSizeDirty || m_cellSize <= 0.0f || !(cellCount <= (float)m_liveProxies.size()))
+    {
+        for (size_t i = 0; i < m_liveProxies.size(); i++)
+        {
+            Proxy& proxy = m_proxies[m_liveProxies[i]];
+            if (proxy.Box.Overlaps(&box))
+            {
+                results.push_back(proxy.Object);
+            }
+        }
+        return;
+    }
+
+    for (int x = (int)minCell[0]; x <= (int)maxCell[0]; x++)
+    {
+        for (int y = (int)minCell[1]; y <= (int)maxCell[1]; y++)
+        {
+            for (int z = (int)minCell[2]; z <= (int)maxCell[2]; z++)
+            {
+                int cellIndex = FindCell(x, y, z);
+                if (cellIndex == -1)
+                    continue;
+
+                Cell& cell = m_cells[cellIndex];
+                for (int i = cell.First; i < cell.First + cell.Count; i++)
+                {
+                    Proxy& proxy = m_proxies[m_cellProxies[i]];
+                    if (proxy.Box.Overlaps(&box))
+                    {
+                        results.push_back(proxy.Object);
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m_fallbackProxies.size(); i++)
+    {
+        Proxy& proxy = m_proxies[m_fallbackProxies[i]];
+        if (proxy.Box.Overlaps(&box))
+        {
+            results.push_back(proxy.Object);
+        }
+    }
+}
+
+void SpatialHashGrid::QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, BroadPhaseRayCallback* callback)
+{
+    // A ray can cross many cells, so test every collider
+    Vector3 inverseDirection(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+    for (size_t i = 0; i < m_liveProxies.size(); i++)
+    {
+        Proxy& proxy = m_proxies[m_liveProxies[i]];
+        float entryDistance;
+        if (proxy.Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, entryDistance))
+        {
+            maxDistance = callback->RayTest(proxy.Object, maxDistance);
+        }
+    }
+}
+
+void SpatialHashGrid::DrawDebugInfo(ColorRGB color)
+{
+    // Draw the occupied cells
+    Vector3 halfsize(m_cellSize * 0.5f, m_cellSize * 0.5f, m_cellSize * 0.5f);
+    for (size_t c = 0; c < m_occupiedCells.size(); c++)
+    {
+        Cell& cell = m_cells[m_occupiedCells[c]];
+        Vector3 center((cell.Coords[0] + 0.5f) * m_cellSize,
+                       (cell.Coords[1] + 0.5f) * m_cellSize,
+                       (cell.Coords[2] + 0.5f) * m_cellSize);
+        Matrix4x4 cellMatrix = Translation(center);
+        cellMatrix = cellMatrix * Scaling(halfsize);
+        DebugDraw::Singleton().DrawCube(cellMatrix, color);
+    }
+}
+
+float SpatialHashGrid::GetCellSize()
+{
+    return m_cellSize;
+}
+
+void SpatialHashGrid::CalculateAutoCellSize()
+{
+    if (m_liveProxies.empty())
+        return;
+
+    // Find the median bounding radius
+    vector<float> radii;
+    radii.reserve(m_liveProxies.size());
+    for (size_t i = 0; i < m_liveProxies.size(); i++)
+    {
+        radii.push_back(m_proxies[m_liveProxies[i]].Object->GetWorldspaceBoundingRadius());
+    }
+    std::nth_element(radii.begin(), radii.begin() + radii.size() / 2, radii.end());
+    float medianRadius = radii[radii.size() / 2];
+
+    if (medianRadius > 0.0f)
+    {
+        m_cellSize = medianRadius * AUTO_CELL_SIZE_SCALE;
+    }
+}
+
+void SpatialHashGrid::BuildCells()
+{
+    // Size the table so that it is at most half full
+    size_t capacity = 16;
+    while (capacity < m_liveProxies.size() * 2)
+    {
+        capacity *= 2;
+    }
+
+    Cell emptyCell;
+    emptyCell.Count = 0;
+    m_cells.assign(capacity, emptyCell);
+    m_occupiedCells.clear();
+    m_fallbackProxies.clear();
+
+    // First pass: find the cell for each collider and count the number of colliders per cell
+    float inverseCellSize = 1.0f / m_cellSize;
+    for (size_t i = 0; i < m_liveProxies.size(); i++)
+    {
+        Proxy& proxy = m_proxies[m_liveProxies[i]];
+        Vector3 extents = proxy.Box.Max - proxy.Box.Min;
+        if (extents.MaxElement() > m_cellSize)
+        {
+            proxy.Cell[0] = INT_MAX;
+            m_fallbackProxies.push_back(m_liveProxies[i]);
+            continue;
+        }
+
+        Vector3 center = proxy.Box.GetCenter();
+        for (int axis = 0; axis < 3; axis++)
+        {
+            proxy.Cell[axis] = (int)floorf(center[axis] * inverseCellSize);
+        }
+
+        int cellIndex = FindOrAddCell(proxy.Cell[0], proxy.Cell[1], proxy.Cell[2]);
+        m_cells[cellIndex].Count++;
+    }
+
+    // Assign each cell a contiguous range of the proxy array. First is set to the end of the
+    // range here, and moves back to the start as the range is filled in.
+    int end = 0;
+    for (size_t c = 0; c < m_occupiedCells.size(); c++)
+    {
+        Cell& cell = m_cells[m_occupiedCells[c]];
+        end += cell.Count;
+        cell.First = end;
+    }
+
+    // Second pass: fill in the proxy array
+    m_cellProxies.resize(end);
+    for (size_t i = 0; i < m_liveProxies.size(); i++)
+    {
+        Proxy& proxy = m_proxies[m_liveProxies[i]];
+        if (proxy.Cell[0] == INT_MAX)
+            continue;
+
+        Cell& cell = m_cells[FindCell(proxy.Cell[0], proxy.Cell[1], proxy.Cell[2])];
+        cell.First--;
+        m_cellProxies[cell.First] = m_liveProxies[i];
+    }
+}
+
+int SpatialHashGrid::FindCell(int x, int y, int z)
+{
+    // Linear probing
+    unsigned int mask = (unsigned int)m_cells.size() - 1;
+    unsigned int index = HashCoords(x, y, z) & mask;
+    while (m_cells[index].Count != 0)
+    {
+        Cell& cell = m_cells[index];
+        if (cell.Coords[0] == x && cell.Coords[1] == y && cell.Coords[2] == z)
+        {
+            return (int)index;
+        }
+        index = (index + 1) & mask;
+    }
+    return -1;
+}
+
+int SpatialHashGrid::FindOrAddCell(int x, int y, int z)
+{
+    unsigned int mask = (unsigned int)m_cells.size() - 1;
+    unsigned int index = HashCoords(x, y, z) & mask;
+    while (m_cells[index].Count != 0)
+    {
+        Cell& cell = m_cells[index];
+        if (cell.Coords[0] == x && cell.Coords[1] == y && cell.Coords[2] == z)
+        {
+            return (int)index;
+        }
+        index = (index + 1) & mask;
+    }
+
+    // Claim the empty slot. The caller increments the count, which marks the slot as used.
+    Cell& cell = m_cells[index];
+    cell.Coords[0] = x;
+    cell.Coords[1] = y;
+    cell.Coords[2] = z;
+    cell.First = 0;
+    m_occupiedCells.push_back((int)index);
+    return (int)index;
+}
+
+unsigned int SpatialHashGrid::HashCoords(int x, int y, int z)
+{
+    return ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u);
+}
\ No newline at end of file
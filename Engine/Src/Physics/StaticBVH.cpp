@@ -0,0 +1,478 @@
+#include "Physics/StaticBVH.h"
+
+#include "Debugging/DebugDraw.h"
+#include "Math/Transformations.h"
+#include "Physics/BroadPhase.h"
+#include "Physics/Collider.h"
+#include "Physics/CollisionEngine.h"
+#include "Physics/CollisionFilter.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Orders colliders by the center of their bounds along one axis
+    struct CentroidComparator
+    {
+        CentroidComparator(const vector<Vector3>& centroids, int axis)
+            : Centroids(centroids), Axis(axis)
+        {}
+
+        bool operator()(int lhs, int rhs) const
+        {
+            return Centroids[lhs][Axis] < Centroids[rhs][Axis];
+        }
+
+        const vector<Vector3>&  Centroids;
+        int                     Axis;
+    };
+
+    // Finds which of the surface area heuristic bins a collider's centroid falls in along one axis
+    struct CentroidBin
+    {
+        CentroidBin(const vector<Vector3>& centroids, int axis, const BoundingBox& centroidBox)
+            : Centroids(centroids), Axis(axis), Min(centroidBox.Min[axis])
+        {
+            float extent = centroidBox.Max[axis] - Min;
+            Scale = extent > 0.0f ? STATIC_BVH_SAH_BINS / extent : 0.0f;
+        }
+
+        int operator()(int collider) const
+        {
+            int bin = (int)((Centroids[collider][Axis] - Min) * Scale);
+            if (bin < 0)                        return 0;
+            if (bin >= STATIC_BVH_SAH_BINS)     return STATIC_BVH_SAH_BINS - 1;
+            return bin;
+        }
+
+        const vector<Vector3>&  Centroids;
+        int                     Axis;
+        float                   Min;
+        float                   Scale;
+    };
+
+    // True for colliders in the bins on the near side of a split
+    struct BelowSplit
+    {
+        BelowSplit(const CentroidBin& bin, int split)
+            : Bin(bin), Split(split)
+        {}
+
+        bool operator()(int collider) const
+        {
+            return Bin(collider) <= Split;
+        }
+
+        const CentroidBin&  Bin;
+        int                 Split;
+    };
+
+    // Finds the split between bins on any axis that leaves the children with the least surface area, weighted by
+    // the number of colliders in each. That's proportional to the expected number of overlap tests below the node.
+    bool FindSplit(int begin, int end, const BoundingBox& centroidBox, const vector<BoundingBox>& bounds,
+                   const vector<Vector3>& centroids, const vector<int>& order, int& bestAxis, int& bestSplit)
+    {
+        float bestCost = 0.0f;
+        bool found = false;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            CentroidBin binOf(centroids, axis, centroidBox);
+            if (binOf.Scale == 0.0f)
+                continue;
+
+            int counts[STATIC_BVH_SAH_BINS] = { 0 };
+            BoundingBox boxes[STATIC_BVH_SAH_BINS];
+            for (int i = begin; i < end; i++)
+            {
+                int bin = binOf(order[i]);
+                boxes[bin] = counts[bin] == 0 ? bounds[order[i]] : BoundingBox(boxes[bin], bounds[order[i]]);
+                counts[bin]++;
+            }
+
+            // Sweep from the far end to get the area and count above each split
+            float aboveAreas[STATIC_BVH_SAH_BINS];
+            int aboveCounts[STATIC_BVH_SAH_BINS];
+            BoundingBox above;
+            int aboveCount = 0;
+            for (int bin = STATIC_BVH_SAH_BINS - 1; bin > 0; bin--)
+            {
+                if (counts[bin] > 0)
+                {
+                    above = aboveCount == 0 ? boxes[bin] : BoundingBox(above, boxes[bin]);
+                    aboveCount += counts[bin];
+                }
+                aboveAreas[bin - 1] = aboveCount > 0 ? above.GetSurfaceArea() : 0.0f;
+                aboveCounts[bin - 1] = aboveCount;
+            }
+
+            BoundingBox below;
+            int belowCount = 0;
+            for (int split = 0; split < STATIC_BVH_SAH_BINS - 1; split++)
+            {
+                if (counts[split] > 0)
+                {
+                    below = belowCount == 0 ? boxes[split] : BoundingBox(below, boxes[split]);
+                    belowCount += counts[split];
+                }
+                if (belowCount == 0 || aboveCounts[split] == 0)
+                    continue;
+
+                float cost = below.GetSurfaceArea() * belowCount + aboveAreas[split] * aboveCounts[split];
+                if (!found || cost < bestCost)
+                {
+                    bestAxis = axis;
+                    bestSplit = split;
+                    bestCost = cost;
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+}
+
+StaticBVH::StaticBVH()
+    : m_colliderCount(0), m_changeCount(0)
+{}
+
+void StaticBVH::Build(const vector<Collider*>& colliders)
+{
+    Clear();
+
+    int colliderCount = colliders.size();
+    if (colliderCount == 0)
+        return;
+
+    vector<BoundingBox> bounds(colliderCount);
+    vector<Vector3> centroids(colliderCount);
+    vector<int> order(colliderCount);
+    for (int i = 0; i < colliderCount; i++)
+    {
+        bounds[i] = BoundingBox(colliders[i]);
+        centroids[i] = bounds[i].GetCenter();
+        order[i] = i;
+    }
+
+    // A binary tree with one collider per leaf has one node fewer than twice as many colliders
+    m_nodes.reserve(colliderCount * 2);
+    m_colliders.reserve(colliderCount * 2);
+    m_nodes.resize(1);
+    m_colliders.resize(1, NULL);
+    m_nodes[0].Parent = -1;
+    BuildNode(0, 0, colliderCount, 0, bounds, centroids, order, colliders);
+
+    m_colliderCount = colliderCount;
+}
+
+void StaticBVH::Clear()
+{
+    for (size_t i = 0; i < m_colliders.size(); i++)
+    {
+        if (m_colliders[i] != NULL)
+            m_colliders[i]->SetHierarchyProxy(-1);
+    }
+
+    m_nodes.clear();
+    m_colliders.clear();
+    m_freePairs.clear();
+    m_colliderCount = 0;
+    m_changeCount = 0;
+}
+
+void StaticBVH::Insert(Collider* collider)
+{
+    if (collider == NULL || collider->GetHierarchyProxy() != -1)
+        return;
+
+    BoundingBox box(collider);
+    m_colliderCount++;
+    m_changeCount++;
+
+    if (m_nodes.empty())
+    {
+        m_nodes.resize(1);
+        m_colliders.resize(1, NULL);
+        m_nodes[0].Parent = -1;
+        SetLeaf(0, box, collider);
+        return;
+    }
+
+    // Descend into the child whose surface area grows the least
+    int index = 0;
+    while (!m_nodes[index].IsLeaf())
+    {
+        int first = m_nodes[index].Child;
+        BoundingBox& firstBox = m_nodes[first].Box;
+        BoundingBox& secondBox = m_nodes[first + 1].Box;
+        float firstGrowth = BoundingBox(firstBox, box).GetSurfaceArea() - firstBox.GetSurfaceArea();
+        float secondGrowth = BoundingBox(secondBox, box).GetSurfaceArea() - secondBox.GetSurfaceArea();
+        index = firstGrowth <= secondGrowth ? first : first + 1;
+    }
+
+    // Turn the leaf into the parent of its old collider and the new one
+    int child = AllocatePair(index);
+    SetLeaf(child, m_nodes[index].Box, m_colliders[index]);
+    SetLeaf(child + 1, box, collider);
+    m_colliders[index] = NULL;
+    m_nodes[index].Child = child;
+    Refit(index);
+}
+
+void StaticBVH::Remove(Collider* collider)
+{
+    if (collider == NULL || collider->GetHierarchyProxy() == -1)
+        return;
+
+    int leaf = collider->GetHierarchyProxy();
+    collider->SetHierarchyProxy(-1);
+    m_colliders[leaf] = NULL;
+    m_colliderCount--;
+    m_changeCount++;
+
+    // The root is only a leaf when it holds the last collider
+    if (leaf == 0)
+    {
+        m_nodes.clear();
+        m_colliders.clear();
+        m_freePairs.clear();
+        return;
+    }
+
+    // Move the sibling up into the parent, which frees the pair
+    int parent = m_nodes[leaf].Parent;
+    int first = m_nodes[parent].Child;
+    int sibling = leaf == first ? first + 1 : first;
+    Node& siblingNode = m_nodes[sibling];
+    if (siblingNode.IsLeaf())
+    {
+        SetLeaf(parent, siblingNode.Box, m_colliders[sibling]);
+        m_colliders[sibling] = NULL;
+    }
+    else
+    {
+        m_nodes[parent].Box = siblingNode.Box;
+        m_nodes[parent].Child = siblingNode.Child;
+        m_nodes[siblingNode.Child].Parent = parent;
+        m_nodes[siblingNode.Child + 1].Parent = parent;
+    }
+    m_freePairs.push_back(first);
+
+    Refit(m_nodes[parent].Parent);
+}
+
+unsigned int StaticBVH::GetChangeCount()
+{
+    return m_changeCount;
+}
+
+unsigned int StaticBVH::GetColliderCount()
+{
+    return m_colliderCount;
+}
+
+unsigned int StaticBVH::GetPotentialContacts(Collider* collider, const BoundingBox& box, vector<PotentialContact>& contacts, CollisionFilter* filter)
+{
+    if (m_nodes.empty())
+        return 0;
+
+    unsigned int count = 0;
+    m_stack.clear();
+    m_stack.push_back(0);
+    while (!m_stack.empty())
+    {
+        int index = m_stack.back();
+        m_stack.pop_back();
+
+        Node& node = m_nodes[index];
+        if (!node.Box.Overlaps(&box))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            Collider* other = m_colliders[index];
+            if (other == collider || (filter != NULL && !filter->ShouldCollide(collider, other)))
+                continue;
+
+            contacts.push_back(PotentialContact(collider, other));
+            count++;
+        }
+        else
+        {
+            m_stack.push_back(node.Child + 1);
+            m_stack.push_back(node.Child);
+        }
+    }
+    return count;
+}
+
+void StaticBVH::QueryBox(const BoundingBox& box, vector<Collider*>& results)
+{
+    if (m_nodes.empty())
+        return;
+
+    m_stack.clear();
+    m_stack.push_back(0);
+    while (!m_stack.empty())
+    {
+        int index = m_stack.back();
+        m_stack.pop_back();
+
+        Node& node = m_nodes[index];
+        if (!node.Box.Overlaps(&box))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            results.push_back(m_colliders[index]);
+        }
+        else
+        {
+            m_stack.push_back(node.Child + 1);
+            m_stack.push_back(node.Child);
+        }
+    }
+}
+
+float StaticBVH::QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, BroadPhaseRayCallback* callback)
+{
+    if (m_nodes.empty())
+        return maxDistance;
+
+    Vector3 inverseDirection(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+
+    m_stack.clear();
+    m_stack.push_back(0);
+    while (!m_stack.empty())
+    {
+        int index = m_stack.back();
+        m_stack.pop_back();
+
+        // Tested again when popped, since the ray may have been shortened after the node was pushed
+        Node& node = m_nodes[index];
+        float entryDistance;
+        if (!node.Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, entryDistance))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            maxDistance = callback->RayTest(m_colliders[index], maxDistance);
+            continue;
+        }
+
+        int first = node.Child;
+        int second = node.Child + 1;
+        float firstEntry, secondEntry;
+        bool hitFirst = m_nodes[first].Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, firstEntry);
+        bool hitSecond = m_nodes[second].Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, secondEntry);
+        if (hitFirst && hitSecond && secondEntry < firstEntry)
+        {
+            m_stack.push_back(first);
+            m_stack.push_back(second);
+        }
+        else
+        {
+            if (hitSecond)  m_stack.push_back(second);
+            if (hitFirst)   m_stack.push_back(first);
+        }
+    }
+    return maxDistance;
+}
+
+void StaticBVH::DrawDebugInfo(ColorRGB color)
+{
+    for (size_t i = 0; i < m_colliders.size(); i++)
+    {
+        if (m_colliders[i] == NULL)
+            continue;
+
+        BoundingBox& box = m_nodes[i].Box;
+        Matrix4x4 boxMatrix = Translation(box.GetCenter());
+        boxMatrix = boxMatrix * Scaling(box.GetHalfsize());
+        DebugDraw::Singleton().DrawCube(boxMatrix, color);
+    }
+}
+
+void StaticBVH::BuildNode(int index, int begin, int end, int depth, vector<BoundingBox>& bounds, vector<Vector3>& centroids,
+                          vector<int>& order, const vector<Collider*>& colliders)
+{
+    if (end - begin == 1)
+    {
+        SetLeaf(index, bounds[order[begin]], colliders[order[begin]]);
+        return;
+    }
+
+    BoundingBox box = bounds[order[begin]];
+    BoundingBox centroidBox(centroids[order[begin]], centroids[order[begin]]);
+    for (int i = begin + 1; i < end; i++)
+    {
+        box = BoundingBox(box, bounds[order[i]]);
+        centroidBox = BoundingBox(centroidBox, BoundingBox(centroids[order[i]], centroids[order[i]]));
+    }
+
+    int axis, split;
+    int middle;
+    if (depth < STATIC_BVH_SAH_MAX_DEPTH && FindSplit(begin, end, centroidBox, bounds, centroids, order, axis, split))
+    {
+        CentroidBin binOf(centroids, axis, centroidBox);
+        middle = std::partition(order.begin() + begin, order.begin() + end, BelowSplit(binOf, split)) - order.begin();
+    }
+    else
+    {
+        // Split at the median along the longest axis, which also handles colliders with the same center
+        Vector3 extent = centroidBox.Max - centroidBox.Min;
+        axis = 0;
+        if (extent[1] > extent[axis])   axis = 1;
+        if (extent[2] > extent[axis])   axis = 2;
+
+        middle = (begin + end) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, CentroidComparator(centroids, axis));
+    }
+
+    int child = AllocatePair(index);
+    m_nodes[index].Box = box;
+    m_nodes[index].Child = child;
+    BuildNode(child, begin, middle, depth + 1, bounds, centroids, order, colliders);
+    BuildNode(child + 1, middle, end, depth + 1, bounds, centroids, order, colliders);
+}
+
+void StaticBVH::SetLeaf(int index, const BoundingBox& box, Collider* collider)
+{
+    m_nodes[index].Box = box;
+    m_nodes[index].Child = -1;
+    m_colliders[index] = collider;
+    collider->SetHierarchyProxy(index);
+}
+
+int StaticBVH::AllocatePair(int parent)
+{
+    int first;
+    if (m_freePairs.empty())
+    {
+        first = m_nodes.size();
+        m_nodes.resize(first + 2);
+        m_colliders.resize(first + 2, NULL);
+    }
+    else
+    {
+        first = m_freePairs.back();
+        m_freePairs.pop_back();
+    }
+
+    for (int i = first; i < first + 2; i++)
+    {
+        m_nodes[i].Child = -1;
+        m_nodes[i].Parent = parent;
+    }
+    return first;
+}
+
+void StaticBVH::Refit(int index)
+{
+    while (index != -1)
+    {
+        Node& node = m_nodes[index];
+        node.Box = BoundingBox(m_nodes[node.Child].Box, m_nodes[node.Child + 1].Box);
+        index = node.Parent;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "Physics/SweepAndPrune.h"
+
+#include "Debugging/DebugDraw.h"
+#include "Math/Transformations.h"
+#include "Physics/Collider.h"
+#include "Physics/CollisionEngine.h"
+#include "Physics/CollisionFilter.h"
+
+#include <algorithm>
+
+#define SWEEP_AXIS_SWITCH_RATIO 1.5f    // How much more spread out another axis must be before the sweep moves to it
+
+const float SweepAndPrune::FAT_BOX_MARGIN = 0.1f;
+const float SweepAndPrune::DISPLACEMENT_MULTIPLIER = 2.0f;
+
+namespace
+{
+    // Orders endpoints by value, with min endpoints first when values are equal so that touching boxes are
+    // reported as overlapping
+    struct EndpointLess
+    {
+        template<class EndpointType>
+        bool operator()(const EndpointType& lhs, const EndpointType& rhs) const
+        {
+            return lhs.Value < rhs.Value || (lhs.Value == rhs.Value && lhs.IsMin && !rhs.IsMin);
+        }
+    };
+}
+
+SweepAndPrune::SweepAndPrune()
+    : m_proxyCount(0), m_sweepAxis(0), m_endpointsDirty(false)
+{}
+
+void SweepAndPrune::AddCollider(Collider* collider)
+{
+    if (collider == NULL || collider->GetBroadPhaseProxy() != -1)
+        return;
+
+    // Reuse a free proxy slot if possible
+    int proxy;
+    if (!m_freeProxies.empty())
+    {
+        proxy = m_freeProxies.back();
+        m_freeProxies.pop_back();
+    }
+    else
+    {
+        proxy = (int)m_proxies.size();
+        m_proxies.push_back(Proxy());
+    }
+
+    m_proxies[proxy].Box = BoundingBox(collider);
+    m_proxies[proxy].Box.Expand(FAT_BOX_MARGIN);
+    m_proxies[proxy].Object = collider;
+    m_proxies[proxy].ActiveIndex = -1;
+    collider->SetBroadPhaseProxy(proxy);
+    m_proxyCount++;
+
+    // Append the new endpoints, and let the next sort move them into place
+    Endpoint minPoint = { m_proxies[proxy].Box.Min[m_sweepAxis], proxy, true };
+    Endpoint maxPoint = { m_proxies[proxy].Box.Max[m_sweepAxis], proxy, false };
+    m_endpoints.push_back(minPoint);
+    m_endpoints.push_back(maxPoint);
+    m_endpointsDirty = true;
+}
+
+void SweepAndPrune::RemoveCollider(Collider* collider)
+{
+    if (collider == NULL || collider->GetBroadPhaseProxy() == -1)
+        return;
+
+    int proxy = collider->GetBroadPhaseProxy();
+
+    // Remove the endpoints, preserving the order of the others
+    size_t write = 0;
+    for (size_t read = 0; read < m_endpoints.size(); read++)
+    {
+        if (m_endpoints[read].Proxy != proxy)
+        {
+            m_endpoints[write++] = m_endpoints[read];
+        }
+    }
+    m_endpoints.resize(write);
+
+    m_proxies[proxy].Object = NULL;
+    m_freeProxies.push_back(proxy);
+    collider->SetBroadPhaseProxy(-1);
+    m_proxyCount--;
+}
+
+void SweepAndPrune::UpdateCollider(Collider* collider, const BoundingBox& box, const Vector3& displacement)
+{
+    // If the collider is still inside its fat box, its endpoints don't change
+    BoundingBox& fatBox = m_proxies[collider->GetBroadPhaseProxy()].Box;
+    if (fatBox.Contains(&box))
+        return;
+
+    fatBox = box;
+    fatBox.Expand(FAT_BOX_MARGIN);
+    fatBox.ExpandByDisplacement(displacement * DISPLACEMENT_MULTIPLIER);
+    m_endpointsDirty = true;
+}
+
+unsigned int SweepAndPrune::GetPotentialContacts(vector<PotentialContact>& contacts, CollisionFilter* filter)
+{
+    // Only the sweep axis is kept sorted. When the best axis changes, the list is sorted from scratch, since its
+    // order along the old axis says nothing about the order along the new one.
+    int sweepAxis = ChooseSweepAxis();
+    if (sweepAxis != m_sweepAxis)
+    {
+        m_sweepAxis = sweepAxis;
+        RefreshEndpoints();
+        std::sort(m_endpoints.begin(), m_endpoints.end(), EndpointLess());
+        m_endpointsDirty = false;
+    }
+    else if (m_endpointsDirty)
+    {
+        RefreshEndpoints();
+        SortEndpoints();
+        m_endpointsDirty = false;
+    }
+
+    // Any collider whose interval is open when another one opens overlaps it along the sweep
+    // axis, so only those need to be tested on the remaining axes.
+    unsigned int count = 0;
+    m_active.clear();
+    for (size_t i = 0; i < m_endpoints.size(); i++)
+    {
+        int proxy = m_endpoints[i].Proxy;
+        if (m_endpoints[i].IsMin)
+        {
+            for (size_t j = 0; j < m_active.size(); j++)
+            {
+                int other = m_active[j];
+                if (m_proxies[proxy].Box.Overlaps(&m_proxies[other].Box) &&
+                    (filter == NULL || filter->ShouldCollide(m_proxies[other].Object, m_proxies[proxy].Object)))
+                {
+                    contacts.push_back(PotentialContact(m_proxies[other].Object, m_proxies[proxy].Object));
+                    count++;
+                }
+            }
+
+            m_proxies[proxy].ActiveIndex = (int)m_active.size();
+            m_active.push_back(proxy);
+        }
+        else
+        {
+            // Swap-remove from the active list
+            int activeIndex = m_proxies[proxy].ActiveIndex;
+            int last = m_active.back();
+            m_active[activeIndex] = last;
+            m_proxies[last].ActiveIndex = activeIndex;
+            m_active.pop_back();
+            m_proxies[proxy].ActiveIndex = -1;
+        }
+    }
+
+    return count;
+}
+
+void SweepAndPrune::QueryBox(const BoundingBox& box, vector<Collider*>& results)
+{
+    // The endpoint lists are only kept sorted for pair generation, so queries test every proxy
+    for (size_t i = 0; i < m_proxies.size(); i++)
+    {
+        if (m_proxies[i].Object != NULL && m_proxies[i].Box.Overlaps(&box))
+        {
+            results.push_back(m_proxies[i].Object);
+        }
+    }
+}
+
+void SweepAndPrune::QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, BroadPhaseRayCallback* callback)
+{
+    Vector3 inverseDirection(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+    for (size_t i = 0; i < m_proxies.size(); i++)
+    {
+        float entryDistance;
+        if (m_proxies[i].Object != NULL && m_proxies[i].Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, entryDistance))
+        {
+            maxDistance = callback->RayTest(m_proxies[i].Object, maxDistance);
+        }
+    }
+}
+
+void SweepAndPrune::DrawDebugInfo(ColorRGB color)
+{
+    for (size_t i = 0; i < m_proxies.size(); i++)
+    {
+        if (m_proxies[i].Object == NULL)
+            continue;
+
+        BoundingBox& box = m_proxies[i].Box;
+        Matrix4x4 boxMatrix = Translation(box.GetCenter());
+        boxMatrix = boxMatrix * Scaling(box.GetHalfsize());
+        DebugDraw::Singleton().DrawCube(boxMatrix, color);
+    }
+}
+
+void SweepAndPrune::RefreshEndpoints()
+{
+    for (size_t i = 0; i < m_endpoints.size(); i++)
+    {
+        BoundingBox& box = m_proxies[m_endpoints[i].Proxy].Box;
+        m_endpoints[i].Value = m_endpoints[i].IsMin ? box.Min[m_sweepAxis] : box.Max[m_sweepAxis];
+    }
+}
+
+void SweepAndPrune::SortEndpoints()
+{
+    // Insertion sort, which is close to linear for nearly sorted lists
+    EndpointLess less;
+    for (size_t i = 1; i < m_endpoints.size(); i++)
+    {
+        Endpoint key = m_endpoints[i];
+        size_t j = i;
+        while (j > 0 && less(key, m_endpoints[j - 1]))
+        {
+            m_endpoints[j] = m_endpoints[j - 1];
+            j--;
+        }
+        m_endpoints[j] = key;
+    }
+}
+
+int SweepAndPrune::ChooseSweepAxis()
+{
+    if (m_proxyCount == 0)
+        return 0;
+
+    // Sweep along the axis with the largest variance of box centers, since it separates the most boxes
+    Vector3 sum = Vector3::Zero;
+    Vector3 sumSqrd = Vector3::Zero;
+    for (size_t i = 0; i < m_proxies.size(); i++)
+    {
+        if (m_proxies[i].Object == NULL)
+            continue;
+
+        Vector3 center = m_proxies[i].Box.GetCenter();
+        sum += center;
+        sumSqrd += center.ComponentwiseProduct(center);
+    }
+
+    float inverseCount = 1.0f / m_proxyCount;
+    float variances[3];
+    int bestAxis = 0;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float mean = sum[axis] * inverseCount;
+        variances[axis] = sumSqrd[axis] * inverseCount - mean * mean;
+        if (variances[axis] > variances[bestAxis])
+        {
+            bestAxis = axis;
+        }
+    }
+
+    // Changing axis means a full sort, so only change when another axis is clearly better
+    if (variances[bestAxis] <= SWEEP_AXIS_SWITCH_RATIO * variances[m_sweepAxis])
+        return m_sweepAxis;
+    return bestAxis;
+}
\ No newline at end of file
@@ -0,0 +1,381 @@
+#include "Physics/TriangleBVH.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Orders triangles by the position of their centroid along one axis
+    struct CentroidComparator
+    {
+        CentroidComparator(const vector<Vector3>& centroids, int axis)
+            : Centroids(centroids), Axis(axis)
+        {}
+
+        bool operator()(int lhs, int rhs) const
+        {
+            return Centroids[lhs][Axis] < Centroids[rhs][Axis];
+        }
+
+        const vector<Vector3>&  Centroids;
+        int                     Axis;
+    };
+
+    // Finds which of the surface area heuristic bins a triangle's centroid falls in along one axis
+    struct CentroidBin
+    {
+        CentroidBin(const vector<Vector3>& centroids, int axis, const BoundingBox& centroidBox)
+            : Centroids(centroids), Axis(axis), Min(centroidBox.Min[axis])
+        {
+            float extent = centroidBox.Max[axis] - Min;
+            Scale = extent > 0.0f ? TRIANGLE_BVH_SAH_BINS / extent : 0.0f;
+        }
+
+        int operator()(int triangle) const
+        {
+            int bin = (int)((Centroids[triangle][Axis] - Min) * Scale);
+            if (bin < 0)                        return 0;
+            if (bin >= TRIANGLE_BVH_SAH_BINS)   return TRIANGLE_BVH_SAH_BINS - 1;
+            return bin;
+        }
+
+        const vector<Vector3>&  Centroids;
+        int                     Axis;
+        float                   Min;
+        float                   Scale;
+    };
+
+    // True for triangles in the bins on the near side of a split
+    struct BelowSplit
+    {
+        BelowSplit(const CentroidBin& bin, int split)
+            : Bin(bin), Split(split)
+        {}
+
+        bool operator()(int triangle) const
+        {
+            return Bin(triangle) <= Split;
+        }
+
+        const CentroidBin&  Bin;
+        int                 Split;
+    };
+
+    // Finds the cheapest split between bins on any axis. The cost is that of testing a node (taken as one
+    // triangle test) plus the triangle tests of the children, weighted by the chance of a ray reaching them.
+    bool FindSplit(int begin, int end, const BoundingBox& box, const BoundingBox& centroidBox, const vector<BoundingBox>& bounds,
+                   const vector<Vector3>& centroids, const vector<int>& order, int& bestAxis, int& bestSplit, float& bestCost)
+    {
+        float area = box.GetSurfaceArea();
+        float inverseArea = area > 0.0f ? 1.0f / area : 0.0f;
+        bool found = false;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            CentroidBin binOf(centroids, axis, centroidBox);
+            if (binOf.Scale == 0.0f)
+                continue;
+
+            int counts[TRIANGLE_BVH_SAH_BINS] = { 0 };
+            BoundingBox boxes[TRIANGLE_BVH_SAH_BINS];
+            for (int i = begin; i < end; i++)
+            {
+                int bin = binOf(order[i]);
+                boxes[bin] = counts[bin] == 0 ? bounds[order[i]] : BoundingBox(boxes[bin], bounds[order[i]]);
+                counts[bin]++;
+            }
+
+            // Sweep from the far end to get the area and count above each split
+            float aboveAreas[TRIANGLE_BVH_SAH_BINS];
+            int aboveCounts[TRIANGLE_BVH_SAH_BINS];
+            BoundingBox above;
+            int aboveCount = 0;
+            for (int bin = TRIANGLE_BVH_SAH_BINS - 1; bin > 0; bin--)
+            {
+                if (counts[bin] > 0)
+                {
+                    above = aboveCount == 0 ? boxes[bin] : BoundingBox(above, boxes[bin]);
+                    aboveCount += counts[bin];
+                }
+                aboveAreas[bin - 1] = aboveCount > 0 ? above.GetSurfaceArea() : 0.0f;
+                aboveCounts[bin - 1] = aboveCount;
+            }
+
+            BoundingBox below;
+            int belowCount = 0;
+            for (int split = 0; split < TRIANGLE_BVH_SAH_BINS - 1; split++)
+            {
+                if (counts[split] > 0)
+                {
+                    below = belowCount == 0 ? boxes[split] : BoundingBox(below, boxes[split]);
+                    belowCount += counts[split];
+                }
+                if (belowCount == 0 || aboveCounts[split] == 0)
+                    continue;
+
+                float cost = 1.0f + (below.GetSurfaceArea() * belowCount + aboveAreas[split] * aboveCounts[split]) * inverseArea;
+                if (!found || cost < bestCost)
+                {
+                    bestAxis = axis;
+                    bestSplit = split;
+                    bestCost = cost;
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+}
+
+TriangleBVH::TriangleBVH(const vector<Vector3>& positions, const vector<unsigned int>& indices)
+{
+    int triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    vector<BoundingBox> bounds(triangleCount);
+    vector<Vector3> centroids(triangleCount);
+    vector<int> order(triangleCount);
+    for (int i = 0; i < triangleCount; i++)
+    {
+        const Vector3& a = positions[indices[i * 3]];
+        const Vector3& b = positions[indices[i * 3 + 1]];
+        const Vector3& c = positions[indices[i * 3 + 2]];
+
+        bounds[i] = BoundingBox(BoundingBox(a, a), BoundingBox(b, b));
+        bounds[i] = BoundingBox(bounds[i], BoundingBox(c, c));
+        centroids[i] = (a + b + c) * (1.0f / 3.0f);
+        order[i] = i;
+    }
+
+    // A binary tree with at least one triangle per leaf has fewer than twice as many nodes as triangles
+    m_nodes.reserve(triangleCount * 2);
+    BuildNode(0, triangleCount, 0, bounds, centroids, order);
+
+    // Copy the triangles into the order the leaves reference them
+    m_vertices.resize(triangleCount * 3);
+    for (int i = 0; i < triangleCount; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            m_vertices[i * 3 + j] = positions[indices[order[i] * 3 + j]];
+        }
+    }
+}
+
+void TriangleBVH::Query(const BoundingBox& box, vector<int>& results) const
+{
+    if (m_nodes.size() == 0)
+        return;
+
+    int stack[TRIANGLE_BVH_MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        int index = stack[--stackSize];
+        const Node& node = m_nodes[index];
+        if (!node.Box.Overlaps(&box))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            for (int i = node.Start; i < node.Start + node.Count; i++)
+            {
+                results.push_back(i);
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.Start;
+            stack[stackSize++] = index + 1;
+        }
+    }
+}
+
+bool TriangleBVH::Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, float& hitDistance, int& hitTriangle) const
+{
+    if (m_nodes.size() == 0)
+        return false;
+
+    Vector3 inverseDirection(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+    bool hit = false;
+
+    int stack[TRIANGLE_BVH_MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        int index = stack[--stackSize];
+        const Node& node = m_nodes[index];
+        float entryDistance;
+        if (!node.Box.IntersectsRay(origin, inverseDirection, maxDistance, 0.0f, entryDistance))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            for (int i = node.Start; i < node.Start + node.Count; i++)
+            {
+                float distance;
+                if (IntersectTriangle(origin, direction, &m_vertices[i * 3], distance) && distance < maxDistance)
+                {
+                    // Later nodes only need to be searched up to the closest hit so far
+                    maxDistance = distance;
+                    hitDistance = distance;
+                    hitTriangle = i;
+                    hit = true;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first, so that a hit there can rule out the farther one
+        int first = index + 1;
+        int second = node.Start;
+        float firstEntry, secondEntry;
+        bool hitFirst = m_nodes[first].Box.IntersectsRay(origin, inverseDirection, maxDistance, 0.0f, firstEntry);
+        bool hitSecond = m_nodes[second].Box.IntersectsRay(origin, inverseDirection, maxDistance, 0.0f, secondEntry);
+        if (hitFirst && hitSecond && secondEntry < firstEntry)
+        {
+            stack[stackSize++] = first;
+            stack[stackSize++] = second;
+        }
+        else
+        {
+            if (hitSecond)  stack[stackSize++] = second;
+            if (hitFirst)   stack[stackSize++] = first;
+        }
+    }
+
+    return hit;
+}
+
+void TriangleBVH::QueryRay(const Vector3& origin, const Vector3& direction, float maxDistance, float margin, vector<int>& results) const
+{
+    if (m_nodes.size() == 0)
+        return;
+
+    Vector3 inverseDirection(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+
+    int stack[TRIANGLE_BVH_MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        int index = stack[--stackSize];
+        const Node& node = m_nodes[index];
+        float entryDistance;
+        if (!node.Box.IntersectsRay(origin, inverseDirection, maxDistance, margin, entryDistance))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            for (int i = node.Start; i < node.Start + node.Count; i++)
+            {
+                results.push_back(i);
+            }
+        }
+        else
+        {
+            stack[stackSize++] = node.Start;
+            stack[stackSize++] = index + 1;
+        }
+    }
+}
+
+int TriangleBVH::GetTriangleCount() const
+{
+    return m_vertices.size() / 3;
+}
+
+void TriangleBVH::GetTriangle(int index, Vector3* triangle) const
+{
+    triangle[0] = m_vertices[index * 3];
+    triangle[1] = m_vertices[index * 3 + 1];
+    triangle[2] = m_vertices[index * 3 + 2];
+}
+
+const BoundingBox& TriangleBVH::GetBounds() const
+{
+    return m_nodes[0].Box;
+}
+
+bool TriangleBVH::IntersectTriangle(const Vector3& origin, const Vector3& direction, const Vector3* triangle, float& distance)
+{
+    // Moller-Trumbore, hitting either side of the triangle
+    Vector3 edge1 = triangle[1] - triangle[0];
+    Vector3 edge2 = triangle[2] - triangle[0];
+    Vector3 h = direction.Cross(edge2);
+    float a = edge1.Dot(h);
+    if (fabsf(a) < 1e-12f)
+        return false;
+
+    float f = 1.0f / a;
+    Vector3 s = origin - triangle[0];
+    float u = f * s.Dot(h);
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    Vector3 q = s.Cross(edge1);
+    float v = f * direction.Dot(q);
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    distance = f * edge2.Dot(q);
+    return distance >= 0.0f;
+}
+
+void TriangleBVH::BuildNode(int begin, int end, int depth, vector<BoundingBox>& bounds, vector<Vector3>& centroids, vector<int>& order)
+{
+    int nodeIndex = m_nodes.size();
+    m_nodes.push_back(Node());
+
+    BoundingBox box = bounds[order[begin]];
+    BoundingBox centroidBox(centroids[order[begin]], centroids[order[begin]]);
+    for (int i = begin + 1; i < end; i++)
+    {
+        box = BoundingBox(box, bounds[order[i]]);
+        centroidBox = BoundingBox(centroidBox, BoundingBox(centroids[order[i]], centroids[order[i]]));
+    }
+    m_nodes[nodeIndex].Box = box;
+
+    int count = end - begin;
+    int axis = 0;
+    int split = 0;
+    float cost = 0.0f;
+    bool hasSplit = count > TRIANGLE_BVH_LEAF_SIZE && depth < TRIANGLE_BVH_SAH_MAX_DEPTH
+        && FindSplit(begin, end, box, centroidBox, bounds, centroids, order, axis, split, cost);
+
+    // Keep small nodes as leaves when no split is cheaper than testing all of their triangles
+    if (count <= TRIANGLE_BVH_LEAF_SIZE || (hasSplit && cost >= count && count <= TRIANGLE_BVH_MAX_LEAF_SIZE))
+    {
+        m_nodes[nodeIndex].Start = begin;
+        m_nodes[nodeIndex].Count = count;
+        return;
+    }
+
+    int middle;
+    if (hasSplit)
+    {
+        CentroidBin binOf(centroids, axis, centroidBox);
+        middle = std::partition(order.begin() + begin, order.begin() + end, BelowSplit(binOf, split)) - order.begin();
+    }
+    else
+    {
+        // Split at the median centroid along the axis the centroids are most spread out on. This happens deep in
+        // the tree, where it keeps the depth within the traversal stack, and when all centroids are in one spot.
+        Vector3 extents = centroidBox.Max - centroidBox.Min;
+        if (extents.y() > extents[axis])    axis = 1;
+        if (extents.z() > extents[axis])    axis = 2;
+
+        middle = (begin + end) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, CentroidComparator(centroids, axis));
+    }
+
+    m_nodes[nodeIndex].Count = 0;
+    BuildNode(begin, middle, depth + 1, bounds, centroids, order);
+    m_nodes[nodeIndex].Start = m_nodes.size();
+    BuildNode(middle, end, depth + 1, bounds, centroids, order);
+}
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "Rendering\Mesh.h"
 
+#include "GameProject.h"
 #include "Debugging\DebugDraw.h"
+#include "Physics\TriangleBVH.h"
 #include "Rendering\Image.h"
 #include "Rendering\Material.h"
 #include "Rendering\ModelLoading.h"
@@ -18,6 +20,7 @@ Mesh::Mesh(std::string path, ResourceInfo* resourceInfo)
 {
     m_drawMode = GL_TRIANGLES;
     m_resourceInfo = resourceInfo;
+    m_triangleBVH = NULL;
 
     std::vector<Vector3> normals;
     std::vector<Vector2> uvs;
@@ -29,6 +32,11 @@ Mesh::Mesh(std::string path, ResourceInfo* resourceInfo)
     m_indexedVertexCount = m_indices.size();
     m_hasUVs = uvs.size() > 0;
 
+    // In headless mode only the CPU-side data is kept (e.g. for physics)
+    m_uploaded = !GameProject::Singleton().IsHeadless();
+    if (!m_uploaded)
+        return;
+
     // Bind buffer data
     glGenVertexArrays(1, &m_vao);
     glBindVertexArray(m_vao);
@@ -81,6 +89,15 @@ void Mesh::Render(Transform& transform, Material* material, bool wireframe)
 
 void Mesh::Delete()
 {
+    if (m_triangleBVH != NULL)
+    {
+        delete m_triangleBVH;
+        m_triangleBVH = NULL;
+    }
+
+    if (!m_uploaded)
+        return;
+
     glDeleteVertexArrays(1, &m_vao);
     glDeleteBuffers(1, &m_vboPosition);
     glDeleteBuffers(1, &m_vboNormal);
@@ -113,6 +130,15 @@ void Mesh::GetTriangle(int index, Vector3* triangle)
     }
 }
 
+TriangleBVH* Mesh::GetTriangleBVH()
+{
+    if (m_triangleBVH == NULL)
+    {
+        m_triangleBVH = new TriangleBVH(m_positions, m_indices);
+    }
+    return m_triangleBVH;
+}
+
 void Mesh::CalculateBoundingRadius(std::vector<Vector3>& vertices)
 {
     // Find the vertex with the max distance from the center of the object
@@ -32,6 +32,11 @@ struct TextureResourceInfo : ResourceInfo
         return "Texture";
     }
 
+    virtual bool RequiresRenderer()
+    {
+        return true;
+    }
+
     virtual void AddToGameObject(ToolsideGameObject* gameObject)
     {
         // Do nothing here. Textures need to be set as specific material or component param references
@@ -109,6 +114,11 @@ struct ShaderResourceInfo : ResourceInfo
         return "Shader";
     }
 
+    virtual bool RequiresRenderer()
+    {
+        return true;
+    }
+
     virtual void AddToGameObject(ToolsideGameObject* gameObject)
     {
         MeshInstance* meshInstance = gameObject->GetMeshInstance();
@@ -457,7 +467,11 @@ void ResourceManager::LoadSceneResources(HierarchicalDeserializer* deserializer)
         unsigned int guid;
         deserializer->GetAttribute("guid", guid);
         ResourceInfo* info = m_resourceMap[guid];
-        if (info)
+        if (info && info->RequiresRenderer() && GameProject::Singleton().IsHeadless())
+        {
+            printf("Skipping guid %u (headless)\n", guid);
+        }
+        else if (info)
         {
             printf("Loading guid %u\n", guid);
             m_loadedResources[guid] = info->Load();
@@ -87,6 +87,9 @@ Scene* Scene::Load(string filename)
     // Build the game object hierarchy
     scene->LoadHierarchy(&deserializer);
 
+    // Build the static collision hierarchy in one go, now that every static collider is registered and in place
+    CollisionEngine::Singleton().BuildStaticHierarchy();
+
     printf("DONE LOADING SCENE!\n");
 
     scene->m_loaded = true;
@@ -174,6 +177,11 @@ bool Scene::IsLoaded()
     return m_loaded;
 }
 
+string Scene::GetFilename()
+{
+    return m_filename;
+}
+
 
 void Scene::SaveGlobalSettings(HierarchicalSerializer* serializer)
 {
@@ -205,7 +213,7 @@ void Scene::SaveHierarchy(HierarchicalSerializer* serializer, ToolsideGameObject
     // Serialize components
     SaveTransform(serializer, gameObject);
     SaveMesh(serializer, gameObject, guids);
-    SaveColliders(serializer, gameObject);
+    SaveColliders(serializer, gameObject, guids);
     SaveRigidBodies(serializer, gameObject);
     SaveComponents(serializer, gameObject, guids);
 
@@ -321,7 +329,7 @@ void Scene::SaveMaterialTextures(HierarchicalSerializer* serializer, Material* m
     }
 }
 
-void Scene::SaveColliders(HierarchicalSerializer* serializer, ToolsideGameObject* gameObject)
+void Scene::SaveColliders(HierarchicalSerializer* serializer, ToolsideGameObject* gameObject, unordered_set<unsigned int>& guids)
 {
     if (gameObject == NULL)
         return;
@@ -334,6 +342,12 @@ void Scene::SaveColliders(HierarchicalSerializer* serializer, ToolsideGameObject
     {
         Collider* collider = *iter;
         collider->Save(serializer);
+
+        // Mesh colliders may reference a different mesh than the one that is rendered
+        if (collider->GetType() == Collider::MESH_COLLIDER && ((MeshCollider*)collider)->GetMesh() != NULL)
+        {
+            guids.insert(((MeshCollider*)collider)->GetMesh()->GetResourceInfo()->guid);
+        }
     }
 
     serializer->PopScope();
@@ -533,6 +547,10 @@ void Scene::LoadMaterial(HierarchicalDeserializer* deserializer, MeshInstance* m
     if (meshInstance == NULL)
         return;
 
+    // Without a renderer there are no shaders or textures to attach
+    if (GameProject::Singleton().IsHeadless())
+        return;
+
     if (deserializer->PushScope("Material"))
     {
         // Get material component
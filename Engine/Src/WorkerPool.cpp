@@ -0,0 +1,118 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool()
+    : m_job(NULL), m_count(0), m_threadCount(1), m_generation(0), m_workersBusy(0), m_shuttingDown(false)
+{}
+
+WorkerPool::~WorkerPool()
+{
+    Shutdown();
+}
+
+void WorkerPool::Startup(unsigned int threadCount)
+{
+    Shutdown();
+
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    m_threadCount = threadCount > 0 ? threadCount : 1;
+    m_shuttingDown = false;
+    m_generation = 0;       // Workers start out expecting the first job
+
+    // The calling thread acts as thread 0, so only spawn the rest
+    for (unsigned int i = 1; i < m_threadCount; i++)
+    {
+        m_threads.push_back(std::thread(&WorkerPool::WorkerMain, this, i));
+    }
+}
+
+void WorkerPool::Shutdown()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_shuttingDown = true;
+    }
+    m_jobPosted.notify_all();
+
+    for (size_t i = 0; i < m_threads.size(); i++)
+    {
+        m_threads[i].join();
+    }
+    m_threads.clear();
+    m_threadCount = 1;
+}
+
+unsigned int WorkerPool::GetThreadCount()
+{
+    return m_threadCount;
+}
+
+void WorkerPool::Run(WorkerJob* job, unsigned int count)
+{
+    if (job == NULL || count == 0)
+        return;
+
+    if (m_threads.empty())
+    {
+        job->Run(0, 0, count);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_job = job;
+        m_count = count;
+        m_workersBusy = m_threads.size();
+        m_generation++;
+    }
+    m_jobPosted.notify_all();
+
+    RunRange(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_workersBusy > 0)
+    {
+        m_jobFinished.wait(lock);
+    }
+    m_job = NULL;
+}
+
+void WorkerPool::WorkerMain(unsigned int threadIndex)
+{
+    unsigned int lastGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_shuttingDown && m_generation == lastGeneration)
+            {
+                m_jobPosted.wait(lock);
+            }
+            if (m_shuttingDown)
+                return;
+
+            lastGeneration = m_generation;
+        }
+
+        RunRange(threadIndex);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workersBusy--;
+        if (m_workersBusy == 0)
+        {
+            m_jobFinished.notify_one();
+        }
+    }
+}
+
+void WorkerPool::RunRange(unsigned int threadIndex)
+{
+    unsigned int begin = (unsigned int)(((unsigned long long)m_count * threadIndex) / m_threadCount);
+    unsigned int end = (unsigned int)(((unsigned long long)m_count * (threadIndex + 1)) / m_threadCount);
+    if (begin < end)
+    {
+        m_job->Run(threadIndex, begin, end);
+    }
+}
\ No newline at end of file
@@ -8,6 +8,7 @@
 void Roller::OnCreate()
 {
     printf("\t\tRoller OnCreate\n");
+    ListenForCollisions(COLLISION_EVENT_ALL);
 }
 
 void Roller::OnStart()
@@ -77,17 +78,17 @@ void Roller::Update(float deltaTime)
     }
 }
 
-void Roller::OnCollisionEnter()
+void Roller::OnCollisionEnter(const Collision& collision)
 {
     printf("\t\tRoller: collision enter\n");
 }
 
-void Roller::OnCollisionExit()
+void Roller::OnCollisionExit(const Collision& collision)
 {
     printf("\t\tRoller: collision exit\n");
 }
 
-void Roller::OnCollisionHold()
+void Roller::OnCollisionHold(const Collision& collision)
 {
     printf("\t\tRoller: collision hold\n");
 }
\ No newline at end of file
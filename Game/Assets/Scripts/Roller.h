@@ -19,7 +19,7 @@ public:
     void OnStart();
     void Update(float deltaTime);
 
-    void OnCollisionEnter();
-    void OnCollisionExit();
-    void OnCollisionHold();
+    void OnCollisionEnter(const Collision& collision);
+    void OnCollisionExit(const Collision& collision);
+    void OnCollisionHold(const Collision& collision);
 };
\ No newline at end of file
@@ -1,17 +1,132 @@
 // main.cpp : Defines the entry point for the console application.
 //
+// Usage: Game.exe [--headless] [--frames N] [--project path] [--scene path] [--output path]
+// With --headless, the scene is stepped for N frames without a window and a JSON report is written. Without
+// --output, the report goes to stdout and the log goes to stderr instead, so that stdout can be parsed as JSON.
+// With --physics-stats path, every physics step's counters and timings are appended to the file, as JSON lines
+// if the path ends in .json and as CSV otherwise.
+//        Game.exe --raycast-benchmark [--output path]
+// Times the batched ray queries against the scalar ones and writes a JSON report, without loading a project.
 
 #include "Game.h"
 #include "GameComponentFactory.h"
 #include "Generated\GameComponentBindings.h"
+#include "Math\RaycastBenchmark.h"
+#include "Physics\PhysicsProfiler.h"
 #include "Scene\Scene.h"
 
-int main(void)
+#include <io.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char** argv)
 {
+    bool headless = false;
+    bool raycastBenchmark = false;
+    int frameCount = 600;
+    string projectPath = "Katamari.xml";
+    string scenePath = "Assets\\Scenes\\PhysicsTest3.xml";      // TODO startup scene should be specified in the project file
+    string outputPath = "";
+    string physicsStatsPath = "";
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--headless") == 0)
+        {
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--raycast-benchmark") == 0)
+        {
+            raycastBenchmark = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue)
+        {
+            frameCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--project") == 0 && hasValue)
+        {
+            projectPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--scene") == 0 && hasValue)
+        {
+            scenePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--output") == 0 && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--physics-stats") == 0 && hasValue)
+        {
+            physicsStatsPath = argv[++i];
+        }
+        else
+        {
+            printf("Unknown argument: %s\n", argv[i]);
+        }
+    }
+
+    if (raycastBenchmark)
+    {
+        FILE* output = outputPath.compare("") != 0 ? fopen(outputPath.c_str(), "w") : stdout;
+        if (output == NULL)
+        {
+            printf("Error: could not open %s for writing, using stdout instead.\n", outputPath.c_str());
+            output = stdout;
+        }
+        RaycastBenchmark::Run(1024, 256, 20, output);
+        if (output != stdout)
+            fclose(output);
+        return EXIT_SUCCESS;
+    }
+
+    // Open the headless report before anything is logged
+    FILE* report = NULL;
+    if (headless)
+    {
+        if (outputPath.compare("") != 0)
+        {
+            report = fopen(outputPath.c_str(), "w");
+            if (report == NULL)
+            {
+                printf("Error: could not open %s for writing.\n", outputPath.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            // Keep a handle to the real stdout for the report, and point stdout at stderr for the log
+            fflush(stdout);
+            report = _fdopen(_dup(_fileno(stdout)), "w");
+            _dup2(_fileno(stderr), _fileno(stdout));
+        }
+    }
+
     GameComponentFactory* factory = new MyFactory();
-    Game::Singleton().Init("Katamari.xml", factory);
+    Game::Singleton().Init(projectPath, factory, headless);
+
+    Scene* scene = Scene::Load(scenePath);
+    if (scene == NULL)
+    {
+        printf("Could not load scene %s\n", scenePath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    if (physicsStatsPath.compare("") != 0)
+    {
+        size_t extension = physicsStatsPath.rfind(".json");
+        bool json = extension != string::npos && extension + 5 == physicsStatsPath.size();
+        PhysicsProfiler::Singleton().StartDump(physicsStatsPath, json ? PhysicsProfiler::DUMP_JSON : PhysicsProfiler::DUMP_CSV);
+    }
 
-    // TODO startup scene should be specified in the project file
-    Scene* scene = Scene::Load("Assets\\Scenes\\PhysicsTest3.xml");
-    Game::Singleton().Run(scene);
+    if (headless)
+    {
+        Game::Singleton().RunHeadless(scene, frameCount, report);
+        fclose(report);
+        return EXIT_SUCCESS;
+    }
+    else
+    {
+        Game::Singleton().Run(scene);
+    }
 }
\ No newline at end of file